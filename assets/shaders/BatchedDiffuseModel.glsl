@@ -0,0 +1,75 @@
+#ShaderSegment:vertex
+#version 420 core
+
+layout (location = 0) in vec3 ia_Pos;
+layout (location = 1) in vec3 ia_Normal;
+layout (location = 2) in vec2 ia_TexCoords;
+
+// The draw's base instance, i.e the index of the model's entry in u_DrawData (see BatchRenderer)
+layout (location = 3) in uint ia_DrawID;
+
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
+
+// 8 texels per draw: the position transform (4), the normal matrix (3, xyz) and the color (1)
+uniform samplerBuffer u_DrawData;
+
+out vec3 fragNormal;
+out vec2 texCoords;
+flat out vec3 fragColor;
+
+void main()
+{
+    int base = int(ia_DrawID) * 8;
+
+    mat4 transform = mat4(texelFetch(u_DrawData, base + 0),
+                          texelFetch(u_DrawData, base + 1),
+                          texelFetch(u_DrawData, base + 2),
+                          texelFetch(u_DrawData, base + 3));
+
+    mat3 normalMatrix = mat3(texelFetch(u_DrawData, base + 4).xyz,
+                             texelFetch(u_DrawData, base + 5).xyz,
+                             texelFetch(u_DrawData, base + 6).xyz);
+
+    gl_Position = u_Frame.ProjectionView * transform * vec4(ia_Pos, 1.0);
+
+    fragNormal = normalize(normalMatrix * ia_Normal);
+    texCoords = ia_TexCoords;
+    fragColor = texelFetch(u_DrawData, base + 7).rgb;
+}
+
+#ShaderSegment:fragment
+#version 420 core
+
+const float AMBIENT_LIGHT = 0.55;
+
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
+
+in vec3 fragNormal;
+in vec2 texCoords;
+flat in vec3 fragColor;
+
+out vec4 fout_FragColor;
+
+void main()
+{
+    float lightIntensity = AMBIENT_LIGHT + max(0, dot(normalize(fragNormal), u_Frame.DirectionToLight.xyz)) * 0.5;
+    fout_FragColor = vec4(fragColor * lightIntensity, 1.0);
+}
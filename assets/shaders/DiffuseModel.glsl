@@ -1,3 +1,6 @@
+// TEXTURED: samples u_Texture instead of using the object's color (see ShaderVariants)
+#ShaderKeywords: TEXTURED
+
 #ShaderSegment:vertex
 #version 420 core
 
@@ -5,18 +8,33 @@ layout (location = 0) in vec3 ia_Pos;
 layout (location = 1) in vec3 ia_Normal;
 layout (location = 2) in vec2 ia_TexCoords;
 
-uniform mat4 u_Transform;
-uniform mat4 u_Model;
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
+
+// Set per draw (see ShaderConstants)
+layout (std140, binding = 1) uniform ObjectConstants
+{
+    mat4 PositionTransform;
+    mat4 NormalMatrix;
+    vec4 Color;
+} u_Object;
 
 out vec3 fragNormal;
 out vec2 texCoords;
 
 void main()
 {   
-    gl_Position = u_Transform * vec4(ia_Pos, 1.0);
+    gl_Position = u_Frame.ProjectionView * u_Object.PositionTransform * vec4(ia_Pos, 1.0);
 
-    // FIXME: will not work if u_Model contains non-uniform scaling
-    vec3 worldNormal = normalize(mat3(u_Model) * ia_Normal);
+    vec3 worldNormal = normalize(mat3(u_Object.NormalMatrix) * ia_Normal);
     fragNormal = worldNormal;
     texCoords = ia_TexCoords;
 }
@@ -27,14 +45,29 @@ void main()
 // const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, 1.5, -1.0));
 const float AMBIENT_LIGHT = 0.55;
 
-uniform vec3 u_Color;
-uniform vec3 u_DirectionToLight;
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
+
+// Set per draw (see ShaderConstants)
+layout (std140, binding = 1) uniform ObjectConstants
+{
+    mat4 PositionTransform;
+    mat4 NormalMatrix;
+    vec4 Color;
+} u_Object;
 
-// Whether to sample from texture or use solid color.
-//
-// An int is used here because of shaky support of bool in various OpenGL drivers
-uniform int u_ShouldSampleTexture;
-uniform sampler2D u_Texture;
+#ifdef TEXTURED
+// Slot 0
+layout (binding = 0) uniform sampler2D u_Texture;
+#endif
 
 in vec3 fragNormal;
 in vec2 texCoords;
@@ -43,13 +76,13 @@ out vec4 fout_FragColor;
 
 void main()
 {   
-    float lightIntensity = AMBIENT_LIGHT + max(0, dot(normalize(fragNormal), u_DirectionToLight)) * 0.5;
-    vec3 fragSampleColor;
-
-    if (u_ShouldSampleTexture == 1) 
-        fragSampleColor = texture(u_Texture, texCoords).xyz;
-    else
-        fragSampleColor = u_Color * lightIntensity;
-        
+    float lightIntensity = AMBIENT_LIGHT + max(0, dot(normalize(fragNormal), u_Frame.DirectionToLight.xyz)) * 0.5;
+
+#ifdef TEXTURED
+    vec3 fragSampleColor = texture(u_Texture, texCoords).xyz;
+#else
+    vec3 fragSampleColor = u_Object.Color.rgb * lightIntensity;
+#endif
+
     fout_FragColor = vec4(fragSampleColor, 1.0);
 }
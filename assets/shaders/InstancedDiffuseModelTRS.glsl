@@ -0,0 +1,77 @@
+#ShaderSegment:vertex
+#version 420 core
+
+layout (location = 0) in vec3 ia_Pos;
+layout (location = 1) in vec3 ia_Normal;
+layout (location = 2) in vec2 ia_TexCoords;
+
+// Per instance (TRSInstance)
+layout (location = 4) in vec4 ia_InstanceTranslationScale;
+layout (location = 5) in vec4 ia_InstanceRotation;
+layout (location = 6) in vec4 ia_InstanceColor;
+
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
+
+// The model's dequantization, applied to the positions before the instance transform
+uniform mat4 u_Dequantize;
+
+out vec3 fragNormal;
+out vec2 texCoords;
+flat out vec3 fragColor;
+
+// Rotates `v` by the unit quaternion `q`
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    vec3 position = (u_Dequantize * vec4(ia_Pos, 1.0)).xyz;
+    vec3 worldPosition = rotate(ia_InstanceRotation, position * ia_InstanceTranslationScale.w) +
+                         ia_InstanceTranslationScale.xyz;
+
+    gl_Position = u_Frame.ProjectionView * vec4(worldPosition, 1.0);
+
+    // The scale is uniform, so the rotation alone takes care of the normals
+    fragNormal = rotate(ia_InstanceRotation, ia_Normal);
+    texCoords = ia_TexCoords;
+    fragColor = ia_InstanceColor.rgb;
+}
+
+#ShaderSegment:fragment
+#version 420 core
+
+const float AMBIENT_LIGHT = 0.55;
+
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
+
+in vec3 fragNormal;
+in vec2 texCoords;
+flat in vec3 fragColor;
+
+out vec4 fout_FragColor;
+
+void main()
+{
+    float lightIntensity = AMBIENT_LIGHT + max(0, dot(normalize(fragNormal), u_Frame.DirectionToLight.xyz)) * 0.5;
+    fout_FragColor = vec4(fragColor * lightIntensity, 1.0);
+}
@@ -4,14 +4,30 @@
 layout (location = 0) in vec3 ia_Pos;
 layout (location = 1) in vec3 ia_Normal;
 
-uniform mat4 u_ProjectionView;
-uniform mat4 u_Model;
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
+
+// Set per draw (see ShaderConstants)
+layout (std140, binding = 1) uniform ObjectConstants
+{
+    mat4 PositionTransform;
+    mat4 NormalMatrix;
+    vec4 Color;
+} u_Object;
 
 out vec3 o_Normal;
 
 void main()
 {
-    gl_Position = u_ProjectionView * u_Model * vec4(ia_Pos, 1.0);
+    gl_Position = u_Frame.ProjectionView * u_Object.PositionTransform * vec4(ia_Pos, 1.0);
     o_Normal = ia_Normal;
 }
 
@@ -23,9 +39,15 @@ in vec3 o_Normal;
 
 out vec4 FragColor;
 
-uniform vec3 u_Color;
+// Set per draw (see ShaderConstants)
+layout (std140, binding = 1) uniform ObjectConstants
+{
+    mat4 PositionTransform;
+    mat4 NormalMatrix;
+    vec4 Color;
+} u_Object;
 
 void main()
 {   
-    FragColor = vec4(u_Color + normalize(o_Normal) * 0.8, 1.0);
+    FragColor = vec4(u_Object.Color.rgb + normalize(o_Normal) * 0.8, 1.0);
 }
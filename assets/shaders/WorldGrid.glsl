@@ -3,7 +3,16 @@
 
 layout (location = 0) in float _trigger;
 
-uniform mat4 u_ProjectionView;
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
 
 vec2 gridPlane[6] = vec2[](
     vec2(-1, -1), vec2(-1,  1), vec2( 1,  1),
@@ -17,10 +26,8 @@ void main()
 {   
     vec2 p = gridPlane[gl_VertexID];
 
-    mat4 invProjView = inverse(u_ProjectionView);
-    
-    vec4 unprojectedNear = invProjView * vec4(p.xy, -1.0, 1.0);
-    vec4 unprojectedFar  = invProjView * vec4(p.xy, +1.0, 1.0);
+    vec4 unprojectedNear = u_Frame.InverseProjectionView * vec4(p.xy, -1.0, 1.0);
+    vec4 unprojectedFar  = u_Frame.InverseProjectionView * vec4(p.xy, +1.0, 1.0);
 
     fragNearPoint = unprojectedNear.xyz / unprojectedNear.w;
     fragFarPoint = unprojectedFar.xyz / unprojectedFar.w;
@@ -36,10 +43,16 @@ precision highp float;
 in vec3 fragNearPoint;
 in vec3  fragFarPoint;
 
-uniform mat4 u_ProjectionView;
-
-uniform float u_CamNear;
-uniform float u_CamFar;
+// Set once per frame (see ShaderConstants)
+layout (std140, binding = 0) uniform FrameConstants
+{
+    mat4 ProjectionView;
+    mat4 InverseProjectionView;
+    vec4 CameraPosition;
+    vec4 DirectionToLight;
+    float NearPlane;
+    float FarPlane;
+} u_Frame;
 
 out vec4 fragColor;
 
@@ -61,17 +74,19 @@ vec4 GridColor(vec3 fragPos3D, float scale, bool drawAxis) {
 }
 
 float CalculateFragDepth(vec3 pos) {
-    vec4 clipSpacePosition = u_ProjectionView * vec4(pos.xyz, 1.0);
+    vec4 clipSpacePosition = u_Frame.ProjectionView * vec4(pos.xyz, 1.0);
     return clipSpacePosition.z / clipSpacePosition.w;
 }
 
 float ComputeLinearDepth(vec3 pos) {
-    vec4 clipSpacePosition = u_ProjectionView * vec4(pos.xyz, 1.0);
+    vec4 clipSpacePosition = u_Frame.ProjectionView * vec4(pos.xyz, 1.0);
     float depth = clipSpacePosition.z / clipSpacePosition.w;
 
     // get linear value between 0.01 and 100
-    float linearDepth = (2.0 * u_CamNear * u_CamFar) / (u_CamFar + u_CamNear - depth * (u_CamFar - u_CamNear)); 
-    return linearDepth / u_CamFar; // normalize
+    float camNear = u_Frame.NearPlane;
+    float camFar = u_Frame.FarPlane;
+    float linearDepth = (2.0 * camNear * camFar) / (camFar + camNear - depth * (camFar - camNear)); 
+    return linearDepth / camFar; // normalize
 }
 
 
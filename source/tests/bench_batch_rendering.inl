@@ -0,0 +1,196 @@
+#pragma once
+
+#include "tests/bench_overdraw.inl"
+#include "tile/BatchRenderer.h"
+#include "tile/GeometryPool.h"
+#include "tile/Model.h"
+#include "tile/Shader.h"
+#include "tile/ShaderConstants.h"
+#include "tile/Window.h"
+#include "tile/gl_extensions.h"
+#include "tile/opengl_inc.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    struct BatchBenchObject
+    {
+        const Model* Mesh;
+        glm::mat4 Transform;
+        glm::vec3 Color;
+    };
+
+    struct BatchBenchTimes
+    {
+        // Recording the frame's commands on the CPU, the GPU executing them, and both until glFinish() returns
+        double SubmitMs = 0.0;
+        double GpuMs = 0.0;
+        double FrameMs = 0.0;
+    };
+
+    template <typename DrawScene>
+    BatchBenchTimes measure_scene_frames(DrawScene&& drawScene)
+    {
+        constexpr int FRAMES = 60;
+
+        gl::GLuint query;
+        gl::glGenQueries(1, &query);
+
+        BatchBenchTimes times;
+        for (int frame = 0; frame < FRAMES; frame++)
+        {
+            gl::glClear(gl::GL_COLOR_BUFFER_BIT | gl::GL_DEPTH_BUFFER_BIT);
+            gl::glFinish();
+
+            auto start = std::chrono::steady_clock::now();
+            gl::glBeginQuery(gl::GL_TIME_ELAPSED, query);
+
+            drawScene();
+
+            gl::glEndQuery(gl::GL_TIME_ELAPSED);
+            auto submitted = std::chrono::steady_clock::now();
+
+            gl::glFinish();
+            auto finished = std::chrono::steady_clock::now();
+
+            gl::GLuint64 elapsed = 0;
+            gl::glGetQueryObjectui64v(query, gl::GL_QUERY_RESULT, &elapsed);
+
+            // The first frame pays for uploads and shader warm up
+            if (frame > 0)
+            {
+                times.SubmitMs += std::chrono::duration<double, std::milli>(submitted - start).count();
+                times.GpuMs += elapsed / 1e6;
+                times.FrameMs += std::chrono::duration<double, std::milli>(finished - start).count();
+            }
+        }
+
+        gl::glDeleteQueries(1, &query);
+
+        times.SubmitMs /= FRAMES - 1;
+        times.GpuMs /= FRAMES - 1;
+        times.FrameMs /= FRAMES - 1;
+        return times;
+    }
+
+    void report_batch_bench_times(const char* name, const BatchBenchTimes& times, size_t drawCalls)
+    {
+        std::cout << "    " << name << ": " << drawCalls << " draw calls, submit " << times.SubmitMs << " ms, GPU "
+                  << times.GpuMs << " ms, frame " << times.FrameMs << " ms" << std::endl;
+    }
+}
+
+void bench_batch_rendering_main()
+{
+    // Small and hidden, so that the frame time is all about submitting the objects
+    CreateWindowProps props { 256, 256, "Batch Rendering Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        auto pool = std::make_shared<GeometryPool>();
+
+        ModelBuilder builder;
+        builder.SetGeometryPool(pool);
+        builder.SetVertexQuantization(true);
+
+        std::string blobPath = write_synthetic_blob_obj(8);
+        std::shared_ptr<Model> meshes[3] = {
+            builder.LoadWavefrontObj("assets/models/cube.obj"),
+            builder.LoadWavefrontObj("assets/models/cube_quads.obj"),
+            builder.LoadWavefrontObj(blobPath)
+        };
+        std::filesystem::remove(blobPath);
+
+        for (const std::shared_ptr<Model>& mesh : meshes)
+        {
+            if (!mesh)
+                return;
+        }
+
+        // 100 x 100 objects
+        constexpr int GRID_SIZE = 100;
+
+        std::vector<BatchBenchObject> objects;
+        objects.reserve(GRID_SIZE * GRID_SIZE);
+
+        for (int x = 0; x < GRID_SIZE; x++)
+        {
+            for (int z = 0; z < GRID_SIZE; z++)
+            {
+                glm::vec3 position(1.5f * (x - GRID_SIZE / 2), 0.f, 1.5f * (z - GRID_SIZE / 2));
+                glm::mat4 transform = glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(0.5f));
+                glm::vec3 color(static_cast<float>(x) / GRID_SIZE, 0.5f, static_cast<float>(z) / GRID_SIZE);
+
+                objects.push_back({ meshes[(7 * x + z) % 3].get(), transform, color });
+            }
+        }
+
+        glm::vec3 viewPosition(0.f, 80.f, 90.f);
+        glm::mat4 projectionView = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 500.f) *
+                                   glm::lookAt(viewPosition, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+        FrameConstants frame = MakeFrameConstants(projectionView, viewPosition, 0.1f, 500.f,
+                                                  glm::normalize(glm::vec3(1.f, 1.5f, -1.f)));
+        ShaderConstants constants(objects.size());
+
+        gl::glEnable(gl::GL_DEPTH_TEST);
+        gl::glEnable(gl::GL_CULL_FACE);
+        gl::glCullFace(gl::GL_BACK);
+        gl::glFrontFace(gl::GL_CCW);
+
+        auto diffuseShader = Shader::LoadFromFile("assets/shaders/DiffuseModel.glsl", "Diffuse Shader");
+
+        auto batchedShader = Shader::LoadFromFile("assets/shaders/BatchedDiffuseModel.glsl", "Batched Diffuse Shader");
+
+        std::cout << objects.size() << " objects, glMultiDrawElementsIndirect "
+                  << (GetGlExtensions().MultiDrawIndirect ? "available" : "unavailable") << std::endl;
+
+        // What Application does for its model, once per object
+        size_t perObjectDrawCalls = 0;
+        for (const BatchBenchObject& object : objects)
+            perObjectDrawCalls += object.Mesh->GetIndexChunks().size();
+
+        BatchBenchTimes perObject = measure_scene_frames([&]() {
+            constants.BeginFrame(frame);
+            diffuseShader->Bind();
+
+            for (const BatchBenchObject& object : objects)
+            {
+                constants.SetObject(MakeObjectConstants(object.Transform, object.Mesh->GetDequantizeTransform(),
+                                                        object.Color));
+                object.Mesh->Draw();
+            }
+
+            constants.EndFrame();
+        });
+
+        report_batch_bench_times("per object", perObject, perObjectDrawCalls);
+
+        BatchRenderer renderer;
+        BatchBenchTimes batched = measure_scene_frames([&]() {
+            constants.BeginFrame(frame);
+            renderer.Begin();
+
+            for (const BatchBenchObject& object : objects)
+                renderer.Submit(*object.Mesh, object.Transform, object.Color);
+
+            renderer.Flush(*batchedShader);
+            constants.EndFrame();
+        });
+
+        report_batch_bench_times("multi draw indirect", batched, renderer.GetDrawCallCount());
+    }
+
+    window.Close();
+}
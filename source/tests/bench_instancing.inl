@@ -0,0 +1,132 @@
+#pragma once
+
+#include "tests/bench_batch_rendering.inl"
+#include "tile/GeometryPool.h"
+#include "tile/Instancing.h"
+#include "tile/Model.h"
+#include "tile/Shader.h"
+#include "tile/ShaderConstants.h"
+#include "tile/Window.h"
+#include "tile/opengl_inc.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Tile;
+
+void bench_instancing_main()
+{
+    // Small and hidden, so that the frame time is all about submitting the instances
+    CreateWindowProps props { 256, 256, "Instancing Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        ModelBuilder builder;
+        builder.SetGeometryPool(std::make_shared<GeometryPool>());
+        builder.SetVertexQuantization(true);
+
+        std::shared_ptr<Model> mesh = builder.LoadWavefrontObj("assets/models/cube_quads.obj");
+        if (!mesh)
+            return;
+
+        constexpr int INSTANCE_COUNT = 100000;
+        constexpr int ROW_LENGTH = 320;
+
+        std::vector<MatrixInstance> matrixInstances(INSTANCE_COUNT);
+        std::vector<TRSInstance> trsInstances(INSTANCE_COUNT);
+
+        for (int i = 0; i < INSTANCE_COUNT; i++)
+        {
+            glm::vec3 position(1.5f * (i % ROW_LENGTH - ROW_LENGTH / 2), 0.f, 1.5f * (i / ROW_LENGTH - ROW_LENGTH / 2));
+            float angle = 0.1f * i;
+            glm::vec4 color(static_cast<float>(i % ROW_LENGTH) / ROW_LENGTH, 0.5f, 0.25f, 1.f);
+
+            glm::mat4 transform = glm::translate(glm::mat4(1.f), position);
+            transform = glm::rotate(transform, angle, glm::vec3(0.f, 1.f, 0.f));
+            transform = glm::scale(transform, glm::vec3(0.5f));
+
+            matrixInstances[i] = { transform, color };
+            trsInstances[i] = { position, 0.5f, glm::vec4(0.f, std::sin(angle / 2.f), 0.f, std::cos(angle / 2.f)),
+                                PackColorRGBA8(color) };
+        }
+
+        glm::vec3 viewPosition(0.f, 250.f, 300.f);
+        glm::mat4 projectionView = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 1000.f) *
+                                   glm::lookAt(viewPosition, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+        FrameConstants frame = MakeFrameConstants(projectionView, viewPosition, 0.1f, 1000.f,
+                                                  glm::normalize(glm::vec3(1.f, 1.5f, -1.f)));
+        ShaderConstants constants(INSTANCE_COUNT);
+
+        gl::glEnable(gl::GL_DEPTH_TEST);
+        gl::glEnable(gl::GL_CULL_FACE);
+        gl::glCullFace(gl::GL_BACK);
+        gl::glFrontFace(gl::GL_CCW);
+
+        auto diffuseShader = Shader::LoadFromFile("assets/shaders/DiffuseModel.glsl", "Diffuse Shader");
+
+        std::shared_ptr<Shader> instancedShaders[2] = {
+            Shader::LoadFromFile("assets/shaders/InstancedDiffuseModel.glsl", "Instanced Diffuse Shader"),
+            Shader::LoadFromFile("assets/shaders/InstancedDiffuseModelTRS.glsl", "Instanced TRS Diffuse Shader")
+        };
+
+        for (const std::shared_ptr<Shader>& shader : instancedShaders)
+        {
+            shader->Bind();
+            shader->SetUniformMat4("u_Dequantize", mesh->GetDequantizeTransform());
+        }
+
+        std::cout << INSTANCE_COUNT << " instances of a " << mesh->GetIndexCount() / 3 << " triangle mesh" << std::endl;
+
+        BatchBenchTimes individual = measure_scene_frames([&]() {
+            constants.BeginFrame(frame);
+            diffuseShader->Bind();
+
+            for (const MatrixInstance& instance : matrixInstances)
+            {
+                constants.SetObject(MakeObjectConstants(instance.Transform, mesh->GetDequantizeTransform(),
+                                                        glm::vec3(instance.Color)));
+                mesh->Draw();
+            }
+
+            constants.EndFrame();
+        });
+
+        report_batch_bench_times("individual draws", individual, INSTANCE_COUNT * mesh->GetIndexChunks().size());
+
+        // The instances are uploaded every frame, as they would be if they moved
+        InstanceBuffer matrixBuffer(InstanceFormat::Matrix);
+        BatchBenchTimes matrix = measure_scene_frames([&]() {
+            constants.BeginFrame(frame);
+            matrixBuffer.SetInstances(matrixInstances.data(), matrixInstances.size());
+
+            instancedShaders[0]->Bind();
+            mesh->DrawInstanced(matrixBuffer);
+            constants.EndFrame();
+        });
+
+        report_batch_bench_times("instanced, matrices", matrix, mesh->GetIndexChunks().size());
+
+        InstanceBuffer trsBuffer(InstanceFormat::TRS);
+        BatchBenchTimes trs = measure_scene_frames([&]() {
+            constants.BeginFrame(frame);
+            trsBuffer.SetInstances(trsInstances.data(), trsInstances.size());
+
+            instancedShaders[1]->Bind();
+            mesh->DrawInstanced(trsBuffer);
+            constants.EndFrame();
+        });
+
+        report_batch_bench_times("instanced, TRS", trs, mesh->GetIndexChunks().size());
+
+        std::cout << "    instance data per frame: matrices " << sizeof(MatrixInstance) * INSTANCE_COUNT / 1024
+                  << " KiB, TRS " << sizeof(TRSInstance) * INSTANCE_COUNT / 1024 << " KiB" << std::endl;
+    }
+
+    window.Close();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "tests/bench_obj_loading.inl"
+#include "tile/MeshCache.h"
+#include "tile/Model.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+using namespace Tile;
+
+namespace
+{
+    template <typename Func>
+    double best_time_ms(int runs, Func&& func)
+    {
+        double best = -1.0;
+        for (int run = 0; run < runs; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            auto end = std::chrono::steady_clock::now();
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            if (best < 0.0 || elapsed < best)
+                best = elapsed;
+        }
+
+        return best;
+    }
+
+    // Cold: parse + triangulate + convert + deduplicate, then write the cache entry.
+    // Warm: map the cache entry and read every byte of it once (which is what the upload does)
+    void bench_cache_file(const std::string& filepath, const std::string& cacheDirectory)
+    {
+        std::cout << filepath << std::endl;
+
+        ModelBuilder builder;
+        MeshCache cache(cacheDirectory);
+        MeshCacheKey key = {
+            filepath, "",
+            { { AxisLine::LINE_X, +1 }, { AxisLine::LINE_Y, -1 }, { AxisLine::LINE_Z, -1 } },
+            { { AxisLine::LINE_X, +1 }, { AxisLine::LINE_Y, +1 }, { AxisLine::LINE_Z, -1 } },
+            false,
+            0.f,
+        };
+
+        double buildMs = best_time_ms(3, [&]() { builder.BuildWavefrontObj(filepath, ""); });
+        double storeMs = best_time_ms(3, [&]() { cache.Store(key, builder.GetVertices(), builder.GetIndices()); });
+
+        volatile uint32_t sink = 0;
+        double warmMs = best_time_ms(3, [&]() {
+            auto cached = cache.Load(key);
+            if (!cached)
+                return;
+
+            uint32_t sum = 0;
+            const uint32_t* words = reinterpret_cast<const uint32_t*>(cached->GetVertices());
+            for (size_t i = 0; i < cached->GetVertexCount() * sizeof(Vertex) / sizeof(uint32_t); i++)
+                sum += words[i];
+            for (size_t i = 0; i < cached->GetIndexCount(); i++)
+                sum += cached->GetIndices()[i];
+            sink = sink + sum;
+        });
+
+        auto cached = cache.Load(key);
+        bool identical =
+            cached &&
+            cached->GetVertexCount() == builder.GetVertices().size() &&
+            cached->GetIndexCount() == builder.GetIndices().size() &&
+            std::memcmp(cached->GetVertices(), builder.GetVertices().data(), sizeof(Vertex) * cached->GetVertexCount()) == 0 &&
+            std::memcmp(cached->GetIndices(), builder.GetIndices().data(), sizeof(uint32_t) * cached->GetIndexCount()) == 0;
+
+        std::cout << "    cold (build): " << buildMs << " ms, writing the entry: " << storeMs << " ms\n"
+                  << "    warm (cache hit): " << warmMs << " ms\n"
+                  << "    cached copy identical: " << (identical ? "yes" : "NO") << std::endl;
+    }
+}
+
+void bench_mesh_cache_main()
+{
+    std::string cacheDirectory = (std::filesystem::temp_directory_path() / "tile_mesh_cache_bench").string();
+
+    bench_cache_file("assets/models/smooth_vase.obj", cacheDirectory);
+
+    std::string syntheticPath = write_synthetic_grid_obj(1500);
+    bench_cache_file(syntheticPath, cacheDirectory);
+    std::filesystem::remove(syntheticPath);
+
+    std::filesystem::remove_all(cacheDirectory);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "tests/bench_obj_loading.inl"
+#include "tile/MeshOptimizer.h"
+#include "tile/Model.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    // Every triangle rotated so that its smallest index comes first (which keeps its winding), then sorted
+    std::vector<std::array<uint32_t, 3>> canonical_triangles(const std::vector<uint32_t>& indices)
+    {
+        std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            std::array<uint32_t, 3> triangle = { indices[3 * i], indices[3 * i + 1], indices[3 * i + 2] };
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles[i] = triangle;
+        }
+
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void bench_optimize(const char* name, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+    {
+        std::vector<Vertex> optimizedVertices = vertices;
+        std::vector<uint32_t> optimizedIndices = indices;
+
+        auto start = std::chrono::steady_clock::now();
+        OptimizeVertexCache(optimizedIndices, optimizedVertices.size());
+        auto middle = std::chrono::steady_clock::now();
+
+        // The triangles must only have been reordered
+        bool valid = canonical_triangles(indices) == canonical_triangles(optimizedIndices);
+        std::vector<uint32_t> reorderedIndices = optimizedIndices;
+
+        auto fetchStart = std::chrono::steady_clock::now();
+        OptimizeVertexFetch(optimizedVertices, optimizedIndices);
+        auto end = std::chrono::steady_clock::now();
+
+        // ...and the vertices only moved around
+        for (size_t i = 0; valid && i < optimizedIndices.size(); i++)
+            valid = optimizedVertices[optimizedIndices[i]] == vertices[reorderedIndices[i]];
+
+        VertexCacheStats before = AnalyzeVertexCache(indices, vertices.size());
+        VertexCacheStats after = AnalyzeVertexCache(optimizedIndices, optimizedVertices.size());
+
+        std::cout << "    " << name << ": ACMR " << before.ACMR << " -> " << after.ACMR
+                  << ", ATVR " << before.ATVR << " -> " << after.ATVR << "\n"
+                  << "        vertex cache: " << std::chrono::duration<double, std::milli>(middle - start).count()
+                  << " ms, vertex fetch: " << std::chrono::duration<double, std::milli>(end - fetchStart).count()
+                  << " ms, valid: " << (valid ? "yes" : "NO") << std::endl;
+    }
+}
+
+void bench_mesh_optimizer_main()
+{
+    std::string syntheticPath = write_synthetic_grid_obj(500);
+
+    ModelBuilder builder;
+    if (!builder.BuildWavefrontObj(syntheticPath, ""))
+        return;
+
+    const std::vector<Vertex>& vertices = builder.GetVertices();
+    const std::vector<uint32_t>& indices = builder.GetIndices();
+
+    std::cout << syntheticPath << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles"
+              << std::endl;
+
+    // Rows of quads, in order
+    bench_optimize("file order", vertices, indices);
+
+    // Like the triangle soup scanned and decimated meshes tend to come out as
+    std::vector<uint32_t> order(indices.size() / 3);
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = static_cast<uint32_t>(i);
+
+    std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+    std::vector<uint32_t> shuffled;
+    shuffled.reserve(indices.size());
+    for (uint32_t triangle : order)
+        shuffled.insert(shuffled.end(), indices.begin() + 3 * triangle, indices.begin() + 3 * triangle + 3);
+
+    bench_optimize("shuffled triangles", vertices, shuffled);
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "tile/Model.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Tile;
+
+namespace
+{
+    // Writes a flat (size x size) grid of quads, with normals and texture coordinates, to a temporary file
+    std::string write_synthetic_grid_obj(int size)
+    {
+        std::string filepath = (std::filesystem::temp_directory_path() / "tile_synthetic_grid.obj").string();
+        std::ofstream file(filepath);
+
+        int rowLength = size + 1;
+
+        for (int z = 0; z <= size; z++)
+            for (int x = 0; x <= size; x++)
+                file << "v " << (float)x / size << " 0.0 " << (float)z / size << "\n";
+
+        for (int z = 0; z <= size; z++)
+            for (int x = 0; x <= size; x++)
+                file << "vt " << (float)x / size << " " << (float)z / size << "\n";
+
+        file << "vn 0.0 1.0 0.0\n";
+
+        for (int z = 0; z < size; z++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                int a = z * rowLength + x + 1;
+                int b = a + 1;
+                int c = a + rowLength + 1;
+                int d = a + rowLength;
+
+                file << "f " << a << "/" << a << "/1 "
+                             << b << "/" << b << "/1 "
+                             << c << "/" << c << "/1 "
+                             << d << "/" << d << "/1\n";
+            }
+        }
+
+        return filepath;
+    }
+
+    struct LoaderConfig
+    {
+        const char* Name;
+        ObjParseMode Mode;
+        bool MemoryMapping;
+        bool IndexTripleDedup;
+    };
+
+    const LoaderConfig LOADER_CONFIGS[] = {
+        { "tinyobj, value dedup",            ObjParseMode::TinyObj,  false, false },
+        { "tinyobj, triple dedup",           ObjParseMode::TinyObj,  false, true  },
+        { "parallel (stream), triple dedup", ObjParseMode::Parallel, false, true  },
+        { "parallel (mmap), value dedup",    ObjParseMode::Parallel, true,  false },
+        { "parallel (mmap), triple dedup",   ObjParseMode::Parallel, true,  true  },
+    };
+
+    struct LoadMeasurement
+    {
+        double Milliseconds;
+        long PeakRssKb;
+    };
+
+    // Loads the file in a forked child so that every loader starts with a clean process and
+    // its peak RSS can be read from the child's resource usage
+    LoadMeasurement measure_load(const LoaderConfig& config, const std::string& filepath)
+    {
+        int pipeFds[2];
+        if (pipe(pipeFds) != 0)
+            return { -1.0, -1 };
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            ModelBuilder builder;
+            builder.SetParseMode(config.Mode);
+            builder.SetMemoryMapping(config.MemoryMapping);
+            builder.SetIndexTripleDedup(config.IndexTripleDedup);
+
+            auto start = std::chrono::steady_clock::now();
+            builder.BuildWavefrontObj(filepath, "");
+            auto end = std::chrono::steady_clock::now();
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            (void)!write(pipeFds[1], &elapsed, sizeof(elapsed));
+            _exit(0);
+        }
+
+        close(pipeFds[1]);
+
+        LoadMeasurement measurement { -1.0, -1 };
+        if (read(pipeFds[0], &measurement.Milliseconds, sizeof(double)) != sizeof(double))
+            measurement.Milliseconds = -1.0;
+        close(pipeFds[0]);
+
+        int status;
+        struct rusage usage;
+        if (wait4(pid, &status, 0, &usage) == pid)
+            measurement.PeakRssKb = usage.ru_maxrss;
+
+        return measurement;
+    }
+
+    void bench_file(const std::string& filepath)
+    {
+        std::cout << filepath << std::endl;
+
+        for (const auto& config : LOADER_CONFIGS)
+        {
+            // Best time of a few runs. RSS does not change between runs
+            LoadMeasurement best = measure_load(config, filepath);
+            for (int run = 1; run < 3; run++)
+            {
+                LoadMeasurement current = measure_load(config, filepath);
+                if (current.Milliseconds < best.Milliseconds)
+                    best = current;
+            }
+
+            std::cout << "    " << config.Name << ": " << best.Milliseconds << " ms, peak RSS "
+                      << best.PeakRssKb / 1024 << " MB" << std::endl;
+        }
+
+        // The reference is the original pipeline: tinyobj, with every corner deduplicated by value
+        ModelBuilder reference;
+        reference.SetParseMode(ObjParseMode::TinyObj);
+        reference.SetIndexTripleDedup(false);
+        reference.BuildWavefrontObj(filepath, "");
+
+        ModelBuilder parallel;
+        parallel.SetParseMode(ObjParseMode::Parallel);
+        parallel.SetIndexTripleDedup(true);
+        parallel.BuildWavefrontObj(filepath, "");
+
+        bool identical =
+            reference.GetVertices().size() == parallel.GetVertices().size() &&
+            reference.GetIndices() == parallel.GetIndices() &&
+            std::memcmp(reference.GetVertices().data(),
+                        parallel.GetVertices().data(),
+                        sizeof(Vertex) * reference.GetVertices().size()) == 0;
+
+        std::cout << "    vertices: " << reference.GetVertices().size()
+                  << ", triangles: " << reference.GetIndices().size() / 3 << "\n"
+                  << "    output identical: " << (identical ? "yes" : "NO") << std::endl;
+    }
+}
+
+void bench_obj_loading_main()
+{
+    bench_file("assets/models/smooth_vase.obj");
+
+    // ~2.25M quads, i.e 4.5M triangles
+    std::string syntheticPath = write_synthetic_grid_obj(1500);
+    bench_file(syntheticPath);
+    std::filesystem::remove(syntheticPath);
+}
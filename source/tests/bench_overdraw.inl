@@ -0,0 +1,298 @@
+#pragma once
+
+#include "tile/MeshOptimizer.h"
+#include "tile/Model.h"
+#include "tile/Shader.h"
+#include "tile/Window.h"
+#include "tile/gl_wrappers.h"
+#include "tile/opengl_inc.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    // A sphere with bumps all over, so that it occludes parts of itself from every direction
+    std::string write_synthetic_blob_obj(int rings)
+    {
+        std::string filepath = (std::filesystem::temp_directory_path() / "tile_synthetic_blob.obj").string();
+        std::ofstream file(filepath);
+
+        const float pi = 3.14159265358979f;
+        int segments = 2 * rings;
+
+        for (int ring = 0; ring <= rings; ring++)
+        {
+            float theta = pi * ring / rings;
+            for (int segment = 0; segment <= segments; segment++)
+            {
+                float phi = 2.f * pi * segment / segments;
+                float radius = 1.f + 0.3f * std::sin(7.f * theta) * std::sin(7.f * phi);
+
+                file << "v " << radius * std::sin(theta) * std::cos(phi) << " " << radius * std::cos(theta) << " "
+                     << radius * std::sin(theta) * std::sin(phi) << "\n";
+
+                // The sphere's normal and a plain spherical mapping, good enough to give every attribute data
+                file << "vn " << std::sin(theta) * std::cos(phi) << " " << std::cos(theta) << " "
+                     << std::sin(theta) * std::sin(phi) << "\n";
+                file << "vt " << static_cast<float>(segment) / segments << " " << static_cast<float>(ring) / rings
+                     << "\n";
+            }
+        }
+
+        int rowLength = segments + 1;
+        for (int ring = 0; ring < rings; ring++)
+        {
+            for (int segment = 0; segment < segments; segment++)
+            {
+                int a = ring * rowLength + segment + 1;
+                int b = a + rowLength;
+
+                // Counter clockwise seen from outside
+                file << "f " << a << "/" << a << "/" << a << " " << a + 1 << "/" << a + 1 << "/" << a + 1 << " "
+                     << b + 1 << "/" << b + 1 << "/" << b + 1 << " " << b << "/" << b << "/" << b << "\n";
+            }
+        }
+
+        return filepath;
+    }
+
+    const char* OVERDRAW_VERTEX_SHADER = R"(
+        #version 420 core
+        layout (location = 0) in vec3 ia_Pos;
+
+        uniform mat4 u_ProjectionView;
+
+        void main()
+        {
+            gl_Position = u_ProjectionView * vec4(ia_Pos, 1.0);
+        }
+    )";
+
+    // A single triangle covering the whole viewport, no vertex buffer needed
+    const char* FULLSCREEN_VERTEX_SHADER = R"(
+        #version 420 core
+
+        void main()
+        {
+            vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+            gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )";
+
+    const char* WHITE_FRAGMENT_SHADER = R"(
+        #version 420 core
+        out vec4 FragColor;
+
+        void main()
+        {
+            FragColor = vec4(1.0);
+        }
+    )";
+
+    // Renders models offscreen from a set of viewpoints spread evenly around them and counts, with occlusion
+    // queries, how many fragments pass the depth test (i.e are shaded) and how many pixels the model covers.
+    // Covered pixels are the ones the model pass left a stencil mark on, counted by a fullscreen pass
+    class OverdrawMeter
+    {
+    public:
+        static constexpr int SIZE = 512;
+        static constexpr int VIEW_COUNT = 32;
+
+        OverdrawMeter()
+        :   m_ModelShader({ { ShaderType::Vertex, OVERDRAW_VERTEX_SHADER },
+                            { ShaderType::Fragment, WHITE_FRAGMENT_SHADER } }, "Overdraw Shader"),
+            m_FullscreenShader({ { ShaderType::Vertex, FULLSCREEN_VERTEX_SHADER },
+                                 { ShaderType::Fragment, WHITE_FRAGMENT_SHADER } }, "Fullscreen Shader")
+        {
+            gl::glGenFramebuffers(1, &m_Framebuffer);
+            gl::glGenRenderbuffers(2, m_Renderbuffers);
+            gl::glGenQueries(2, m_Queries);
+
+            gl::glBindRenderbuffer(gl::GL_RENDERBUFFER, m_Renderbuffers[0]);
+            gl::glRenderbufferStorage(gl::GL_RENDERBUFFER, gl::GL_RGBA8, SIZE, SIZE);
+            gl::glBindRenderbuffer(gl::GL_RENDERBUFFER, m_Renderbuffers[1]);
+            gl::glRenderbufferStorage(gl::GL_RENDERBUFFER, gl::GL_DEPTH24_STENCIL8, SIZE, SIZE);
+
+            gl::glBindFramebuffer(gl::GL_FRAMEBUFFER, m_Framebuffer);
+            gl::glFramebufferRenderbuffer(gl::GL_FRAMEBUFFER, gl::GL_COLOR_ATTACHMENT0, gl::GL_RENDERBUFFER,
+                                          m_Renderbuffers[0]);
+            gl::glFramebufferRenderbuffer(gl::GL_FRAMEBUFFER, gl::GL_DEPTH_STENCIL_ATTACHMENT, gl::GL_RENDERBUFFER,
+                                          m_Renderbuffers[1]);
+
+            if (gl::glCheckFramebufferStatus(gl::GL_FRAMEBUFFER) != gl::GL_FRAMEBUFFER_COMPLETE)
+                std::cerr << "[ERROR] The overdraw framebuffer is incomplete" << std::endl;
+
+            gl::glBindFramebuffer(gl::GL_FRAMEBUFFER, 0);
+        }
+
+        ~OverdrawMeter()
+        {
+            gl::glDeleteQueries(2, m_Queries);
+            gl::glDeleteRenderbuffers(2, m_Renderbuffers);
+            gl::glDeleteFramebuffers(1, &m_Framebuffer);
+        }
+
+        // Shaded fragments per covered pixel, over all the viewpoints. 1 means no overdraw at all
+        double Measure(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+        {
+            Model model;
+            model.CreateVertexBuffer(vertices);
+            model.CreateIndexBuffer(indices);
+
+            glm::vec3 low = vertices[0].position;
+            glm::vec3 high = vertices[0].position;
+            for (const Vertex& vertex : vertices)
+            {
+                low = glm::min(low, vertex.position);
+                high = glm::max(high, vertex.position);
+            }
+
+            glm::vec3 center = (low + high) * 0.5f;
+            float radius = glm::length(high - low) * 0.5f;
+
+            gl::glBindFramebuffer(gl::GL_FRAMEBUFFER, m_Framebuffer);
+            gl::glViewport(0, 0, SIZE, SIZE);
+
+            gl::glEnable(gl::GL_CULL_FACE);
+            gl::glCullFace(gl::GL_BACK);
+            gl::glFrontFace(gl::GL_CCW);
+            gl::glEnable(gl::GL_STENCIL_TEST);
+
+            uint64_t shadedFragments = 0;
+            uint64_t coveredPixels = 0;
+
+            for (int view = 0; view < VIEW_COUNT; view++)
+            {
+                // Fibonacci sphere
+                float y = 1.f - 2.f * (view + 0.5f) / VIEW_COUNT;
+                float ringRadius = std::sqrt(1.f - y * y);
+                float angle = 2.39996323f * view;
+                glm::vec3 direction(ringRadius * std::cos(angle), y, ringRadius * std::sin(angle));
+
+                glm::vec3 up = std::abs(y) > 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+                glm::mat4 viewMatrix = glm::lookAt(center + direction * (2.f * radius), center, up);
+                glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, radius, 3.f * radius);
+
+                gl::glClear(gl::GL_COLOR_BUFFER_BIT | gl::GL_DEPTH_BUFFER_BIT | gl::GL_STENCIL_BUFFER_BIT);
+
+                gl::glEnable(gl::GL_DEPTH_TEST);
+                gl::glDepthFunc(gl::GL_LESS);
+                gl::glStencilFunc(gl::GL_ALWAYS, 1, 0xFF);
+                gl::glStencilOp(gl::GL_KEEP, gl::GL_KEEP, gl::GL_REPLACE);
+
+                m_ModelShader.Bind();
+                m_ModelShader.SetUniformMat4("u_ProjectionView", projection * viewMatrix);
+                gl::glBeginQuery(gl::GL_SAMPLES_PASSED, m_Queries[0]);
+                model.Draw();
+                gl::glEndQuery(gl::GL_SAMPLES_PASSED);
+
+                gl::glDisable(gl::GL_DEPTH_TEST);
+                gl::glStencilFunc(gl::GL_EQUAL, 1, 0xFF);
+                gl::glStencilOp(gl::GL_KEEP, gl::GL_KEEP, gl::GL_KEEP);
+
+                m_FullscreenShader.Bind();
+                m_EmptyVAO.Bind();
+
+                gl::glBeginQuery(gl::GL_SAMPLES_PASSED, m_Queries[1]);
+                gl::glDrawArrays(gl::GL_TRIANGLES, 0, 3);
+                gl::glEndQuery(gl::GL_SAMPLES_PASSED);
+
+                gl::GLuint shaded = 0, covered = 0;
+                gl::glGetQueryObjectuiv(m_Queries[0], gl::GL_QUERY_RESULT, &shaded);
+                gl::glGetQueryObjectuiv(m_Queries[1], gl::GL_QUERY_RESULT, &covered);
+
+                shadedFragments += shaded;
+                coveredPixels += covered;
+            }
+
+            gl::glDisable(gl::GL_STENCIL_TEST);
+            gl::glBindFramebuffer(gl::GL_FRAMEBUFFER, 0);
+
+            return coveredPixels == 0 ? 0.0 : static_cast<double>(shadedFragments) / coveredPixels;
+        }
+
+    private:
+        Shader m_ModelShader;
+        Shader m_FullscreenShader;
+        VertexArray m_EmptyVAO;
+
+        gl::GLuint m_Framebuffer = 0;
+        gl::GLuint m_Renderbuffers[2] = {};
+        gl::GLuint m_Queries[2] = {};
+    };
+
+    struct OverdrawConfig
+    {
+        const char* Name;
+        bool OptimizeVertexCache;
+        bool OptimizeOverdraw;
+        float Threshold;
+    };
+
+    void bench_overdraw_file(OverdrawMeter& meter, const std::string& filepath)
+    {
+        const OverdrawConfig configs[] = {
+            { "as built",            false, false, 0.f   },
+            { "vertex cache",        true,  false, 0.f   },
+            { "overdraw, 1.05",      true,  true,  1.05f },
+            { "overdraw, 1.25",      true,  true,  1.25f },
+            { "overdraw, 2.00",      true,  true,  2.00f },
+        };
+
+        std::cout << filepath << std::endl;
+
+        for (const OverdrawConfig& config : configs)
+        {
+            ModelBuilder builder;
+            builder.SetVertexCacheOptimization(config.OptimizeVertexCache);
+            builder.SetOverdrawOptimization(config.OptimizeOverdraw, config.Threshold);
+
+            auto start = std::chrono::steady_clock::now();
+            if (!builder.BuildWavefrontObj(filepath, ""))
+                return;
+            auto end = std::chrono::steady_clock::now();
+
+            const std::vector<Vertex>& vertices = builder.GetVertices();
+            const std::vector<uint32_t>& indices = builder.GetIndices();
+
+            VertexCacheStats stats = AnalyzeVertexCache(indices, vertices.size());
+            double overdraw = meter.Measure(vertices, indices);
+
+            std::cout << "    " << config.Name << ": overdraw " << overdraw << ", ACMR " << stats.ACMR
+                      << ", build " << std::chrono::duration<double, std::milli>(end - start).count() << " ms"
+                      << std::endl;
+        }
+    }
+}
+
+void bench_overdraw_main()
+{
+    // Nothing is ever shown, the meter renders into its own framebuffer
+    CreateWindowProps props { 64, 64, "Overdraw Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        OverdrawMeter meter;
+
+        bench_overdraw_file(meter, "assets/models/smooth_vase.obj");
+
+        std::string syntheticPath = write_synthetic_blob_obj(400);
+        bench_overdraw_file(meter, syntheticPath);
+        std::filesystem::remove(syntheticPath);
+    }
+
+    window.Close();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "tile/ProgramCache.h"
+#include "tile/Shader.h"
+#include "tile/Window.h"
+#include "tile/opengl_inc.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    const char* const SHIPPED_SHADERS[] = {
+        "assets/shaders/DiffuseModel.glsl",
+        "assets/shaders/InstancedDiffuseModel.glsl",
+        "assets/shaders/InstancedDiffuseModelTRS.glsl",
+        "assets/shaders/BatchedDiffuseModel.glsl",
+        "assets/shaders/SolidColorShader.glsl",
+        "assets/shaders/WorldGrid.glsl",
+    };
+
+    // Milliseconds to load every shipped shader, the programs are deleted afterwards
+    double load_shipped_shaders_ms(const ProgramCache* cache)
+    {
+        std::vector<std::shared_ptr<Shader>> shaders;
+
+        auto start = std::chrono::steady_clock::now();
+        for (const char* filepath : SHIPPED_SHADERS)
+            shaders.push_back(Shader::LoadFromFile(filepath, filepath, cache));
+        auto end = std::chrono::steady_clock::now();
+
+        for (const std::shared_ptr<Shader>& shader : shaders)
+            gl::glDeleteProgram(shader->GetID());
+
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+}
+
+// Drivers keep caches of their own (e.g Mesa's and NVIDIA's shader disk caches), so compiling from source is
+// only really cold the first time the sources are seen; the best of a few runs is what a launch with those caches
+// warm costs
+void bench_program_cache_main()
+{
+    CreateWindowProps props { 64, 64, "Program Cache Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    constexpr int RUNS = 5;
+    const std::string cacheDirectory = "cache/bench_programs";
+
+    ProgramCache cache(cacheDirectory);
+    if (!cache.IsSupported())
+    {
+        std::cout << "The driver has no program binary formats" << std::endl;
+        window.Close();
+        return;
+    }
+
+    double sourceMs = -1.0, coldMs = -1.0, warmMs = -1.0;
+    for (int run = 0; run < RUNS; run++)
+    {
+        double ms = load_shipped_shaders_ms(nullptr);
+        if (sourceMs < 0.0 || ms < sourceMs)
+            sourceMs = ms;
+
+        // Cold: compiled from source and stored
+        std::error_code ec;
+        std::filesystem::remove_all(cacheDirectory, ec);
+
+        ms = load_shipped_shaders_ms(&cache);
+        if (coldMs < 0.0 || ms < coldMs)
+            coldMs = ms;
+
+        // Warm: every program from its binary
+        ms = load_shipped_shaders_ms(&cache);
+        if (warmMs < 0.0 || ms < warmMs)
+            warmMs = ms;
+    }
+
+    size_t entryCount = 0, entryBytes = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(cacheDirectory, ec))
+    {
+        entryCount++;
+        entryBytes += entry.file_size(ec);
+    }
+
+    std::cout << std::size(SHIPPED_SHADERS) << " shipped shaders, best of " << RUNS << " ms:" << std::endl;
+    std::cout << "    from source, no cache: " << sourceMs << std::endl;
+    std::cout << "    cold cache (compile + store): " << coldMs << std::endl;
+    std::cout << "    warm cache (glProgramBinary): " << warmMs << std::endl;
+    std::cout << "    " << entryCount << " entries, " << entryBytes / 1024 << " KiB" << std::endl;
+
+    std::filesystem::remove_all(cacheDirectory, ec);
+    window.Close();
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "tests/bench_batch_rendering.inl"
+#include "tile/GeometryPool.h"
+#include "tile/GlState.h"
+#include "tile/Model.h"
+#include "tile/RenderQueue.h"
+#include "tile/Shader.h"
+#include "tile/ShaderConstants.h"
+#include "tile/Texture.h"
+#include "tile/Window.h"
+#include "tile/opengl_inc.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct QueueBenchObject
+    {
+        const Model* Mesh;
+        Shader* Program;
+        const Texture* Tex;
+        glm::mat4 Transform;
+        glm::vec3 Color;
+    };
+}
+
+void bench_render_queue_main()
+{
+    CreateWindowProps props { 256, 256, "Render Queue Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        ModelBuilder builder;
+        builder.SetGeometryPool(std::make_shared<GeometryPool>());
+        builder.SetVertexQuantization(true);
+
+        std::string blobPath = write_synthetic_blob_obj(8);
+        std::shared_ptr<Model> meshes[3] = {
+            builder.LoadWavefrontObj("assets/models/cube.obj"),
+            builder.LoadWavefrontObj("assets/models/cube_quads.obj"),
+            builder.LoadWavefrontObj(blobPath)
+        };
+        std::filesystem::remove(blobPath);
+
+        for (const std::shared_ptr<Model>& mesh : meshes)
+        {
+            if (!mesh)
+                return;
+        }
+
+        // Separate programs and textures, so that the order decides how often they change
+        constexpr int SHADER_COUNT = 4;
+        constexpr int TEXTURE_COUNT = 8;
+
+        glm::vec3 viewPosition(0.f, 80.f, 90.f);
+        glm::mat4 projectionView = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 500.f) *
+                                   glm::lookAt(viewPosition, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+        FrameConstants frame = MakeFrameConstants(projectionView, viewPosition, 0.1f, 500.f,
+                                                  glm::normalize(glm::vec3(1.f, 1.5f, -1.f)));
+
+        std::vector<std::shared_ptr<Shader>> shaders;
+        for (int i = 0; i < SHADER_COUNT; i++)
+            shaders.push_back(Shader::LoadFromFile("assets/shaders/DiffuseModel.glsl", "Diffuse Shader"));
+
+        std::vector<std::unique_ptr<Texture2D>> textures;
+        for (int i = 0; i < TEXTURE_COUNT; i++)
+            textures.push_back(std::make_unique<Texture2D>(4, 4, TexFormat::RGBA_8));
+
+        // 50k objects in no particular order, as a scene graph walk would produce them
+        constexpr int OBJECT_COUNT = 50000;
+
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> coordinate(-100.f, 100.f);
+
+        std::vector<QueueBenchObject> objects;
+        objects.reserve(OBJECT_COUNT);
+
+        for (int i = 0; i < OBJECT_COUNT; i++)
+        {
+            glm::vec3 position(coordinate(random), 0.f, coordinate(random));
+            glm::mat4 transform = glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(0.5f));
+
+            objects.push_back({ meshes[random() % 3].get(), shaders[random() % SHADER_COUNT].get(),
+                                textures[random() % TEXTURE_COUNT].get(), transform,
+                                glm::vec3(0.2f + 0.6f * (i % 7) / 7.f, 0.5f, 0.7f) });
+        }
+
+        size_t drawCalls = 0;
+        for (const QueueBenchObject& object : objects)
+            drawCalls += object.Mesh->GetIndexChunks().size();
+
+        std::cout << objects.size() << " packets" << std::endl;
+
+        /* ------------------------------------- Sort and submit on the CPU ------------------------------------- */
+
+        constexpr int SORT_RUNS = 20;
+
+        RenderQueue queue;
+        double submitMs = 0.0, radixSortMs = 0.0, stdSortMs = 0.0;
+
+        for (int run = 0; run < SORT_RUNS; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            queue.Begin(viewPosition, 500.f);
+            for (const QueueBenchObject& object : objects)
+            {
+                queue.Submit(RenderPass::Opaque, *object.Program, *object.Mesh, object.Transform, object.Color,
+                             object.Tex);
+            }
+
+            auto submitted = std::chrono::steady_clock::now();
+            queue.Sort();
+            auto sorted = std::chrono::steady_clock::now();
+
+            submitMs += std::chrono::duration<double, std::milli>(submitted - start).count();
+            radixSortMs += std::chrono::duration<double, std::milli>(sorted - submitted).count();
+
+            // The same keys through std::sort, for reference
+            std::vector<uint64_t> keys;
+            keys.reserve(objects.size());
+            for (const QueueBenchObject& object : objects)
+            {
+                float depth = glm::length(glm::vec3(object.Transform[3]) - viewPosition) / 500.f;
+                keys.push_back(RenderQueue::MakeSortKey(RenderPass::Opaque, object.Program->GetID(),
+                                                        object.Tex->GetID(), depth));
+            }
+
+            auto stdStart = std::chrono::steady_clock::now();
+            std::sort(keys.begin(), keys.end());
+            auto stdSorted = std::chrono::steady_clock::now();
+
+            stdSortMs += std::chrono::duration<double, std::milli>(stdSorted - stdStart).count();
+        }
+
+        std::cout << "    submit " << submitMs / SORT_RUNS << " ms, radix sort " << radixSortMs / SORT_RUNS
+                  << " ms (std::sort " << stdSortMs / SORT_RUNS << " ms)" << std::endl;
+
+        /* ------------------------------------- Drawing, unsorted vs sorted ------------------------------------ */
+
+        ShaderConstants constants(objects.size());
+
+        GlStateCache& state = GetGlState();
+        state.Enable(gl::GL_DEPTH_TEST);
+        gl::glCullFace(gl::GL_BACK);
+        gl::glFrontFace(gl::GL_CCW);
+
+        // In submission order, with the same state changes the queue makes
+        BatchBenchTimes unsorted = measure_scene_frames([&]() {
+            state.ResetStats();
+            constants.BeginFrame(frame);
+
+            for (const QueueBenchObject& object : objects)
+            {
+                state.Disable(gl::GL_BLEND);
+                state.Enable(gl::GL_CULL_FACE);
+                object.Program->Bind();
+                object.Tex->Bind(0);
+
+                constants.SetObject(MakeObjectConstants(object.Transform, object.Mesh->GetDequantizeTransform(),
+                                                        object.Color));
+                object.Mesh->Draw();
+            }
+
+            constants.EndFrame();
+        });
+
+        RenderStats unsortedStats = state.GetStats();
+
+        BatchBenchTimes queued = measure_scene_frames([&]() {
+            state.ResetStats();
+            constants.BeginFrame(frame);
+
+            queue.Begin(viewPosition, 500.f);
+            for (const QueueBenchObject& object : objects)
+            {
+                queue.Submit(RenderPass::Opaque, *object.Program, *object.Mesh, object.Transform, object.Color,
+                             object.Tex);
+            }
+
+            queue.Execute(constants);
+            constants.EndFrame();
+        });
+
+        RenderStats queuedStats = state.GetStats();
+
+        report_batch_bench_times("submission order", unsorted, drawCalls);
+        std::cout << "        " << unsortedStats.GetIssued() << " state changes issued" << std::endl;
+        report_batch_bench_times("render queue", queued, drawCalls);
+        std::cout << "        " << queuedStats.GetIssued() << " state changes issued" << std::endl;
+    }
+
+    window.Close();
+}
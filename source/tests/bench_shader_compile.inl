@@ -0,0 +1,126 @@
+#pragma once
+
+#include "tests/bench_program_cache.inl"
+#include "tile/Shader.h"
+#include "tile/Window.h"
+#include "tile/gl_extensions.h"
+#include "tile/opengl_inc.h"
+
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    // A define after the #version line, so that the driver's own shader cache has not seen the sources yet
+    ShaderSources salt_shader_sources(const ShaderSources& sources, int salt)
+    {
+        ShaderSources salted;
+        for (const auto& [type, source] : sources)
+        {
+            size_t versionEnd = source.find('\n', source.find("#version"));
+            if (versionEnd == std::string::npos)
+                versionEnd = 0;
+            else
+                versionEnd++;
+
+            salted[type] = source.substr(0, versionEnd) + "#define TILE_BENCH_SALT " + std::to_string(salt) +
+                           "\n" + source.substr(versionEnd);
+        }
+
+        return salted;
+    }
+
+    struct ShaderCompileTimes
+    {
+        // Until the constructors returned, i.e how long the thread that creates the shaders is busy
+        double SubmitMs = 0.0;
+
+        // Until every shader was ready
+        double ReadyMs = 0.0;
+
+        // How often the shaders were polled until then, each poll standing in for a frame
+        int Polls = 0;
+    };
+
+    ShaderCompileTimes compile_shaders(const std::vector<ShaderSources>& sources, ShaderCompileMode mode)
+    {
+        ShaderCompileTimes times;
+        std::vector<std::unique_ptr<Shader>> shaders;
+
+        auto start = std::chrono::steady_clock::now();
+        for (const ShaderSources& stages : sources)
+            shaders.push_back(std::make_unique<Shader>(stages, "Bench Shader", nullptr, mode));
+        auto submitted = std::chrono::steady_clock::now();
+
+        bool allReady = false;
+        while (!allReady)
+        {
+            allReady = true;
+            for (const std::unique_ptr<Shader>& shader : shaders)
+                allReady &= shader->Poll() || shader->GetStatus() == ShaderStatus::Failed;
+
+            times.Polls++;
+        }
+
+        auto ready = std::chrono::steady_clock::now();
+
+        for (const std::unique_ptr<Shader>& shader : shaders)
+            gl::glDeleteProgram(shader->GetID());
+
+        times.SubmitMs = std::chrono::duration<double, std::milli>(submitted - start).count();
+        times.ReadyMs = std::chrono::duration<double, std::milli>(ready - start).count();
+        return times;
+    }
+}
+
+void bench_shader_compile_main()
+{
+    CreateWindowProps props { 64, 64, "Shader Compile Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    std::vector<ShaderSources> shipped;
+    for (const char* filepath : SHIPPED_SHADERS)
+    {
+        ShaderSources sources;
+        if (!Shader::ReadSourcesFromFile(filepath, sources))
+            return;
+        shipped.push_back(sources);
+    }
+
+    std::cout << std::size(SHIPPED_SHADERS) << " shipped shaders, "
+              << (GetGlExtensions().ParallelShaderCompile ? "with" : "without")
+              << " GL_KHR_parallel_shader_compile, ms:" << std::endl;
+
+    constexpr int RUNS = 5;
+    int salt = static_cast<int>(std::chrono::steady_clock::now().time_since_epoch().count() & 0x7FFFFFFF);
+
+    for (ShaderCompileMode mode : { ShaderCompileMode::Blocking, ShaderCompileMode::Async })
+    {
+        ShaderCompileTimes total;
+        for (int run = 0; run < RUNS; run++)
+        {
+            std::vector<ShaderSources> salted;
+            for (const ShaderSources& sources : shipped)
+                salted.push_back(salt_shader_sources(sources, salt++));
+
+            ShaderCompileTimes times = compile_shaders(salted, mode);
+            total.SubmitMs += times.SubmitMs;
+            total.ReadyMs += times.ReadyMs;
+            total.Polls += times.Polls;
+        }
+
+        std::cout << "    " << (mode == ShaderCompileMode::Blocking ? "blocking" : "async")
+                  << ": submitted after " << total.SubmitMs / RUNS << ", all ready after " << total.ReadyMs / RUNS
+                  << " (" << total.Polls / RUNS << " polls)" << std::endl;
+    }
+
+    window.Close();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "tile/Model.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    struct ConversionCase
+    {
+        const char* Name;
+        CoordinateSystem3D Source;
+        CoordinateSystem3D Target;
+    };
+
+    const ConversionCase CONVERSION_CASES[] = {
+        // What ModelBuilder does by default. Only flips signs
+        {
+            "Y-down to Y-up",
+            { { AxisLine::LINE_X, +1 }, { AxisLine::LINE_Y, -1 }, { AxisLine::LINE_Z, -1 } },
+            { { AxisLine::LINE_X, +1 }, { AxisLine::LINE_Y, +1 }, { AxisLine::LINE_Z, -1 } },
+        },
+        // e.g Blender to OpenGL. Swaps Y and Z
+        {
+            "Z-up to Y-up",
+            { { AxisLine::LINE_X, +1 }, { AxisLine::LINE_Z, +1 }, { AxisLine::LINE_Y, +1 } },
+            { { AxisLine::LINE_X, +1 }, { AxisLine::LINE_Y, +1 }, { AxisLine::LINE_Z, -1 } },
+        },
+        // A full rotation of the axes
+        {
+            "X-forward to Z-forward",
+            { { AxisLine::LINE_Y, -1 }, { AxisLine::LINE_Z, +1 }, { AxisLine::LINE_X, +1 } },
+            { { AxisLine::LINE_X, +1 }, { AxisLine::LINE_Y, +1 }, { AxisLine::LINE_Z, -1 } },
+        },
+    };
+
+    template <typename Func>
+    double best_conversion_ms(const std::vector<float>& input, std::vector<float>& output, Func&& func)
+    {
+        double best = -1.0;
+        for (int run = 0; run < 5; run++)
+        {
+            output = input;
+
+            auto start = std::chrono::steady_clock::now();
+            func(output);
+            auto end = std::chrono::steady_clock::now();
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            if (best < 0.0 || elapsed < best)
+                best = elapsed;
+        }
+
+        return best;
+    }
+}
+
+void bench_space_conversion_main()
+{
+    // Not a multiple of 4, so that the scalar tail is covered too
+    const size_t vecCount = 4 * 1000 * 1000 + 3;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> distribution(-100.f, 100.f);
+
+    std::vector<float> input(3 * vecCount);
+    for (auto& value : input)
+        value = distribution(rng);
+    input[0] = 0.f;
+    input[1] = -0.f;
+
+    for (const auto& conversion : CONVERSION_CASES)
+    {
+        SpaceConverter converter(conversion.Source, conversion.Target);
+        std::vector<float> scalar, batch;
+
+        double scalarMs = best_conversion_ms(input, scalar, [&](std::vector<float>& vecs) {
+            for (size_t i = 0; i < vecCount; i++)
+            {
+                glm::vec3 vec = { vecs[3 * i + 0], vecs[3 * i + 1], vecs[3 * i + 2] };
+                converter.ConvertInPlace(vec);
+
+                vecs[3 * i + 0] = vec.x;
+                vecs[3 * i + 1] = vec.y;
+                vecs[3 * i + 2] = vec.z;
+            }
+        });
+
+        double batchMs = best_conversion_ms(input, batch, [&](std::vector<float>& vecs) {
+            converter.ConvertArrayInPlace(vecs.data(), vecCount);
+        });
+
+        bool identical = std::memcmp(scalar.data(), batch.data(), sizeof(float) * scalar.size()) == 0;
+
+        std::cout << conversion.Name << ", " << vecCount << " vec3s\n"
+                  << "    ConvertInPlace() per vec3: " << scalarMs << " ms\n"
+                  << "    ConvertArrayInPlace():     " << batchMs << " ms\n"
+                  << "    output identical: " << (identical ? "yes" : "NO") << std::endl;
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "tests/bench_batch_rendering.inl"
+#include "tile/GeometryPool.h"
+#include "tile/GlState.h"
+#include "tile/Model.h"
+#include "tile/Shader.h"
+#include "tile/ShaderConstants.h"
+#include "tile/Window.h"
+#include "tile/opengl_inc.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void report_state_cache_stats(const char* name, const BatchBenchTimes& times, const RenderStats& stats)
+    {
+        std::cout << "    " << name << ": submit " << times.SubmitMs << " ms, " << stats.GetIssued()
+                  << " state changes issued, " << stats.GetFiltered() << " filtered" << std::endl;
+
+        for (int i = 0; i < STATE_CHANGE_KIND_COUNT; i++)
+        {
+            auto kind = static_cast<StateChange>(i);
+            if (stats.GetIssued(kind) + stats.GetFiltered(kind) == 0)
+                continue;
+
+            std::cout << "        " << StateChangeName(kind) << ": " << stats.GetIssued(kind) << " issued, "
+                      << stats.GetFiltered(kind) << " filtered" << std::endl;
+        }
+    }
+}
+
+void bench_state_cache_main()
+{
+    CreateWindowProps props { 256, 256, "State Cache Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        // Pooled meshes share their vertex array, the others have their own
+        ModelBuilder builder;
+        builder.SetVertexQuantization(true);
+
+        std::shared_ptr<Model> ownCube = builder.LoadWavefrontObj("assets/models/cube.obj");
+
+        builder.SetGeometryPool(std::make_shared<GeometryPool>());
+
+        std::string blobPath = write_synthetic_blob_obj(8);
+        std::shared_ptr<Model> meshes[3] = {
+            ownCube,
+            builder.LoadWavefrontObj("assets/models/cube_quads.obj"),
+            builder.LoadWavefrontObj(blobPath)
+        };
+        std::filesystem::remove(blobPath);
+
+        for (const std::shared_ptr<Model>& mesh : meshes)
+        {
+            if (!mesh)
+                return;
+        }
+
+        // 100 x 100 objects, in runs of the same mesh like a scene sorted by material would have
+        constexpr int GRID_SIZE = 100;
+
+        std::vector<BatchBenchObject> objects;
+        objects.reserve(GRID_SIZE * GRID_SIZE);
+
+        for (int x = 0; x < GRID_SIZE; x++)
+        {
+            for (int z = 0; z < GRID_SIZE; z++)
+            {
+                glm::vec3 position(1.5f * (x - GRID_SIZE / 2), 0.f, 1.5f * (z - GRID_SIZE / 2));
+                glm::mat4 transform = glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(0.5f));
+                glm::vec3 color(static_cast<float>(x) / GRID_SIZE, 0.5f, static_cast<float>(z) / GRID_SIZE);
+
+                objects.push_back({ meshes[(z / 10) % 3].get(), transform, color });
+            }
+        }
+
+        glm::vec3 viewPosition(0.f, 80.f, 90.f);
+        glm::mat4 projectionView = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 500.f) *
+                                   glm::lookAt(viewPosition, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+        FrameConstants frame = MakeFrameConstants(projectionView, viewPosition, 0.1f, 500.f,
+                                                  glm::normalize(glm::vec3(1.f, 1.5f, -1.f)));
+        ShaderConstants constants(objects.size());
+
+        GlStateCache& state = GetGlState();
+        state.Enable(gl::GL_DEPTH_TEST);
+        gl::glCullFace(gl::GL_BACK);
+        gl::glFrontFace(gl::GL_CCW);
+
+        auto diffuseShader = Shader::LoadFromFile("assets/shaders/DiffuseModel.glsl", "Diffuse Shader");
+
+        std::cout << objects.size() << " objects" << std::endl;
+
+        // Every object sets up everything it needs, the way Application::Draw() does for its model
+        auto drawScene = [&]() {
+            // What is left in the counters afterwards is the last frame's
+            state.ResetStats();
+            constants.BeginFrame(frame);
+
+            for (const BatchBenchObject& object : objects)
+            {
+                state.Disable(gl::GL_BLEND);
+                state.Enable(gl::GL_CULL_FACE);
+                diffuseShader->Bind();
+
+                constants.SetObject(MakeObjectConstants(object.Transform, object.Mesh->GetDequantizeTransform(),
+                                                        object.Color));
+                object.Mesh->Draw();
+            }
+
+            constants.EndFrame();
+        };
+
+        for (bool filtering : { false, true })
+        {
+            state.SetFiltering(filtering);
+            state.Invalidate();
+
+            BatchBenchTimes times = measure_scene_frames(drawScene);
+            report_state_cache_stats(filtering ? "filtered" : "unfiltered", times, state.GetStats());
+        }
+
+        state.SetFiltering(true);
+    }
+
+    window.Close();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "tile/GlState.h"
+#include "tile/Instancing.h"
+#include "tile/Shader.h"
+#include "tile/StreamBuffer.h"
+#include "tile/Window.h"
+#include "tile/gl_extensions.h"
+#include "tile/gl_wrappers.h"
+#include "tile/opengl_inc.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    struct LineVertex
+    {
+        glm::vec3 Position;
+        uint32_t Color;
+    };
+
+    const VertexLayout LINE_VERTEX_LAYOUT = {
+        {0, "ia_Pos",   3, VertAttribComponentType::Float, false},
+        {1, "ia_Color", 4, VertAttribComponentType::UByte, true },
+    };
+
+    const char* LINE_VERTEX_SHADER = R"(
+        #version 420 core
+        layout (location = 0) in vec3 ia_Pos;
+        layout (location = 1) in vec4 ia_Color;
+
+        out vec4 color;
+
+        void main()
+        {
+            gl_Position = vec4(ia_Pos, 1.0);
+            color = ia_Color;
+        }
+    )";
+
+    const char* LINE_FRAGMENT_SHADER = R"(
+        #version 420 core
+        in vec4 color;
+        out vec4 FragColor;
+
+        void main()
+        {
+            FragColor = color;
+        }
+    )";
+
+    // 100k lines, a different set every frame like debug geometry would be
+    constexpr int LINE_VERTEX_COUNT = 200000;
+    constexpr int STREAM_FRAMES = 120;
+
+    void write_line_vertices(LineVertex* vertices, int frame)
+    {
+        for (int i = 0; i < LINE_VERTEX_COUNT; i++)
+        {
+            float angle = 0.001f * i + 0.05f * frame;
+            float radius = (i % 2 == 0) ? 0.1f : 0.9f;
+
+            vertices[i].Position = glm::vec3(radius * std::cos(angle), radius * std::sin(angle), 0.f);
+            vertices[i].Color = PackColorRGBA8(glm::vec4(0.5f + 0.5f * std::sin(angle), 0.5f, 1.f, 1.f));
+        }
+    }
+
+    struct StreamBenchResult
+    {
+        // Writing and submitting, and all frames until the GPU is done with them
+        double SubmitMs = 0.0;
+        double FrameMs = 0.0;
+    };
+
+    template <typename StreamFrame>
+    StreamBenchResult measure_stream_frames(StreamFrame&& streamFrame)
+    {
+        gl::glFinish();
+
+        double submitMs = 0.0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int frame = 0; frame < STREAM_FRAMES; frame++)
+        {
+            auto frameStart = std::chrono::steady_clock::now();
+            gl::glClear(gl::GL_COLOR_BUFFER_BIT);
+
+            streamFrame(frame);
+
+            auto frameEnd = std::chrono::steady_clock::now();
+            submitMs += std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+        }
+
+        gl::glFinish();
+        auto end = std::chrono::steady_clock::now();
+
+        StreamBenchResult result;
+        result.SubmitMs = submitMs / STREAM_FRAMES;
+        result.FrameMs = std::chrono::duration<double, std::milli>(end - start).count() / STREAM_FRAMES;
+        return result;
+    }
+
+    void bench_stream_buffer_mode(StreamBufferMode mode, const char* name)
+    {
+        StreamBuffer stream(sizeof(LineVertex) * LINE_VERTEX_COUNT, 3, mode);
+        if (stream.GetMode() != mode)
+            return;
+
+        // The attributes point at the start of the buffer, each frame's vertices are reached through `first`
+        VertexArray vertexArray;
+        vertexArray.Bind();
+        GetGlState().BindBuffer(gl::GL_ARRAY_BUFFER, stream.GetID());
+        gl::glEnableVertexAttribArray(0);
+        gl::glVertexAttribPointer(0, 3, gl::GL_FLOAT, gl::GL_FALSE, sizeof(LineVertex), nullptr);
+        gl::glEnableVertexAttribArray(1);
+        gl::glVertexAttribPointer(1, 4, gl::GL_UNSIGNED_BYTE, gl::GL_TRUE, sizeof(LineVertex),
+                                  reinterpret_cast<const void*>(sizeof(glm::vec3)));
+
+        StreamBenchResult result = measure_stream_frames([&](int frame) {
+            stream.BeginFrame();
+
+            StreamAllocation allocation = stream.Allocate(sizeof(LineVertex) * LINE_VERTEX_COUNT, sizeof(LineVertex));
+            write_line_vertices(static_cast<LineVertex*>(allocation.Data), frame);
+            stream.Flush();
+
+            vertexArray.Bind();
+            gl::glDrawArrays(gl::GL_LINES, allocation.Offset / sizeof(LineVertex), LINE_VERTEX_COUNT);
+
+            stream.EndFrame();
+        });
+
+        const StreamBufferStats& stats = stream.GetStats();
+        std::cout << "    " << name << ": submit " << result.SubmitMs << " ms, frame " << result.FrameMs << " ms, "
+                  << stats.FenceWaits << " fence waits (" << stats.FenceWaitMs << " ms)" << std::endl;
+    }
+}
+
+void bench_stream_buffer_main()
+{
+    CreateWindowProps props { 256, 256, "Stream Buffer Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        Shader lineShader({ { ShaderType::Vertex, LINE_VERTEX_SHADER },
+                            { ShaderType::Fragment, LINE_FRAGMENT_SHADER } }, "Line Shader");
+        lineShader.Bind();
+
+        std::cout << LINE_VERTEX_COUNT / 2 << " lines per frame ("
+                  << sizeof(LineVertex) * LINE_VERTEX_COUNT / 1024 << " KiB)" << std::endl;
+
+        // What there was before: a vertex buffer respecified with the frame's data
+        {
+            VertexBuffer buffer;
+            VertexArray vertexArray;
+            vertexArray.AddVertexBuffer(buffer, LINE_VERTEX_LAYOUT);
+
+            std::vector<LineVertex> vertices(LINE_VERTEX_COUNT);
+
+            StreamBenchResult result = measure_stream_frames([&](int frame) {
+                write_line_vertices(vertices.data(), frame);
+                buffer.SetData(vertices.data(), sizeof(LineVertex) * LINE_VERTEX_COUNT, gl::GL_STREAM_DRAW);
+
+                vertexArray.Bind();
+                gl::glDrawArrays(gl::GL_LINES, 0, LINE_VERTEX_COUNT);
+            });
+
+            std::cout << "    VertexBuffer::SetData: submit " << result.SubmitMs << " ms, frame " << result.FrameMs
+                      << " ms" << std::endl;
+        }
+
+        bench_stream_buffer_mode(StreamBufferMode::PersistentMapped, "persistent mapping, 3 regions");
+        bench_stream_buffer_mode(StreamBufferMode::Orphaning, "orphaning");
+        bench_stream_buffer_mode(StreamBufferMode::SubData, "glBufferSubData");
+    }
+
+    window.Close();
+}
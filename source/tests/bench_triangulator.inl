@@ -0,0 +1,139 @@
+#pragma once
+
+#include "tile/Triangulator.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+using namespace Tile;
+
+namespace
+{
+    struct Point2D
+    {
+        double x, y;
+    };
+
+    // Puts a 2D polygon into a tilted plane, so that Triangulator has to project it back
+    std::vector<glm::vec3> to_tilted_plane(const std::vector<Point2D>& points)
+    {
+        std::vector<glm::vec3> positions;
+        positions.reserve(points.size());
+
+        for (const auto& point : points)
+            positions.emplace_back((float)point.x, (float)(0.3 * point.x - 0.2 * point.y), (float)point.y);
+
+        return positions;
+    }
+
+    // A comb with `teeth` teeth. Every gap between two teeth is a pair of reflex corners
+    std::vector<Point2D> make_comb(size_t teeth, double height)
+    {
+        std::vector<Point2D> points = { { 0.0, 0.0 }, { 2.0 * teeth - 1.0, 0.0 } };
+
+        for (size_t i = teeth; i-- > 0;)
+        {
+            points.push_back({ 2.0 * i + 1.0, height });
+            points.push_back({ 2.0 * i, height });
+
+            if (i > 0)
+            {
+                points.push_back({ 2.0 * i, 1.0 });
+                points.push_back({ 2.0 * i - 1.0, 1.0 });
+            }
+        }
+
+        return points;
+    }
+
+    // A circle with `spikes` shallow spikes, starting at an inner corner, so it can not be fanned out. Ear tests
+    // only look at the corners in the ear's bounding box, so long spikes across the whole polygon would turn
+    // every ear test into a scan of a large part of the polygon, no matter how the corners are organized
+    std::vector<Point2D> make_star(size_t spikes)
+    {
+        std::vector<Point2D> points;
+
+        for (size_t i = 0; i < 2 * spikes; i++)
+        {
+            double angle = 3.14159265358979323846 * i / spikes;
+            double radius = i % 2 == 0 ? 0.95 : 1.0;
+            points.push_back({ radius * std::cos(angle), radius * std::sin(angle) });
+        }
+
+        return points;
+    }
+
+    double signed_area(const std::vector<Point2D>& points)
+    {
+        double area = 0.0;
+        for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+            area += points[j].x * points[i].y - points[i].x * points[j].y;
+
+        return 0.5 * area;
+    }
+
+    // A valid triangulation of a simple polygon has N - 2 triangles, all wound like the polygon, covering
+    // exactly its area
+    bool check_triangulation(const std::vector<Point2D>& points, const std::vector<uint32_t>& triangles)
+    {
+        if (triangles.size() != 3 * (points.size() - 2))
+            return false;
+
+        double polygonArea = signed_area(points);
+        double area = 0.0;
+
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            double triangleArea = signed_area({ points[triangles[i]], points[triangles[i + 1]], points[triangles[i + 2]] });
+            if (triangleArea * polygonArea < 0.0)
+                return false;
+
+            area += triangleArea;
+        }
+
+        return std::abs(area - polygonArea) <= 1e-6 * std::abs(polygonArea);
+    }
+
+    void bench_polygon(const char* name, const std::vector<Point2D>& points)
+    {
+        std::vector<glm::vec3> positions = to_tilted_plane(points);
+
+        Triangulator triangulator;
+        std::vector<uint32_t> triangles;
+
+        double best = -1.0;
+        for (int run = 0; run < 3; run++)
+        {
+            triangles.clear();
+
+            auto start = std::chrono::steady_clock::now();
+            triangulator.Triangulate(positions.data(), positions.size(), triangles);
+            auto end = std::chrono::steady_clock::now();
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            if (best < 0.0 || elapsed < best)
+                best = elapsed;
+        }
+
+        std::cout << "    " << name << ", " << points.size() << " corners: " << best << " ms ("
+                  << 1e6 * best / points.size() << " ns per corner), valid: "
+                  << (check_triangulation(points, triangles) ? "yes" : "NO") << std::endl;
+    }
+}
+
+// The time per corner should stay roughly flat as the polygons grow. A plain ear clipper that tests every
+// corner against every candidate ear grows linearly per corner (quadratically overall) instead
+void bench_triangulator_main()
+{
+    for (size_t size : { 1000, 10000, 100000, 1000000 })
+    {
+        std::cout << size << " corners" << std::endl;
+
+        bench_polygon("comb", make_comb(size / 4, 10.0));
+        bench_polygon("star", make_star(size / 2));
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "tile/GlState.h"
+#include "tile/Shader.h"
+#include "tile/Window.h"
+#include "tile/opengl_inc.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+using namespace Tile;
+
+namespace
+{
+    constexpr int UNIFORM_SETS = 1000 * 1000;
+
+    // Nanoseconds per call of the best of a few runs
+    template <typename SetUniform>
+    double best_uniform_set_ns(SetUniform&& setUniform)
+    {
+        double best = -1.0;
+        for (int run = 0; run < 5; run++)
+        {
+            gl::glFinish();
+            auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < UNIFORM_SETS; i++)
+                setUniform(i);
+
+            auto end = std::chrono::steady_clock::now();
+
+            double elapsed = std::chrono::duration<double, std::nano>(end - start).count() / UNIFORM_SETS;
+            if (best < 0.0 || elapsed < best)
+                best = elapsed;
+        }
+
+        return best;
+    }
+}
+
+void bench_uniforms_main()
+{
+    CreateWindowProps props { 64, 64, "Uniforms Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        auto shader = Shader::LoadFromFile("assets/shaders/InstancedDiffuseModel.glsl", "Instanced Diffuse Shader");
+        shader->Bind();
+
+        // The lookup Shader::GetUniformLocation() used to do: std::string keys, find() then operator[]
+        std::unordered_map<std::string, int> locationCache;
+        auto map_location = [&](const std::string& name) {
+            if (locationCache.find(name) != locationCache.end())
+                return locationCache[name];
+
+            int location = gl::glGetUniformLocation(shader->GetID(), name.c_str());
+            locationCache[name] = location;
+            return location;
+        };
+
+        // Different every time, so that the driver cannot skip anything
+        glm::mat4 matrix(1.f);
+
+        double mapNs = best_uniform_set_ns([&](int i) {
+            matrix[3][0] = static_cast<float>(i);
+            gl::glUniformMatrix4fv(map_location("u_Dequantize"), 1, gl::GL_FALSE, &matrix[0][0]);
+        });
+
+        double stringNs = best_uniform_set_ns([&](int i) {
+            matrix[3][0] = static_cast<float>(i);
+            shader->SetUniformMat4("u_Dequantize", matrix);
+        });
+
+        double literalNs = best_uniform_set_ns([&](int i) {
+            matrix[3][0] = static_cast<float>(i);
+            shader->SetUniform("u_Dequantize"_uniform, matrix);
+        });
+
+        UniformHandle<glm::mat4> dequantize = shader->GetUniform<glm::mat4>("u_Dequantize"_uniform);
+        double handleNs = best_uniform_set_ns([&](int i) {
+            matrix[3][0] = static_cast<float>(i);
+            shader->SetUniform(dequantize, matrix);
+        });
+
+        // The value cache filters these out
+        glm::mat4 constant(2.f);
+        GetGlState().ResetStats();
+        double unchangedNs = best_uniform_set_ns([&](int) {
+            shader->SetUniform(dequantize, constant);
+        });
+        RenderStats unchangedStats = GetGlState().GetStats();
+
+        // What is left once the lookups are gone. Past the Shader, so its copy of the value is stale after this
+        int location = dequantize.Location;
+        double rawNs = best_uniform_set_ns([&](int i) {
+            matrix[3][0] = static_cast<float>(i);
+            gl::glUniformMatrix4fv(location, 1, gl::GL_FALSE, &matrix[0][0]);
+        });
+
+        std::cout << UNIFORM_SETS << " mat4 uniform sets, ns per set:" << std::endl;
+        std::cout << "    string map (previous SetUniformMat4): " << mapNs << std::endl;
+        std::cout << "    SetUniformMat4, string hashed at run time: " << stringNs << std::endl;
+        std::cout << "    SetUniform, _uniform literal: " << literalNs << std::endl;
+        std::cout << "    SetUniform, resolved handle: " << handleNs << std::endl;
+        std::cout << "    SetUniform, resolved handle, same value every time: " << unchangedNs << " ("
+                  << unchangedStats.GetIssued(StateChange::Uniform) << " uploaded, "
+                  << unchangedStats.GetFiltered(StateChange::Uniform) << " skipped)" << std::endl;
+        std::cout << "    glUniformMatrix4fv alone: " << rawNs << std::endl;
+    }
+
+    window.Close();
+}
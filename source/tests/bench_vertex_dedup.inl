@@ -0,0 +1,136 @@
+#pragma once
+
+#include "tile/DedupTable.h"
+#include "tile/Model.h"
+
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    // The face corners of a (size x size) grid of quads, each split into two triangles. Every grid
+    // point is shared by up to 6 corners, like in a typical smooth mesh
+    std::vector<Vertex> make_grid_corners(int size)
+    {
+        auto grid_vertex = [size](int x, int z) {
+            Vertex vertex;
+            vertex.position = { (float)x / size, 0.f, -(float)z / size };
+            vertex.normal = { 0.f, 1.f, -0.f };
+            vertex.textureCoords = { (float)x / size, (float)z / size };
+            return vertex;
+        };
+
+        std::vector<Vertex> corners;
+        corners.reserve(6 * (size_t)size * size);
+
+        for (int z = 0; z < size; z++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                corners.push_back(grid_vertex(x, z));
+                corners.push_back(grid_vertex(x + 1, z));
+                corners.push_back(grid_vertex(x + 1, z + 1));
+
+                corners.push_back(grid_vertex(x, z));
+                corners.push_back(grid_vertex(x + 1, z + 1));
+                corners.push_back(grid_vertex(x, z + 1));
+            }
+        }
+
+        return corners;
+    }
+
+    struct DedupOutput
+    {
+        std::vector<Vertex> Vertices;
+        std::vector<uint32_t> Indices;
+    };
+
+    // What ModelBuilder::AddVertex() used to do
+    void dedup_unordered_map(const std::vector<Vertex>& corners, DedupOutput& output)
+    {
+        std::unordered_map<Vertex, uint32_t> uniqueVertices;
+
+        for (const auto& vertex : corners)
+        {
+            if (uniqueVertices.count(vertex) == 0)
+            {
+                uniqueVertices[vertex] = static_cast<uint32_t>(output.Vertices.size());
+                output.Vertices.push_back(vertex);
+            }
+
+            output.Indices.push_back(uniqueVertices[vertex]);
+        }
+    }
+
+    void dedup_flat_table(const std::vector<Vertex>& corners, size_t reserve, DedupOutput& output)
+    {
+        DedupTable<Vertex, VertexBitsHash> uniqueVertices;
+        uniqueVertices.Reserve(reserve);
+
+        for (const auto& vertex : corners)
+        {
+            auto unique = uniqueVertices.FindOrInsert(vertex, output.Vertices.data());
+            if (unique.Inserted)
+                output.Vertices.push_back(vertex);
+
+            output.Indices.push_back(unique.Index);
+        }
+    }
+
+    template <typename Func>
+    double time_dedup_ms(const std::vector<Vertex>& corners, DedupOutput& output, Func&& func)
+    {
+        double best = -1.0;
+        for (int run = 0; run < 3; run++)
+        {
+            output.Vertices.clear();
+            output.Vertices.shrink_to_fit();
+            output.Indices.clear();
+            output.Indices.reserve(corners.size());
+
+            auto start = std::chrono::steady_clock::now();
+            func(corners, output);
+            auto end = std::chrono::steady_clock::now();
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            if (best < 0.0 || elapsed < best)
+                best = elapsed;
+        }
+
+        return best;
+    }
+}
+
+void bench_vertex_dedup_main()
+{
+    for (int size : { 100, 1000 })
+    {
+        std::vector<Vertex> corners = make_grid_corners(size);
+        size_t expectedUniques = (size_t)(size + 1) * (size + 1);
+
+        DedupOutput reference, flat, flatReserved;
+
+        double mapMs = time_dedup_ms(corners, reference, dedup_unordered_map);
+        double flatMs = time_dedup_ms(corners, flat, [](const auto& c, auto& o) { dedup_flat_table(c, 0, o); });
+        double reservedMs = time_dedup_ms(corners, flatReserved, [&](const auto& c, auto& o) {
+            dedup_flat_table(c, expectedUniques, o);
+        });
+
+        bool identical =
+            reference.Indices == flat.Indices && reference.Indices == flatReserved.Indices &&
+            reference.Vertices.size() == flat.Vertices.size() &&
+            reference.Vertices.size() == flatReserved.Vertices.size();
+
+        std::cout << size << "x" << size << " grid: " << corners.size() << " corners, "
+                  << reference.Vertices.size() << " unique\n"
+                  << "    std::unordered_map:      " << mapMs << " ms\n"
+                  << "    DedupTable:              " << flatMs << " ms\n"
+                  << "    DedupTable (reserved):   " << reservedMs << " ms\n"
+                  << "    output identical: " << (identical ? "yes" : "NO") << std::endl;
+    }
+}
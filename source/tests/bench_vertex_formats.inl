@@ -0,0 +1,219 @@
+#pragma once
+
+#include "tests/bench_overdraw.inl"
+#include "tile/MeshOptimizer.h"
+#include "tile/Model.h"
+#include "tile/Shader.h"
+#include "tile/VertexQuantization.h"
+#include "tile/Window.h"
+#include "tile/opengl_inc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tile;
+
+namespace
+{
+    // The largest differences between the vertices and their quantized versions, positions relative
+    // to the bounding box diagonal and normals in degrees
+    void report_quantization_error(const std::vector<Vertex>& vertices, const QuantizedMesh& quantized)
+    {
+        glm::vec3 extent(quantized.Dequantize[0][0], quantized.Dequantize[1][1], quantized.Dequantize[2][2]);
+        glm::vec3 offset(quantized.Dequantize[3][0], quantized.Dequantize[3][1], quantized.Dequantize[3][2]);
+
+        float positionError = 0.f;
+        float normalError = 0.f;
+        float texCoordError = 0.f;
+
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const Vertex& vertex = vertices[i];
+            const QuantizedVertex& packed = quantized.Vertices[i];
+
+            glm::vec3 position;
+            for (int axis = 0; axis < 3; axis++)
+                position[axis] = offset[axis] + extent[axis] * packed.Position[axis] / 65535.f;
+
+            positionError = std::max(positionError, glm::length(position - vertex.position));
+
+            glm::vec3 normal;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                // Sign extend the 10 bit component
+                int32_t component = static_cast<int32_t>(packed.Normal << (22 - 10 * axis)) >> 22;
+                normal[axis] = std::max(component / 511.f, -1.f);
+            }
+
+            if (glm::length(vertex.normal) > 0.f)
+            {
+                float cosine = glm::dot(glm::normalize(normal), glm::normalize(vertex.normal));
+                normalError = std::max(normalError, std::acos(std::min(cosine, 1.f)) * 57.2957795f);
+            }
+
+            for (int component = 0; component < 2; component++)
+            {
+                float texCoord = HalfToFloat(packed.TextureCoords[component]);
+                texCoordError = std::max(texCoordError, std::abs(texCoord - vertex.textureCoords[component]));
+            }
+        }
+
+        std::cout << "    max error: position " << positionError / glm::length(extent) << " of the diagonal, normal "
+                  << normalError << " deg, texcoord " << texCoordError << std::endl;
+    }
+
+    // GPU time of drawing the model `DRAWS_PER_FRAME` times into a tiny viewport, so that vertex fetch and
+    // shading dominate. Averaged over a number of frames
+    double gpu_frame_time_ms(Shader& shader, const Model& model, const glm::mat4& projectionView)
+    {
+        constexpr int FRAMES = 30;
+        constexpr int DRAWS_PER_FRAME = 10;
+
+        shader.Bind();
+        shader.SetUniformMat4("u_ProjectionView", projectionView * model.GetDequantizeTransform());
+
+        gl::GLuint query;
+        gl::glGenQueries(1, &query);
+
+        double totalMs = 0.0;
+        for (int frame = 0; frame < FRAMES; frame++)
+        {
+            gl::glClear(gl::GL_COLOR_BUFFER_BIT | gl::GL_DEPTH_BUFFER_BIT);
+
+            gl::glBeginQuery(gl::GL_TIME_ELAPSED, query);
+            for (int draw = 0; draw < DRAWS_PER_FRAME; draw++)
+                model.Draw();
+            gl::glEndQuery(gl::GL_TIME_ELAPSED);
+
+            gl::GLuint64 elapsed = 0;
+            gl::glGetQueryObjectui64v(query, gl::GL_QUERY_RESULT, &elapsed);
+
+            // The first frame pays for uploads and shader warm up
+            if (frame > 0)
+                totalMs += elapsed / 1e6;
+        }
+
+        gl::glDeleteQueries(1, &query);
+        return totalMs / (FRAMES - 1);
+    }
+
+    void bench_vertex_format_file(Shader& shader, const std::string& filepath)
+    {
+        ModelBuilder builder;
+        builder.SetVertexCacheOptimization(true);
+        if (!builder.BuildWavefrontObj(filepath, ""))
+            return;
+
+        const std::vector<Vertex>& vertices = builder.GetVertices();
+        const std::vector<uint32_t>& indices = builder.GetIndices();
+
+        std::cout << filepath << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles"
+                  << std::endl;
+
+        QuantizedMesh quantized = QuantizeVertices(vertices.data(), vertices.size());
+        report_quantization_error(vertices, quantized);
+
+        Model full;
+        full.CreateVertexBuffer(vertices);
+        full.CreateIndexBuffer(indices);
+
+        Model compressed;
+        compressed.CreateVertexBuffer(quantized.Vertices.data(), quantized.Vertices.size(), quantized.Dequantize);
+        compressed.CreateIndexBuffer(indices);
+
+        // Only differs from `compressed` for meshes too large for 16 bit indices as they are
+        std::vector<Vertex> chunkVertices;
+        std::vector<uint16_t> chunkIndices;
+        std::vector<IndexChunk> chunks;
+        SplitIntoShortIndexChunks(vertices.data(), vertices.size(), indices.data(), indices.size(),
+                                  chunkVertices, chunkIndices, chunks);
+
+        QuantizedMesh quantizedChunks = QuantizeVertices(chunkVertices.data(), chunkVertices.size());
+
+        Model chunked;
+        chunked.CreateVertexBuffer(quantizedChunks.Vertices.data(), quantizedChunks.Vertices.size(),
+                                   quantizedChunks.Dequantize);
+        chunked.CreateIndexBuffer(chunkIndices.data(), chunkIndices.size(), chunks);
+
+        std::cout << "    " << chunks.size() << " index chunks, "
+                  << chunkVertices.size() - vertices.size() << " duplicated vertices" << std::endl;
+
+        // Maps the bounding box onto the whole clip space, so that both models cover the same pixels
+        glm::mat4 projectionView(1.f);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            projectionView[axis][axis] = 2.f / quantized.Dequantize[axis][axis];
+            projectionView[3][axis] = -1.f - 2.f * quantized.Dequantize[3][axis] / quantized.Dequantize[axis][axis];
+        }
+
+        const Model* models[3] = { &full, &compressed, &chunked };
+        const char* names[3] = { "full floats", "quantized", "quantized, 16 bit index chunks" };
+
+        for (int i = 0; i < 3; i++)
+        {
+            std::cout << "    " << names[i] << ": vertex buffer " << models[i]->GetVertexBufferSize() / 1024 << " KiB, "
+                      << "index buffer " << models[i]->GetIndexBufferSize() / 1024 << " KiB, GPU time "
+                      << gpu_frame_time_ms(shader, *models[i], projectionView) << " ms" << std::endl;
+        }
+    }
+}
+
+void bench_vertex_formats_main()
+{
+    CreateWindowProps props { 64, 64, "Vertex Format Benchmark", "tile-bench", false };
+    Window window(props);
+    if (!window.Init())
+        return;
+
+    {
+        // Reads every attribute, so that none of them is optimized away
+        const char* fragmentShader = R"(
+            #version 420 core
+            in vec3 fragNormal;
+            in vec2 texCoords;
+            out vec4 FragColor;
+
+            void main()
+            {
+                FragColor = vec4(normalize(fragNormal) * 0.5 + 0.5, texCoords.x);
+            }
+        )";
+
+        const char* vertexShader = R"(
+            #version 420 core
+            layout (location = 0) in vec3 ia_Pos;
+            layout (location = 1) in vec3 ia_Normal;
+            layout (location = 2) in vec2 ia_TexCoords;
+
+            uniform mat4 u_ProjectionView;
+
+            out vec3 fragNormal;
+            out vec2 texCoords;
+
+            void main()
+            {
+                gl_Position = u_ProjectionView * vec4(ia_Pos, 1.0);
+                fragNormal = ia_Normal;
+                texCoords = ia_TexCoords;
+            }
+        )";
+
+        Shader shader({ { ShaderType::Vertex, vertexShader }, { ShaderType::Fragment, fragmentShader } },
+                      "Vertex Format Shader");
+
+        gl::glEnable(gl::GL_DEPTH_TEST);
+
+        bench_vertex_format_file(shader, "assets/models/smooth_vase.obj");
+
+        std::string syntheticPath = write_synthetic_blob_obj(1000);
+        bench_vertex_format_file(shader, syntheticPath);
+        std::filesystem::remove(syntheticPath);
+    }
+
+    window.Close();
+}
@@ -8,7 +8,13 @@
 #include "tile/Shader.h"
 #include "tile/Camera.h"
 #include "tile/CameraController.h"
+#include "tile/GeometryPool.h"
+#include "tile/GlState.h"
 #include "tile/Model.h"
+#include "tile/ProgramCache.h"
+#include "tile/RenderQueue.h"
+#include "tile/ShaderConstants.h"
+#include "tile/ShaderVariants.h"
 #include "tile/Texture.h"
 #include "tile/utils.h"
 
@@ -70,10 +76,39 @@ private:
     void BeforeLoop()
     {
         m_Camera.SetAspectRatio((float)m_MainWindow->GetWidth() / m_MainWindow->GetHeight());
+
+        /* ------------------------------------------- Shader ------------------------------------------- */
+
+        // Linked programs are kept on disk, only the first launch (or one after a change) compiles them
+        m_ProgramCache = std::make_unique<ProgramCache>("cache/programs");
+
+        // Compiled by the driver while the models load and the first frames run (see PollShaders()). The model is
+        // drawn with the fallback until its shader is ready, which is small enough to be compiled right away
+        m_DiffuseShaders = ShaderVariants::LoadFromFile("assets/shaders/DiffuseModel.glsl", "Test Shader",
+                                                        m_ProgramCache.get(), ShaderCompileMode::Async);
+
+        // The variant the model is drawn with, asked for now so that it starts compiling
+        // m_DiffuseKeywords = m_DiffuseShaders->GetKeywordMask("TEXTURED");
+        m_DiffuseShaders->Get(m_DiffuseKeywords);
+
+        m_GridShader = Shader::LoadFromFile("assets/shaders/WorldGrid.glsl", "Grid Shader",
+                                            m_ProgramCache.get(), ShaderCompileMode::Async);
+
+        m_FallbackShader = Shader::LoadFromFile("assets/shaders/SolidColorShader.glsl", "Fallback Shader",
+                                                m_ProgramCache.get());
+        m_RenderQueue.SetFallbackShader(m_FallbackShader.get());
         
         /* ------------------------------------------- Model Loading ------------------------------------------- */
 
+        // Every model is a handle into the same vertex and index buffers
+        m_GeometryPool = std::make_shared<GeometryPool>();
+
         ModelBuilder builder;
+        builder.SetGeometryPool(m_GeometryPool);
+        builder.SetCacheDirectory("cache/meshes");
+        builder.SetVertexCacheOptimization(true);
+        builder.SetVertexQuantization(true);
+        builder.SetIndexChunking(true);
         
         // m_TestModel = builder.LoadWavefrontObj("assets/_models/flat_vase.obj");
         // m_TestModel = builder.LoadWavefrontObj("assets/models/smooth_vase.obj");
@@ -93,18 +128,10 @@ private:
         m_TestTexture = Texture2D::ImageFromFile("assets/textures/cosas.png");
         m_TestTexture->Bind(0);
 
-        /* ------------------------------------------- Shader ------------------------------------------- */
-
-        m_DefaultShader = Shader::LoadFromFile("assets/shaders/DiffuseModel.glsl", "Test Shader");
-        m_DefaultShader->Bind();
-        m_DefaultShader->SetUniformFloat3("u_Color", IRGB_TO_FRGB(174, 177, 189));
-
-        m_DefaultShader->SetUniformInt("u_ShouldSampleTexture", 0);
-        m_DefaultShader->SetUniformInt("u_Texture", 0); // the slot the texture is bound to
-
         /* ------------------------------------------- Grid ------------------------------------------- */
 
-        m_GridShader = Shader::LoadFromFile("assets/shaders/WorldGrid.glsl", "Grid Shader");
+        // Feeds the shaders' FrameConstants and ObjectConstants blocks
+        m_ShaderConstants = std::make_unique<ShaderConstants>();
 
         m_GridBuf = std::make_unique<VertexBuffer>();
         m_GridVAO = std::make_unique<VertexArray>();
@@ -117,8 +144,8 @@ private:
 
         gl::glClearColor(0.090196f, 0.090196f, 0.0901961f, 1.f);
 
-        gl::glEnable(gl::GL_MULTISAMPLE);
-        gl::glEnable(gl::GL_DEPTH_TEST);
+        GetGlState().Enable(gl::GL_MULTISAMPLE);
+        GetGlState().Enable(gl::GL_DEPTH_TEST);
 
         gl::glCullFace(gl::GL_BACK);
         gl::glFrontFace(gl::GL_CCW);
@@ -138,67 +165,92 @@ private:
 
         Draw();
 
+        // The state cache's counters are per frame
+        bool isStatsKeyPressed = glfwGetKey(m_MainWindow->GetGLFWHandle(), GLFW_KEY_F3) == GLFW_PRESS;
+        if (isStatsKeyPressed && !m_WasStatsKeyPressed)
+            PrintRenderStats(GetGlState().GetStats());
+
+        m_WasStatsKeyPressed = isStatsKeyPressed;
+        GetGlState().ResetStats();
+
         m_MainWindow->SwapBuffers();
         m_MainWindow->PollEvents();
     }
 
+    // Finishes the shaders the driver is done with, without waiting for the others
+    void PollShaders()
+    {
+        m_DiffuseShaders->Poll();
+        m_GridShader->Poll();
+    }
+
     void Draw()
     {
         m_CamController->Update();
+        PollShaders();
+
+        // light follows the camera
+        m_ShaderConstants->BeginFrame(MakeFrameConstants(m_Camera.GetProjectionView(), m_Camera.GetPosition(),
+                                                         m_Camera.GetNearPlane(), m_Camera.GetFarPlane(),
+                                                         glm::normalize(-m_Camera.GetFowardDirection())));
+
+        // Sorted before anything is drawn: the model (opaque) first, then the grid (blended) over it
+        m_RenderQueue.Begin(m_Camera.GetPosition(), m_Camera.GetFarPlane());
 
         /* ============================================================================================================ */
         /* ============================================== Draw the model ============================================== */
         /* ============================================================================================================ */
-        gl::glDisable(gl::GL_BLEND);
-        gl::glEnable(gl::GL_CULL_FACE);
-
-        m_TestModel->GetVA().Bind();
-        m_DefaultShader->Bind();
-
-        // TODO: multiply m_ProjectionView with model matrix to make up the actual
-        // "tranform" matrix. Right now it is only the unit matrix so it doesn't matter
-        m_DefaultShader->SetUniformMat4("u_Transform", m_Camera.GetProjectionView());
-        m_DefaultShader->SetUniformMat4("u_Model", glm::mat4 { 1.0f });
-
-        // light follows the camera
-        m_DefaultShader->SetUniformFloat3("u_DirectionToLight", glm::normalize(-m_Camera.GetFowardDirection()));
-
-        if (m_TestModel->HasIndexBuffer())
-            gl::glDrawElements(gl::GL_TRIANGLES, m_TestModel->GetIndexCount(), gl::GL_UNSIGNED_INT, 0);
-        else
-            gl::glDrawArrays(gl::GL_TRIANGLES, 0,  m_TestModel->GetVertexCount());
+        // The dequantization only applies to positions, so it stays out of the normal matrix
+        m_RenderQueue.Submit(RenderPass::Opaque, m_DiffuseShaders->Get(m_DiffuseKeywords), *m_TestModel,
+                             glm::mat4 { 1.0f }, IRGB_TO_FRGB(174, 177, 189));
 
 
         /* ============================================================================================================ */
         /* =============================================== Draw the grid ============================================== */
         /* ============================================================================================================ */
-        gl::glDisable(gl::GL_CULL_FACE);
-        gl::glEnable(gl::GL_BLEND);
+        // Spans the whole view, so it is as far as anything can be
+        m_RenderQueue.Submit(RenderPass::Transparent, *m_GridShader, *m_GridVAO, 6, 1.f);
+
+        m_RenderQueue.Execute(*m_ShaderConstants);
+        m_ShaderConstants->EndFrame();
+    }
 
-        m_GridShader->Bind();
-        m_GridShader->SetUniformMat4("u_ProjectionView", m_Camera.GetProjectionView());
-        m_GridShader->SetUniformFloat("u_CamNear", m_Camera.GetNearPlane());
-        m_GridShader->SetUniformFloat("u_CamFar", m_Camera.GetFarPlane());
+    static void PrintRenderStats(const RenderStats& stats)
+    {
+        std::cout << "State changes this frame: " << stats.GetIssued() << " issued, "
+                  << stats.GetFiltered() << " filtered" << std::endl;
 
-        m_GridVAO->Bind();
-        gl::glDrawArrays(gl::GL_TRIANGLES, 0, 6);
+        for (int i = 0; i < STATE_CHANGE_KIND_COUNT; i++)
+        {
+            auto kind = static_cast<StateChange>(i);
+            std::cout << "    " << StateChangeName(kind) << ": " << stats.GetIssued(kind) << " issued, "
+                      << stats.GetFiltered(kind) << " filtered" << std::endl;
+        }
     }
 
 private:
     bool m_Running = false;
+    bool m_WasStatsKeyPressed = false;
 
     std::unique_ptr<Window> m_MainWindow;
 
     Camera m_Camera;
 
+    std::shared_ptr<GeometryPool> m_GeometryPool;
     std::shared_ptr<Model> m_TestModel;
     std::shared_ptr<Texture> m_TestTexture;
 
     std::unique_ptr<CameraController> m_CamController;
     std::shared_ptr<Shader> m_GridShader;
-    std::shared_ptr<Shader> m_DefaultShader;
+    std::shared_ptr<ShaderVariants> m_DiffuseShaders;
+    ShaderKeywordMask m_DiffuseKeywords = 0;
+    std::shared_ptr<Shader> m_FallbackShader;
+    std::unique_ptr<ProgramCache> m_ProgramCache;
 
     std::unique_ptr<VertexBuffer> m_GridBuf;
     std::unique_ptr<VertexArray> m_GridVAO; 
+
+    RenderQueue m_RenderQueue;
+    std::unique_ptr<ShaderConstants> m_ShaderConstants;
 };
 
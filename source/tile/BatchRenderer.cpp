@@ -0,0 +1,197 @@
+#include "tile/BatchRenderer.h"
+#include "tile/gl_extensions.h"
+#include "tile/GlState.h"
+#include "tile/Model.h"
+#include "tile/Shader.h"
+#include "tile/opengl_inc.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+#include <glm/mat3x3.hpp>
+#include <glm/matrix.hpp>
+
+namespace
+{
+    using namespace Tile;
+
+    // After the vertex layouts' positions, normals and texture coordinates
+    const VertexLayout DRAW_ID_LAYOUT = { { 3, "DrawID", 1, VertAttribComponentType::UInt, false, 1 } };
+
+    static_assert(sizeof(DrawElementsIndirectCommand) == 5 * sizeof(uint32_t), "Has to match GL's layout");
+    static_assert(sizeof(BatchDrawData) == 8 * sizeof(glm::vec4), "BatchedDiffuseModel.glsl reads 8 texels per draw");
+}
+
+namespace Tile
+{
+    BatchRenderer::BatchRenderer()
+    {
+        GlStateCache& state = GetGlState();
+
+        gl::glGenBuffers(1, &m_IndirectBuffer);
+        gl::glGenBuffers(1, &m_DrawDataBuffer);
+
+        // The texture keeps referring to the buffer when its storage is replaced by the uploads
+        state.BindBuffer(gl::GL_TEXTURE_BUFFER, m_DrawDataBuffer);
+        gl::glBufferData(gl::GL_TEXTURE_BUFFER, sizeof(BatchDrawData), nullptr, gl::GL_STREAM_DRAW);
+
+        // The state cache binds through glBindTextureUnit then, which wants the texture to exist already
+        const GlExtensions& extensions = GetGlExtensions();
+        if (extensions.DirectStateAccess)
+        {
+            extensions.glCreateTextures(gl::GL_TEXTURE_BUFFER, 1, &m_DrawDataTexture);
+            extensions.glTextureBuffer(m_DrawDataTexture, gl::GL_RGBA32F, m_DrawDataBuffer);
+        }
+        else
+        {
+            gl::glGenTextures(1, &m_DrawDataTexture);
+            state.BindTexture(DRAW_DATA_TEXTURE_UNIT, gl::GL_TEXTURE_BUFFER, m_DrawDataTexture);
+            gl::glTexBuffer(gl::GL_TEXTURE_BUFFER, gl::GL_RGBA32F, m_DrawDataBuffer);
+        }
+    }
+
+    BatchRenderer::~BatchRenderer()
+    {
+        GlStateCache& state = GetGlState();
+        state.OnTextureDeleted(m_DrawDataTexture);
+        state.OnBufferDeleted(m_DrawDataBuffer);
+        state.OnBufferDeleted(m_IndirectBuffer);
+
+        gl::glDeleteTextures(1, &m_DrawDataTexture);
+        gl::glDeleteBuffers(1, &m_DrawDataBuffer);
+        gl::glDeleteBuffers(1, &m_IndirectBuffer);
+    }
+
+    void BatchRenderer::Begin()
+    {
+        // The batches stay around (empty), so that their command lists are not reallocated every frame
+        for (Batch& batch : m_Batches)
+            batch.Commands.clear();
+
+        m_DrawData.clear();
+    }
+
+    void BatchRenderer::Submit(const Model& model, const glm::mat4& transform, const glm::vec3& color)
+    {
+        if (!model.IsPooled() || !model.HasIndexBuffer())
+        {
+            if (!m_WarnedUnbatchable)
+                std::cerr << "[WARN] Only pooled models with an index buffer can be batched, skipping" << std::endl;
+
+            m_WarnedUnbatchable = true;
+            return;
+        }
+
+        uint32_t drawIndex = static_cast<uint32_t>(m_DrawData.size());
+
+        BatchDrawData& data = m_DrawData.emplace_back();
+        data.PositionTransform = transform * model.GetDequantizeTransform();
+        data.Color = glm::vec4(color, 1.f);
+
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+        for (int i = 0; i < 3; i++)
+            data.NormalMatrix[i] = glm::vec4(normalMatrix[i], 0.f);
+
+        Batch& batch = GetBatch(model.GetPool(), model.GetPoolAllocation().Format);
+        for (const IndexChunk& chunk : model.GetIndexChunks())
+            batch.Commands.push_back({ chunk.IndexCount, 1, chunk.FirstIndex, chunk.BaseVertex, drawIndex });
+    }
+
+    void BatchRenderer::Flush(Shader& shader)
+    {
+        m_CommandCount = 0;
+        m_DrawCallCount = 0;
+
+        if (m_DrawData.empty())
+            return;
+
+        ReserveDrawIDs(m_DrawData.size());
+
+        m_Commands.clear();
+        for (const Batch& batch : m_Batches)
+            m_Commands.insert(m_Commands.end(), batch.Commands.begin(), batch.Commands.end());
+
+        m_CommandCount = m_Commands.size();
+
+        // Respecifying the whole buffers lets the driver hand out new storage instead of waiting for the
+        // previous frame's draws
+        GlStateCache& state = GetGlState();
+
+        state.BindBuffer(gl::GL_TEXTURE_BUFFER, m_DrawDataBuffer);
+        gl::glBufferData(gl::GL_TEXTURE_BUFFER, sizeof(BatchDrawData) * m_DrawData.size(), m_DrawData.data(),
+                         gl::GL_STREAM_DRAW);
+
+        state.BindBuffer(gl::GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+        gl::glBufferData(gl::GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * m_Commands.size(),
+                         m_Commands.data(), gl::GL_STREAM_DRAW);
+
+        state.BindTexture(DRAW_DATA_TEXTURE_UNIT, gl::GL_TEXTURE_BUFFER, m_DrawDataTexture);
+
+        shader.Bind();
+        shader.SetUniform("u_DrawData"_uniform, DRAW_DATA_TEXTURE_UNIT);
+
+        const GlExtensions& extensions = GetGlExtensions();
+        size_t firstCommand = 0;
+
+        for (const Batch& batch : m_Batches)
+        {
+            if (batch.Commands.empty())
+                continue;
+
+            // Also picks up a draw ID buffer that was reallocated
+            batch.Pool->AddInstanceAttributes(m_DrawIDs, DRAW_ID_LAYOUT);
+            batch.Pool->GetVA(batch.Format).Bind();
+
+            gl::GLenum indexType = batch.Pool->GetIndexBuffer().GetGLIndexType();
+            auto offset = static_cast<uintptr_t>(firstCommand * sizeof(DrawElementsIndirectCommand));
+
+            if (extensions.MultiDrawIndirect)
+            {
+                extensions.glMultiDrawElementsIndirect(gl::GL_TRIANGLES, indexType,
+                                                       reinterpret_cast<const void*>(offset),
+                                                       static_cast<gl::GLsizei>(batch.Commands.size()), 0);
+                m_DrawCallCount++;
+            }
+            else
+            {
+                for (size_t i = 0; i < batch.Commands.size(); i++)
+                {
+                    uintptr_t commandOffset = offset + i * sizeof(DrawElementsIndirectCommand);
+                    gl::glDrawElementsIndirect(gl::GL_TRIANGLES, indexType,
+                                               reinterpret_cast<const void*>(commandOffset));
+                }
+                m_DrawCallCount += batch.Commands.size();
+            }
+
+            firstCommand += batch.Commands.size();
+        }
+
+        state.BindVertexArray(0);
+        state.BindBuffer(gl::GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    BatchRenderer::Batch& BatchRenderer::GetBatch(const std::shared_ptr<GeometryPool>& pool, VertexFormat format)
+    {
+        // There are hardly ever more than a couple
+        for (Batch& batch : m_Batches)
+        {
+            if (batch.Pool == pool && batch.Format == format)
+                return batch;
+        }
+
+        return m_Batches.emplace_back(Batch { pool, format, {} });
+    }
+
+    void BatchRenderer::ReserveDrawIDs(size_t count)
+    {
+        if (count <= m_DrawIDCapacity)
+            return;
+
+        m_DrawIDCapacity = std::max(count, 2 * m_DrawIDCapacity);
+
+        std::vector<uint32_t> ids(m_DrawIDCapacity);
+        std::iota(ids.begin(), ids.end(), 0u);
+        m_DrawIDs.SetData(ids.data(), sizeof(uint32_t) * ids.size());
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "tile/GeometryPool.h"
+#include "tile/gl_wrappers.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace Tile
+{
+    class Model;
+    class Shader;
+
+    // The layout GL reads indirect draws in from GL_DRAW_INDIRECT_BUFFER
+    struct DrawElementsIndirectCommand
+    {
+        uint32_t Count;
+        uint32_t InstanceCount;
+        uint32_t FirstIndex;
+        int32_t BaseVertex;
+        uint32_t BaseInstance;
+    };
+
+    // What BatchedDiffuseModel.glsl knows about a submitted model, fetched from a buffer texture as 8 vec4s
+    struct BatchDrawData
+    {
+        // model * dequantize
+        glm::mat4 PositionTransform;
+
+        // The inverse transpose of the model matrix's upper 3x3, one column per vec4
+        glm::vec4 NormalMatrix[3];
+
+        glm::vec4 Color;
+    };
+
+    // Draws any number of pooled models with one glMultiDrawElementsIndirect per pool vertex array instead of
+    // a draw call (and a round of uniform updates) per model.
+    //
+    // Every index chunk of a submitted model becomes a DrawElementsIndirectCommand whose base instance is the
+    // model's index in the draw data. The pool's vertex arrays get an instanced attribute (location 3) reading
+    // an identity buffer, so the shader sees that index as `ia_DrawID` and fetches the model's transforms and
+    // color from a buffer texture. GL 4.2 has neither gl_DrawID nor shader storage buffers, which is why it
+    // goes through the base instance and a buffer texture. Without glMultiDrawElementsIndirect the commands are
+    // issued one by one with glDrawElementsIndirect, which still saves the per model uniform updates
+    class BatchRenderer
+    {
+    public:
+        // The texture unit the draw data is bound to while flushing
+        static constexpr int DRAW_DATA_TEXTURE_UNIT = 1;
+
+        BatchRenderer();
+        ~BatchRenderer();
+
+        BatchRenderer(const BatchRenderer&) = delete;
+        BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+        // Forgets the models submitted since the last Begin()
+        void Begin();
+
+        // Adds a model to the batch. Only pooled models with an index buffer can be batched, others are skipped
+        void Submit(const Model& model, const glm::mat4& transform, const glm::vec3& color);
+
+        // Uploads the commands and draw data and draws everything submitted since Begin() with `shader`, which
+        // has to take its inputs like BatchedDiffuseModel.glsl does. Sets u_DrawData, the FrameConstants (see
+        // ShaderConstants) have to be set already. The submitted models stay until the next Begin()
+        void Flush(Shader& shader);
+
+        inline size_t GetSubmittedModelCount()  const { return m_DrawData.size(); }
+
+        // Of the last Flush()
+        inline size_t GetCommandCount()         const { return m_CommandCount;    }
+        inline size_t GetDrawCallCount()        const { return m_DrawCallCount;   }
+
+    private:
+        // The commands drawn from one of a pool's vertex arrays
+        struct Batch
+        {
+            std::shared_ptr<GeometryPool> Pool;
+            VertexFormat Format;
+            std::vector<DrawElementsIndirectCommand> Commands;
+        };
+
+        Batch& GetBatch(const std::shared_ptr<GeometryPool>& pool, VertexFormat format);
+
+        // Makes sure the draw ID buffer holds at least `count` entries
+        void ReserveDrawIDs(size_t count);
+
+    private:
+        std::vector<Batch> m_Batches;
+        std::vector<BatchDrawData> m_DrawData;
+
+        // All the batches' commands, back to back, as uploaded
+        std::vector<DrawElementsIndirectCommand> m_Commands;
+
+        uint m_IndirectBuffer = 0;
+        uint m_DrawDataBuffer = 0;
+        uint m_DrawDataTexture = 0;
+
+        // 0, 1, 2, ... read per instance, so that each draw sees its base instance
+        VertexBuffer m_DrawIDs;
+        size_t m_DrawIDCapacity = 0;
+
+        size_t m_CommandCount = 0;
+        size_t m_DrawCallCount = 0;
+        bool m_WarnedUnbatchable = false;
+    };
+}
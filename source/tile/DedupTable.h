@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace Tile
+{
+    // An open addressing (linear probing) hash table that maps keys to the sequential index they were
+    // first inserted with. It is meant for deduplicating a stream of keys into an array of unique keys.
+    //
+    // The table does not store the keys themselves, only their index and 32 bits of their hash, so a slot
+    // is 8 bytes and there are no per-entry allocations. The keys live in the caller's array of uniques,
+    // which has to be passed to every FindOrInsert() call and must hold the key for every index handed out
+    // so far (i.e when a key is inserted, the caller appends it to its array before the next call).
+    template <typename Key, typename KeyHash, typename KeyEqual = std::equal_to<Key>>
+    class DedupTable
+    {
+    public:
+        struct Result
+        {
+            uint32_t Index;
+            bool Inserted;
+        };
+
+        // Removes every entry but keeps the allocated slots
+        void Clear()
+        {
+            for (auto& slot : m_Slots)
+                slot.Index = EMPTY;
+            m_Count = 0;
+        }
+
+        // Makes room for `count` unique keys without having to grow
+        void Reserve(size_t count)
+        {
+            size_t slotCount = MIN_SLOTS;
+            while (slotCount * MAX_LOAD_NUM < count * MAX_LOAD_DEN)
+                slotCount *= 2;
+
+            if (slotCount > m_Slots.size())
+                Rehash(slotCount);
+        }
+
+        inline size_t GetCount() const { return m_Count; }
+
+        // Returns the index of `key` in `uniques` if it has been inserted before. Otherwise the key is given
+        // the next index (GetCount() before the call) and the caller is expected to append it to `uniques`
+        Result FindOrInsert(const Key& key, const Key* uniques)
+        {
+            if ((m_Count + 1) * MAX_LOAD_DEN > m_Slots.size() * MAX_LOAD_NUM)
+                Rehash(m_Slots.empty() ? MIN_SLOTS : m_Slots.size() * 2);
+
+            uint32_t hash = static_cast<uint32_t>(m_Hash(key));
+            size_t mask = m_Slots.size() - 1;
+
+            for (size_t i = hash & mask;; i = (i + 1) & mask)
+            {
+                Slot& slot = m_Slots[i];
+
+                if (slot.Index == EMPTY)
+                {
+                    slot.Hash = hash;
+                    slot.Index = static_cast<uint32_t>(m_Count++);
+                    return { slot.Index, true };
+                }
+
+                if (slot.Hash == hash && m_Equal(uniques[slot.Index], key))
+                    return { slot.Index, false };
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t Hash;
+            uint32_t Index;
+        };
+
+        // Only the stored hashes are needed to move the entries around, not the keys
+        void Rehash(size_t slotCount)
+        {
+            std::vector<Slot> oldSlots(slotCount, Slot { 0, EMPTY });
+            oldSlots.swap(m_Slots);
+
+            size_t mask = slotCount - 1;
+            for (const auto& slot : oldSlots)
+            {
+                if (slot.Index == EMPTY)
+                    continue;
+
+                size_t i = slot.Hash & mask;
+                while (m_Slots[i].Index != EMPTY)
+                    i = (i + 1) & mask;
+
+                m_Slots[i] = slot;
+            }
+        }
+
+    private:
+        static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+        static constexpr size_t MIN_SLOTS = 16;
+
+        // Grow once the table is more than 5/8 full. Linear probing degrades quickly above that
+        static constexpr size_t MAX_LOAD_NUM = 5;
+        static constexpr size_t MAX_LOAD_DEN = 8;
+
+        std::vector<Slot> m_Slots;
+        size_t m_Count = 0;
+
+        KeyHash m_Hash;
+        KeyEqual m_Equal;
+    };
+}
@@ -0,0 +1,278 @@
+#include "tile/GeometryPool.h"
+#include "tile/GlState.h"
+#include "tile/Model.h"
+#include "tile/VertexQuantization.h"
+#include "tile/gl_extensions.h"
+#include "tile/opengl_inc.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    using namespace Tile;
+
+    const VertexLayout& format_layout(VertexFormat format)
+    {
+        return format == VertexFormat::Quantized ? QUANTIZED_VERTEX_LAYOUT : VERTEX_LAYOUT;
+    }
+
+    // The capacity to grow to so that `required` more items fit in the added space alone, doubling to keep the
+    // number of copies low
+    uint32_t grown_capacity(uint32_t capacity, uint32_t required)
+    {
+        uint64_t grown = std::max<uint64_t>(capacity, 1);
+        while (grown - capacity < required)
+            grown *= 2;
+
+        return static_cast<uint32_t>(std::min<uint64_t>(grown, OffsetAllocator::NO_SPACE - 1));
+    }
+
+    void copy_buffer(uint source, uint target, size_t size)
+    {
+        const GlExtensions& extensions = GetGlExtensions();
+        if (extensions.DirectStateAccess)
+        {
+            extensions.glCopyNamedBufferSubData(source, target, 0, 0, size);
+            return;
+        }
+
+        GetGlState().BindBuffer(gl::GL_COPY_READ_BUFFER, source);
+        GetGlState().BindBuffer(gl::GL_COPY_WRITE_BUFFER, target);
+        gl::glCopyBufferSubData(gl::GL_COPY_READ_BUFFER, gl::GL_COPY_WRITE_BUFFER, 0, 0, size);
+    }
+}
+
+namespace Tile
+{
+    /* ============================================================================================================ */
+    /* ============================================== Offset Allocator ============================================ */
+    /* ============================================================================================================ */
+
+    OffsetAllocator::OffsetAllocator(uint32_t size)
+    :   m_Size(0),
+        m_FreeSpace(0)
+    {
+        Grow(size);
+    }
+
+    uint32_t OffsetAllocator::Allocate(uint32_t size)
+    {
+        if (size == 0)
+            return NO_SPACE;
+
+        auto bestFit = m_FreeBySize.lower_bound(size);
+        if (bestFit == m_FreeBySize.end())
+            return NO_SPACE;
+
+        uint32_t offset = bestFit->second;
+        uint32_t rangeSize = bestFit->first;
+
+        RemoveFreeRange(m_FreeByOffset.find(offset));
+        if (rangeSize > size)
+            AddFreeRange(offset + size, rangeSize - size);
+
+        m_FreeSpace -= size;
+        return offset;
+    }
+
+    void OffsetAllocator::Free(uint32_t offset, uint32_t size)
+    {
+        if (size == 0)
+            return;
+
+        m_FreeSpace += size;
+
+        // Merge with the free ranges right after and right before
+        auto next = m_FreeByOffset.lower_bound(offset);
+        if (next != m_FreeByOffset.end() && next->first == offset + size)
+        {
+            size += next->second;
+            next = std::next(next);
+            RemoveFreeRange(std::prev(next));
+        }
+
+        if (next != m_FreeByOffset.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size += previous->second;
+                RemoveFreeRange(previous);
+            }
+        }
+
+        AddFreeRange(offset, size);
+    }
+
+    void OffsetAllocator::Grow(uint32_t size)
+    {
+        if (size <= m_Size)
+            return;
+
+        uint32_t oldSize = m_Size;
+        m_Size = size;
+        Free(oldSize, size - oldSize);
+    }
+
+    uint32_t OffsetAllocator::GetLargestFreeRange() const
+    {
+        return m_FreeBySize.empty() ? 0 : std::prev(m_FreeBySize.end())->first;
+    }
+
+    void OffsetAllocator::AddFreeRange(uint32_t offset, uint32_t size)
+    {
+        m_FreeByOffset.emplace(offset, size);
+        m_FreeBySize.emplace(size, offset);
+    }
+
+    void OffsetAllocator::RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator range)
+    {
+        auto sizes = m_FreeBySize.equal_range(range->second);
+        for (auto it = sizes.first; it != sizes.second; ++it)
+        {
+            if (it->second == range->first)
+            {
+                m_FreeBySize.erase(it);
+                break;
+            }
+        }
+
+        m_FreeByOffset.erase(range);
+    }
+
+    /* ============================================================================================================ */
+    /* =============================================== Geometry Pool ============================================== */
+    /* ============================================================================================================ */
+
+    GeometryPool::GeometryPool(uint32_t initialVertexCapacity, uint32_t initialIndexCapacity)
+    :   m_Formats { FormatStorage(initialVertexCapacity), FormatStorage(initialVertexCapacity) },
+        m_IndexBuffer(std::make_unique<IndexBuffer>()),
+        m_IndexAllocator(initialIndexCapacity)
+    {
+        for (int i = 0; i < VERTEX_FORMAT_COUNT; i++)
+        {
+            VertexFormat format = static_cast<VertexFormat>(i);
+            FormatStorage& storage = m_Formats[i];
+
+            storage.Buffer = std::make_unique<VertexBuffer>();
+            storage.Buffer->SetData(nullptr, GetVertexSize(format) * initialVertexCapacity);
+            storage.VA.AddVertexBuffer(*storage.Buffer, format_layout(format));
+            storage.VA.AddIndexBuffer(*m_IndexBuffer);
+        }
+
+        // Attached to the last vertex array bound above, and to the others already
+        m_IndexBuffer->SetIndices(static_cast<const uint16_t*>(nullptr), sizeof(uint16_t) * initialIndexCapacity);
+        GetGlState().BindVertexArray(0);
+    }
+
+    GeometryAllocation GeometryPool::Allocate(VertexFormat format, const void* vertices, uint32_t vertexCount,
+                                              const uint16_t* indices, uint32_t indexCount)
+    {
+        GeometryAllocation allocation;
+        allocation.Format = format;
+        allocation.VertexCount = vertexCount;
+        allocation.IndexCount = indexCount;
+
+        FormatStorage& storage = m_Formats[static_cast<int>(format)];
+        size_t vertexSize = GetVertexSize(format);
+
+        if (vertexCount > 0)
+        {
+            ReserveVertices(format, vertexCount);
+            allocation.FirstVertex = storage.Allocator.Allocate(vertexCount);
+            storage.Buffer->SetSubData(vertices, vertexSize * allocation.FirstVertex, vertexSize * vertexCount);
+        }
+
+        if (indexCount > 0)
+        {
+            ReserveIndices(indexCount);
+            allocation.FirstIndex = m_IndexAllocator.Allocate(indexCount);
+            m_IndexBuffer->SetSubData(indices, sizeof(uint16_t) * allocation.FirstIndex, sizeof(uint16_t) * indexCount);
+        }
+
+        return allocation;
+    }
+
+    void GeometryPool::Free(const GeometryAllocation& allocation)
+    {
+        m_Formats[static_cast<int>(allocation.Format)].Allocator.Free(allocation.FirstVertex, allocation.VertexCount);
+        m_IndexAllocator.Free(allocation.FirstIndex, allocation.IndexCount);
+    }
+
+    void GeometryPool::AddInstanceAttributes(const VertexBuffer& buffer, const VertexLayout& layout)
+    {
+        for (FormatStorage& storage : m_Formats)
+            storage.VA.AddVertexBuffer(buffer, layout);
+
+        GetGlState().BindVertexArray(0);
+    }
+
+    size_t GeometryPool::GetCapacityBytes() const
+    {
+        size_t bytes = sizeof(uint16_t) * m_IndexAllocator.GetSize();
+        for (int i = 0; i < VERTEX_FORMAT_COUNT; i++)
+            bytes += GetVertexSize(static_cast<VertexFormat>(i)) * m_Formats[i].Allocator.GetSize();
+
+        return bytes;
+    }
+
+    size_t GeometryPool::GetUsedBytes() const
+    {
+        size_t bytes = sizeof(uint16_t) * (m_IndexAllocator.GetSize() - m_IndexAllocator.GetFreeSpace());
+        for (int i = 0; i < VERTEX_FORMAT_COUNT; i++)
+        {
+            const OffsetAllocator& allocator = m_Formats[i].Allocator;
+            bytes += GetVertexSize(static_cast<VertexFormat>(i)) * (allocator.GetSize() - allocator.GetFreeSpace());
+        }
+
+        return bytes;
+    }
+
+    size_t GeometryPool::GetVertexSize(VertexFormat format)
+    {
+        return format == VertexFormat::Quantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+    }
+
+    void GeometryPool::ReserveVertices(VertexFormat format, uint32_t count)
+    {
+        FormatStorage& storage = m_Formats[static_cast<int>(format)];
+        if (storage.Allocator.GetLargestFreeRange() >= count)
+            return;
+
+        uint32_t capacity = storage.Allocator.GetSize();
+        uint32_t newCapacity = grown_capacity(capacity, count);
+        size_t vertexSize = GetVertexSize(format);
+
+        auto buffer = std::make_unique<VertexBuffer>();
+        buffer->SetData(nullptr, vertexSize * newCapacity);
+        copy_buffer(storage.Buffer->GetID(), buffer->GetID(), vertexSize * capacity);
+
+        storage.VA.AddVertexBuffer(*buffer, format_layout(format));
+        GetGlState().BindVertexArray(0);
+
+        storage.Buffer = std::move(buffer);
+        storage.Allocator.Grow(newCapacity);
+    }
+
+    void GeometryPool::ReserveIndices(uint32_t count)
+    {
+        if (m_IndexAllocator.GetLargestFreeRange() >= count)
+            return;
+
+        uint32_t capacity = m_IndexAllocator.GetSize();
+        uint32_t newCapacity = grown_capacity(capacity, count);
+
+        auto buffer = std::make_unique<IndexBuffer>();
+        for (FormatStorage& storage : m_Formats)
+            storage.VA.AddIndexBuffer(*buffer);
+
+        buffer->SetIndices(static_cast<const uint16_t*>(nullptr), sizeof(uint16_t) * newCapacity);
+        copy_buffer(m_IndexBuffer->GetID(), buffer->GetID(), sizeof(uint16_t) * capacity);
+        GetGlState().BindVertexArray(0);
+
+        m_IndexBuffer = std::move(buffer);
+        m_IndexAllocator.Grow(newCapacity);
+    }
+}
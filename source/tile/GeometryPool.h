@@ -0,0 +1,132 @@
+#pragma once
+
+#include "tile/gl_wrappers.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+
+namespace Tile
+{
+    // Hands out ranges of a linear space, e.g the vertices or indices of a GPU buffer. Free ranges are kept
+    // coalesced, and allocations take the smallest free range they fit in (best fit)
+    class OffsetAllocator
+    {
+    public:
+        static constexpr uint32_t NO_SPACE = std::numeric_limits<uint32_t>::max();
+
+        explicit OffsetAllocator(uint32_t size);
+
+        // Returns the offset of the range or NO_SPACE if no free range is large enough
+        uint32_t Allocate(uint32_t size);
+        void Free(uint32_t offset, uint32_t size);
+
+        // Adds [old size, `size`) to the free space
+        void Grow(uint32_t size);
+
+        inline uint32_t GetSize()       const { return m_Size;      }
+        inline uint32_t GetFreeSpace()  const { return m_FreeSpace; }
+
+        // The largest allocation that can currently succeed
+        uint32_t GetLargestFreeRange() const;
+
+    private:
+        void AddFreeRange(uint32_t offset, uint32_t size);
+        void RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator range);
+
+    private:
+        uint32_t m_Size;
+        uint32_t m_FreeSpace;
+
+        // offset -> size, and size -> offset for the best fit lookup
+        std::map<uint32_t, uint32_t> m_FreeByOffset;
+        std::multimap<uint32_t, uint32_t> m_FreeBySize;
+    };
+
+    // The vertex formats a GeometryPool stores, each in its own vertex buffer with its own vertex array
+    enum class VertexFormat
+    {
+        // Tile::Vertex, VERTEX_LAYOUT
+        Full,
+
+        // Tile::QuantizedVertex, QUANTIZED_VERTEX_LAYOUT
+        Quantized
+    };
+
+    constexpr int VERTEX_FORMAT_COUNT = 2;
+
+    // Where a mesh lives in a GeometryPool
+    struct GeometryAllocation
+    {
+        VertexFormat Format = VertexFormat::Full;
+
+        uint32_t FirstVertex = 0;
+        uint32_t VertexCount = 0;
+
+        uint32_t FirstIndex = 0;
+        uint32_t IndexCount = 0;
+    };
+
+    // Large shared vertex and index buffers that meshes are sub-allocated from, so that any number of models
+    // are drawn from the same vertex array (one per VertexFormat) instead of each binding its own.
+    //
+    // Indices are 16 bit and relative to a base vertex, meshes with more vertices are split into chunks first
+    // (see SplitIntoShortIndexChunks()). The buffers grow (by copying on the GPU) when they run out of space;
+    // the vertex arrays stay the same objects, so the ones handed out remain valid
+    class GeometryPool
+    {
+    public:
+        GeometryPool(uint32_t initialVertexCapacity = 1 << 18, uint32_t initialIndexCapacity = 1 << 20);
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        // Copies `vertexCount` vertices of the given format and the indices into the pool
+        GeometryAllocation Allocate(VertexFormat format, const void* vertices, uint32_t vertexCount,
+                                    const uint16_t* indices, uint32_t indexCount);
+
+        void Free(const GeometryAllocation& allocation);
+
+        // Adds attributes sourced from `buffer` to the vertex arrays of all formats, meant for per instance ones
+        // like the draw index BatchRenderer passes through the base instance. Their locations must not clash
+        // with the vertex layouts'. The arrays keep them when the pool grows
+        void AddInstanceAttributes(const VertexBuffer& buffer, const VertexLayout& layout);
+
+        inline const VertexArray& GetVA(VertexFormat format) const { return m_Formats[static_cast<int>(format)].VA; }
+        inline const IndexBuffer& GetIndexBuffer()            const { return *m_IndexBuffer; }
+
+        // Replaced when the pool grows
+        inline const VertexBuffer& GetVertexBuffer(VertexFormat format) const
+        {
+            return *m_Formats[static_cast<int>(format)].Buffer;
+        }
+
+        // Bytes of GPU memory taken up by the buffers and by the allocations in them
+        size_t GetCapacityBytes() const;
+        size_t GetUsedBytes() const;
+
+        static size_t GetVertexSize(VertexFormat format);
+
+    private:
+        struct FormatStorage
+        {
+            VertexArray VA;
+            std::unique_ptr<VertexBuffer> Buffer;
+            OffsetAllocator Allocator;
+
+            explicit FormatStorage(uint32_t capacity) : Allocator(capacity) {}
+        };
+
+        // Makes room for at least `count` more vertices (indices) in a single range
+        void ReserveVertices(VertexFormat format, uint32_t count);
+        void ReserveIndices(uint32_t count);
+
+    private:
+        FormatStorage m_Formats[VERTEX_FORMAT_COUNT];
+
+        std::unique_ptr<IndexBuffer> m_IndexBuffer;
+        OffsetAllocator m_IndexAllocator;
+    };
+}
@@ -0,0 +1,238 @@
+#include "tile/GlState.h"
+#include "tile/gl_extensions.h"
+#include "tile/opengl_inc.h"
+
+namespace
+{
+    using namespace Tile;
+
+    GlStateCache s_GlState;
+
+    // Index of the target in GlStateCache's buffer shadow, -1 for targets it passes on
+    int buffer_target_slot(unsigned int target)
+    {
+        switch (target)
+        {
+        case gl::GL_ARRAY_BUFFER:           return 0;
+        case gl::GL_COPY_READ_BUFFER:       return 1;
+        case gl::GL_COPY_WRITE_BUFFER:      return 2;
+        case gl::GL_TEXTURE_BUFFER:         return 3;
+        case gl::GL_DRAW_INDIRECT_BUFFER:   return 4;
+        case gl::GL_UNIFORM_BUFFER:         return 5;
+        case gl::GL_PIXEL_UNPACK_BUFFER:    return 6;
+
+        default:
+            return -1;
+        }
+    }
+
+    int texture_target_slot(unsigned int target)
+    {
+        switch (target)
+        {
+        case gl::GL_TEXTURE_2D:             return 0;
+        case gl::GL_TEXTURE_BUFFER:         return 1;
+        case gl::GL_TEXTURE_2D_ARRAY:       return 2;
+        case gl::GL_TEXTURE_CUBE_MAP:       return 3;
+
+        default:
+            return -1;
+        }
+    }
+}
+
+namespace Tile
+{
+    GlStateCache::GlStateCache()
+    {
+        Invalidate();
+    }
+
+    bool GlStateCache::Update(unsigned int& shadow, unsigned int value, StateChange kind)
+    {
+        if (m_Filtering && shadow == value)
+        {
+            m_Stats.Filtered[static_cast<int>(kind)]++;
+            return false;
+        }
+
+        shadow = value;
+        m_Stats.Issued[static_cast<int>(kind)]++;
+        return true;
+    }
+
+    void GlStateCache::UseProgram(unsigned int program)
+    {
+        if (Update(m_Program, program, StateChange::Program))
+            gl::glUseProgram(program);
+    }
+
+    void GlStateCache::BindVertexArray(unsigned int vertexArray)
+    {
+        if (Update(m_VertexArray, vertexArray, StateChange::VertexArray))
+            gl::glBindVertexArray(vertexArray);
+    }
+
+    void GlStateCache::BindBuffer(unsigned int target, unsigned int buffer)
+    {
+        int slot = buffer_target_slot(target);
+        if (slot < 0)
+        {
+            m_Stats.Issued[static_cast<int>(StateChange::Buffer)]++;
+            gl::glBindBuffer(static_cast<gl::GLenum>(target), buffer);
+            return;
+        }
+
+        if (Update(m_Buffers[slot], buffer, StateChange::Buffer))
+            gl::glBindBuffer(static_cast<gl::GLenum>(target), buffer);
+    }
+
+    void GlStateCache::BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset,
+                                       size_t size)
+    {
+        int slot = buffer_target_slot(target);
+        if (target == gl::GL_UNIFORM_BUFFER && index < UNIFORM_BUFFER_BINDING_COUNT)
+        {
+            BufferRange& range = m_UniformBufferRanges[index];
+            if (m_Filtering && range.Buffer == buffer && range.Offset == offset && range.Size == size)
+            {
+                m_Stats.Filtered[static_cast<int>(StateChange::Buffer)]++;
+                return;
+            }
+
+            range = { buffer, offset, size };
+        }
+
+        if (slot >= 0)
+            m_Buffers[slot] = buffer;
+
+        m_Stats.Issued[static_cast<int>(StateChange::Buffer)]++;
+        gl::glBindBufferRange(static_cast<gl::GLenum>(target), index, buffer, static_cast<gl::GLintptr>(offset),
+                              static_cast<gl::GLsizeiptr>(size));
+    }
+
+    void GlStateCache::BindTexture(int unit, unsigned int target, unsigned int texture)
+    {
+        int slot = texture_target_slot(target);
+        if (slot < 0 || unit < 0 || unit >= TEXTURE_UNIT_COUNT)
+        {
+            SetActiveTexture(unit);
+            m_Stats.Issued[static_cast<int>(StateChange::Texture)]++;
+            gl::glBindTexture(static_cast<gl::GLenum>(target), texture);
+            return;
+        }
+
+        if (!Update(m_Textures[unit][slot], texture, StateChange::Texture))
+            return;
+
+        // glBindTextureUnit(unit, 0) would unbind every target of the unit, so unbinding goes the old way
+        const GlExtensions& extensions = GetGlExtensions();
+        if (extensions.DirectStateAccess && texture != 0)
+        {
+            extensions.glBindTextureUnit(unit, texture);
+            return;
+        }
+
+        SetActiveTexture(unit);
+        gl::glBindTexture(static_cast<gl::GLenum>(target), texture);
+    }
+
+    void GlStateCache::SetActiveTexture(int unit)
+    {
+        if (Update(m_ActiveTexture, static_cast<unsigned int>(unit), StateChange::ActiveTexture))
+            gl::glActiveTexture(static_cast<gl::GLenum>(gl::GL_TEXTURE0 + unit));
+    }
+
+    void GlStateCache::SetCapability(unsigned int capability, bool enabled)
+    {
+        unsigned int* shadow = nullptr;
+        for (auto& [cap, state] : m_Capabilities)
+        {
+            if (cap == capability)
+            {
+                shadow = &state;
+                break;
+            }
+        }
+
+        if (!shadow)
+        {
+            m_Capabilities.emplace_back(capability, UNKNOWN);
+            shadow = &m_Capabilities.back().second;
+        }
+
+        if (!Update(*shadow, enabled ? 1u : 0u, StateChange::Capability))
+            return;
+
+        if (enabled)
+            gl::glEnable(static_cast<gl::GLenum>(capability));
+        else
+            gl::glDisable(static_cast<gl::GLenum>(capability));
+    }
+
+    void GlStateCache::OnProgramDeleted(unsigned int program)
+    {
+        if (m_Program == program)
+            m_Program = UNKNOWN;
+    }
+
+    void GlStateCache::OnVertexArrayDeleted(unsigned int vertexArray)
+    {
+        if (m_VertexArray == vertexArray)
+            m_VertexArray = 0;
+    }
+
+    void GlStateCache::OnBufferDeleted(unsigned int buffer)
+    {
+        for (unsigned int& bound : m_Buffers)
+        {
+            if (bound == buffer)
+                bound = 0;
+        }
+
+        for (BufferRange& range : m_UniformBufferRanges)
+        {
+            if (range.Buffer == buffer)
+                range.Buffer = UNKNOWN;
+        }
+    }
+
+    void GlStateCache::OnTextureDeleted(unsigned int texture)
+    {
+        for (auto& unit : m_Textures)
+        {
+            for (unsigned int& bound : unit)
+            {
+                if (bound == texture)
+                    bound = 0;
+            }
+        }
+    }
+
+    void GlStateCache::Invalidate()
+    {
+        m_Program = UNKNOWN;
+        m_VertexArray = UNKNOWN;
+        m_ActiveTexture = UNKNOWN;
+
+        for (unsigned int& bound : m_Buffers)
+            bound = UNKNOWN;
+
+        for (BufferRange& range : m_UniformBufferRanges)
+            range.Buffer = UNKNOWN;
+
+        for (auto& unit : m_Textures)
+        {
+            for (unsigned int& bound : unit)
+                bound = UNKNOWN;
+        }
+
+        for (auto& capability : m_Capabilities)
+            capability.second = UNKNOWN;
+    }
+
+    GlStateCache& GetGlState()
+    {
+        return s_GlState;
+    }
+}
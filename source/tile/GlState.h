@@ -0,0 +1,101 @@
+#pragma once
+
+#include "tile/RenderStats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Tile
+{
+    // Shadows the GL state the Tile wrappers change (bound program, vertex array, buffers, textures per unit and
+    // capabilities) and skips the calls that would not change it. Everything that binds or enables any of it
+    // has to go through here, or the shadow goes stale; Invalidate() after code that does not (e.g a UI library).
+    //
+    // GL_ELEMENT_ARRAY_BUFFER belongs to the bound vertex array, so binding it is always passed on, as are
+    // buffer and texture targets the cache does not know
+    class GlStateCache
+    {
+    public:
+        static constexpr int TEXTURE_UNIT_COUNT = 32;
+        static constexpr int UNIFORM_BUFFER_BINDING_COUNT = 16;
+
+        GlStateCache();
+
+        void UseProgram(unsigned int program);
+        void BindVertexArray(unsigned int vertexArray);
+        void BindBuffer(unsigned int target, unsigned int buffer);
+
+        // glBindBufferRange, which also binds the buffer to `target` itself. Only GL_UNIFORM_BUFFER's indexed
+        // bindings are tracked
+        void BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset,
+                             size_t size);
+
+        // Through glBindTextureUnit when available, which leaves the active texture unit alone
+        void BindTexture(int unit, unsigned int target, unsigned int texture);
+        void SetActiveTexture(int unit);
+
+        void SetCapability(unsigned int capability, bool enabled);
+        inline void Enable(unsigned int capability)  { SetCapability(capability, true);  }
+        inline void Disable(unsigned int capability) { SetCapability(capability, false); }
+
+        inline int GetActiveTexture() const { return m_ActiveTexture == UNKNOWN ? 0 : m_ActiveTexture; }
+
+        // Deleted objects are unbound by GL, the shadow has to follow
+        void OnProgramDeleted(unsigned int program);
+        void OnVertexArrayDeleted(unsigned int vertexArray);
+        void OnBufferDeleted(unsigned int buffer);
+        void OnTextureDeleted(unsigned int texture);
+
+        // Forgets everything, so that the next change of anything reaches GL. Needed for every new context
+        void Invalidate();
+
+        // When disabled every call reaches GL (and counts as issued), e.g to compare
+        inline void SetFiltering(bool enabled) { m_Filtering = enabled; }
+        inline bool IsFiltering() const { return m_Filtering; }
+
+        // For the state that is shadowed elsewhere (the uniform values of Shader), so that it shows up in the stats
+        inline void CountStateChange(StateChange kind, bool issued)
+        {
+            (issued ? m_Stats.Issued : m_Stats.Filtered)[static_cast<int>(kind)]++;
+        }
+
+        inline const RenderStats& GetStats() const { return m_Stats; }
+        inline void ResetStats() { m_Stats = RenderStats(); }
+
+    private:
+        // Whether a change of `shadow` to `value` has to be issued, updating the shadow and the counters
+        bool Update(unsigned int& shadow, unsigned int value, StateChange kind);
+
+    private:
+        static constexpr unsigned int UNKNOWN = 0xFFFFFFFFu;
+
+        struct BufferRange
+        {
+            unsigned int Buffer;
+            size_t Offset;
+            size_t Size;
+        };
+
+        static constexpr int BUFFER_TARGET_COUNT = 7;
+        static constexpr int TEXTURE_TARGET_COUNT = 4;
+
+        unsigned int m_Program;
+        unsigned int m_VertexArray;
+        unsigned int m_Buffers[BUFFER_TARGET_COUNT];
+        BufferRange m_UniformBufferRanges[UNIFORM_BUFFER_BINDING_COUNT];
+
+        unsigned int m_ActiveTexture;
+        unsigned int m_Textures[TEXTURE_UNIT_COUNT][TEXTURE_TARGET_COUNT];
+
+        // (capability, 0 / 1 or UNKNOWN), in the order they were first used
+        std::vector<std::pair<unsigned int, unsigned int>> m_Capabilities;
+
+        bool m_Filtering = true;
+        RenderStats m_Stats;
+    };
+
+    // The state of the (one) context
+    GlStateCache& GetGlState();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Tile
+{
+    // A fast non-cryptographic 64 bit hash for (possibly large) blobs of memory, e.g whole files.
+    //
+    // Four independent lanes of 8 bytes each are mixed per round, so the multiplies do not wait on
+    // each other. The lanes are folded together and run through the splitmix64 finalizer at the end.
+    inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0)
+    {
+        constexpr uint64_t PRIME_A = 0x9E3779B97F4A7C15ull;
+        constexpr uint64_t PRIME_B = 0xBF58476D1CE4E5B9ull;
+
+        auto mix = [](uint64_t lane, uint64_t word) {
+            lane ^= word * PRIME_B;
+            lane = (lane << 31) | (lane >> 33);
+            return lane * PRIME_A;
+        };
+
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t lanes[4] = { seed + PRIME_A, seed + PRIME_B, seed, seed - PRIME_A };
+
+        while (size >= 32)
+        {
+            uint64_t words[4];
+            std::memcpy(words, bytes, 32);
+
+            lanes[0] = mix(lanes[0], words[0]);
+            lanes[1] = mix(lanes[1], words[1]);
+            lanes[2] = mix(lanes[2], words[2]);
+            lanes[3] = mix(lanes[3], words[3]);
+
+            bytes += 32;
+            size -= 32;
+        }
+
+        uint64_t hash = lanes[0] ^ ((lanes[1] << 7) | (lanes[1] >> 57)) ^ ((lanes[2] << 13) | (lanes[2] >> 51)) ^
+                        ((lanes[3] << 19) | (lanes[3] >> 45));
+
+        while (size >= 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes, 8);
+            hash = mix(hash, word);
+
+            bytes += 8;
+            size -= 8;
+        }
+
+        uint64_t tail = 0;
+        std::memcpy(&tail, bytes, size);
+        hash = mix(hash, tail ^ (static_cast<uint64_t>(size) << 56));
+
+        // splitmix64 finalizer
+        hash ^= hash >> 30;
+        hash *= PRIME_B;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+        return hash;
+    }
+}
@@ -0,0 +1,83 @@
+#include "tile/Instancing.h"
+#include "tile/opengl_inc.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Tile
+{
+    // A mat4 attribute takes 4 consecutive locations, one per column
+    const VertexLayout MATRIX_INSTANCE_LAYOUT = {
+        {4, "ia_InstanceTransform",     4, VertAttribComponentType::Float, false, 1},
+        {5, "ia_InstanceTransform",     4, VertAttribComponentType::Float, false, 1},
+        {6, "ia_InstanceTransform",     4, VertAttribComponentType::Float, false, 1},
+        {7, "ia_InstanceTransform",     4, VertAttribComponentType::Float, false, 1},
+        {8, "ia_InstanceColor",         4, VertAttribComponentType::Float, false, 1},
+    };
+
+    const VertexLayout TRS_INSTANCE_LAYOUT = {
+        {4, "ia_InstanceTranslationScale",  4, VertAttribComponentType::Float, false, 1},
+        {5, "ia_InstanceRotation",          4, VertAttribComponentType::Float, false, 1},
+        {6, "ia_InstanceColor",             4, VertAttribComponentType::UByte, true,  1},
+    };
+
+    static_assert(sizeof(MatrixInstance) == 20 * sizeof(float), "MatrixInstance is expected to be tightly packed");
+    static_assert(sizeof(TRSInstance) == 9 * sizeof(uint32_t), "TRSInstance is expected to be tightly packed");
+
+    uint32_t PackColorRGBA8(const glm::vec4& color)
+    {
+        uint32_t packed = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            auto component = static_cast<uint32_t>(std::clamp(color[i], 0.f, 1.f) * 255.f + 0.5f);
+            packed |= component << (8 * i);
+        }
+
+        return packed;
+    }
+
+    InstanceBuffer::InstanceBuffer(InstanceFormat format)
+    :   m_Format(format)
+    {}
+
+    void InstanceBuffer::SetInstances(const MatrixInstance* instances, size_t count)
+    {
+        if (m_Format != InstanceFormat::Matrix)
+        {
+            std::cerr << "[ERROR] Setting matrix instances on an instance buffer of another format" << std::endl;
+            return;
+        }
+
+        SetData(instances, sizeof(MatrixInstance) * count, count);
+    }
+
+    void InstanceBuffer::SetInstances(const TRSInstance* instances, size_t count)
+    {
+        if (m_Format != InstanceFormat::TRS)
+        {
+            std::cerr << "[ERROR] Setting TRS instances on an instance buffer of another format" << std::endl;
+            return;
+        }
+
+        SetData(instances, sizeof(TRSInstance) * count, count);
+    }
+
+    const VertexLayout& InstanceBuffer::GetLayout() const
+    {
+        return m_Format == InstanceFormat::Matrix ? MATRIX_INSTANCE_LAYOUT : TRS_INSTANCE_LAYOUT;
+    }
+
+    void InstanceBuffer::SetData(const void* data, size_t size, size_t count)
+    {
+        m_InstanceCount = count;
+
+        if (size > m_CapacityBytes)
+        {
+            m_CapacityBytes = std::max(size, 2 * m_CapacityBytes);
+            m_Buffer.SetData(nullptr, m_CapacityBytes, gl::GL_DYNAMIC_DRAW);
+        }
+
+        if (size > 0)
+            m_Buffer.SetSubData(data, 0, size);
+    }
+}
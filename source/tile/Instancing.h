@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tile/gl_wrappers.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace Tile
+{
+    // The formats of per instance data Model::DrawInstanced() draws with. Their attributes start at location 4
+    // (0 to 2 are the vertex's, 3 is BatchRenderer's draw index)
+    enum class InstanceFormat
+    {
+        // MatrixInstance, MATRIX_INSTANCE_LAYOUT. Any model matrix
+        Matrix,
+
+        // TRSInstance, TRS_INSTANCE_LAYOUT. Less than half the size, but the scale is uniform
+        TRS
+    };
+
+    // 80 bytes, read by InstancedDiffuseModel.glsl
+    struct MatrixInstance
+    {
+        glm::mat4 Transform;
+        glm::vec4 Color;
+    };
+
+    // 36 bytes, read by InstancedDiffuseModelTRS.glsl. The model matrix is
+    // translate(Translation) * rotate(Rotation) * scale(Scale)
+    struct TRSInstance
+    {
+        glm::vec3 Translation;
+        float Scale;
+
+        // A unit quaternion, (x, y, z) the vector part and w the scalar one
+        glm::vec4 Rotation;
+
+        // RGBA, 8 bits each, red in the lowest byte (see PackColorRGBA8())
+        uint32_t Color;
+    };
+
+    extern const VertexLayout MATRIX_INSTANCE_LAYOUT;
+    extern const VertexLayout TRS_INSTANCE_LAYOUT;
+
+    // Clamps the components to [0, 1]
+    uint32_t PackColorRGBA8(const glm::vec4& color);
+
+    // The per instance data of instanced draws, in a vertex buffer whose attributes advance once per instance
+    class InstanceBuffer
+    {
+    public:
+        explicit InstanceBuffer(InstanceFormat format);
+
+        // Replaces the instances. The buffer only grows, so the same number of instances every frame does
+        // not reallocate it. The overload has to match the format
+        void SetInstances(const MatrixInstance* instances, size_t count);
+        void SetInstances(const TRSInstance* instances, size_t count);
+
+        inline InstanceFormat GetFormat()       const { return m_Format; }
+        inline size_t GetInstanceCount()        const { return m_InstanceCount; }
+        inline const VertexBuffer& GetBuffer()  const { return m_Buffer; }
+        const VertexLayout& GetLayout() const;
+
+    private:
+        void SetData(const void* data, size_t size, size_t count);
+
+    private:
+        InstanceFormat m_Format;
+        VertexBuffer m_Buffer;
+
+        size_t m_InstanceCount = 0;
+        size_t m_CapacityBytes = 0;
+    };
+}
@@ -0,0 +1,231 @@
+#include "tile/MappedFile.h"
+
+#include <cerrno>
+#include <cstdint>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Tile
+{
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::Open(const std::string& filepath, bool allowMapping)
+    {
+        Close();
+
+        HANDLE file = CreateFileA(filepath.c_str(),
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ,
+                                  NULL,
+                                  OPEN_EXISTING,
+                                  FILE_FLAG_SEQUENTIAL_SCAN,
+                                  NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!allowMapping || GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &fileSize))
+        {
+            bool success = ReadIntoBuffer(file);
+            CloseHandle(file);
+            return success;
+        }
+
+        if (fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return true;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (view == nullptr)
+        {
+            if (mapping)
+                CloseHandle(mapping);
+
+            bool success = ReadIntoBuffer(file);
+            CloseHandle(file);
+            return success;
+        }
+
+        m_FileHandle = file;
+        m_MappingHandle = mapping;
+        m_Mapping = view;
+        m_Data = static_cast<const char*>(view);
+        m_Size = static_cast<size_t>(fileSize.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Mapping)
+        {
+            UnmapViewOfFile(m_Mapping);
+            CloseHandle(m_MappingHandle);
+            CloseHandle(m_FileHandle);
+        }
+
+        m_Mapping = nullptr;
+        m_MappingHandle = nullptr;
+        m_FileHandle = nullptr;
+
+        std::vector<char>().swap(m_Buffer);
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    void MappedFile::Discard(const char* begin, const char* end)
+    {
+        // Windows drops unused pages of file mappings on its own
+        (void)begin;
+        (void)end;
+    }
+
+    bool MappedFile::ReadIntoBuffer(void* handle)
+    {
+        char block[64 * 1024];
+
+        while (true)
+        {
+            DWORD count = 0;
+            if (!ReadFile(static_cast<HANDLE>(handle), block, sizeof(block), &count, NULL))
+            {
+                // A pipe whose writer has gone away ends this way
+                if (GetLastError() == ERROR_BROKEN_PIPE)
+                    break;
+
+                std::vector<char>().swap(m_Buffer);
+                return false;
+            }
+
+            if (count == 0)
+                break;
+
+            m_Buffer.insert(m_Buffer.end(), block, block + count);
+        }
+
+        m_Data = m_Buffer.data();
+        m_Size = m_Buffer.size();
+        return true;
+    }
+
+#else
+
+    bool MappedFile::Open(const std::string& filepath, bool allowMapping)
+    {
+        Close();
+
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        // Pipes and such have to be read from the descriptor that is already open,
+        // reopening them would lose whatever the writer has sent so far
+        struct stat info;
+        if (!allowMapping || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            bool success = ReadIntoBuffer(fd);
+            close(fd);
+            return success;
+        }
+
+        // mmap() refuses zero sized mappings
+        if (info.st_size == 0)
+        {
+            close(fd);
+            return true;
+        }
+
+        void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping == MAP_FAILED)
+        {
+            bool success = ReadIntoBuffer(fd);
+            close(fd);
+            return success;
+        }
+
+        // The mapping keeps its own reference to the file
+        close(fd);
+
+        // Start reading the file in ahead of the parser
+        madvise(mapping, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+
+        m_Mapping = mapping;
+        m_Data = static_cast<const char*>(mapping);
+        m_Size = static_cast<size_t>(info.st_size);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Mapping)
+            munmap(m_Mapping, m_Size);
+
+        m_Mapping = nullptr;
+
+        std::vector<char>().swap(m_Buffer);
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    void MappedFile::Discard(const char* begin, const char* end)
+    {
+        if (!m_Mapping)
+            return;
+
+        // Only whole pages inside the range can be dropped
+        const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        uintptr_t first = (reinterpret_cast<uintptr_t>(begin) + pageSize - 1) & ~(pageSize - 1);
+        uintptr_t last = reinterpret_cast<uintptr_t>(end) & ~(pageSize - 1);
+
+        if (first < last)
+            madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+    }
+
+    bool MappedFile::ReadIntoBuffer(int fd)
+    {
+        char block[64 * 1024];
+
+        while (true)
+        {
+            ssize_t count = read(fd, block, sizeof(block));
+            if (count == 0)
+                break;
+
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                std::vector<char>().swap(m_Buffer);
+                return false;
+            }
+
+            m_Buffer.insert(m_Buffer.end(), block, block + count);
+        }
+
+        m_Data = m_Buffer.data();
+        m_Size = m_Buffer.size();
+        return true;
+    }
+
+#endif
+}
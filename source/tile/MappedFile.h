@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Tile
+{
+    // A read-only view over the whole contents of a file.
+    //
+    // Regular files are memory mapped so their bytes can be read in place without being copied through
+    // any stream buffers. Anything else (pipes, character devices, ...) can not be mapped, so it is read
+    // into an owned buffer instead and the view points into that.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        // Returns false if the file could not be opened or read. Without `allowMapping` even regular files are
+        // read into the buffer
+        bool Open(const std::string& filepath, bool allowMapping = true);
+        void Close();
+
+        inline const char* GetData() const  { return m_Data; }
+        inline size_t GetSize() const       { return m_Size; }
+
+        // Whether the data is memory mapped (as opposed to read into a buffer)
+        inline bool IsMapped() const { return m_Mapping != nullptr; }
+
+        // Tells the OS that [begin, end) will not be read again, so the pages backing it can be
+        // dropped from memory. Reading the range afterwards is still valid, it just faults the pages back in.
+        void Discard(const char* begin, const char* end);
+
+    private:
+        // Reads everything from an already open file descriptor (or HANDLE on Windows)
+#ifdef _WIN32
+        bool ReadIntoBuffer(void* handle);
+#else
+        bool ReadIntoBuffer(int fd);
+#endif
+
+    private:
+        const char* m_Data = nullptr;
+        size_t m_Size = 0;
+
+        void* m_Mapping = nullptr;
+        std::vector<char> m_Buffer;
+
+#ifdef _WIN32
+        void* m_FileHandle = nullptr;
+        void* m_MappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,245 @@
+#include "tile/MeshCache.h"
+#include "tile/Hash.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace
+{
+    using namespace Tile;
+
+    // Bump whenever the layout of a cache file, Vertex, or the way ModelBuilder produces its output changes
+    constexpr uint32_t CACHE_VERSION = 2;
+    constexpr char CACHE_MAGIC[4] = { 'T', 'M', 'S', 'H' };
+    constexpr size_t DATA_ALIGNMENT = 16;
+
+    // A cache file is laid out as:
+    //     CacheHeader | source path | padding up to DATA_ALIGNMENT | vertices | indices
+    struct CacheHeader
+    {
+        char Magic[4];
+        uint32_t Version;
+        uint32_t VertexSize;
+        uint32_t PathLength;
+
+        uint64_t SourceSize;
+        int64_t SourceModifiedTime;
+        uint64_t SourceContentHash;
+        uint64_t SettingsHash;
+
+        uint64_t VertexCount;
+        uint64_t IndexCount;
+    };
+
+    struct SourceStamp
+    {
+        uint64_t Size;
+        int64_t ModifiedTime;
+    };
+
+    inline size_t align_up(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    inline size_t vertex_data_offset(size_t pathLength)
+    {
+        return align_up(sizeof(CacheHeader) + pathLength, DATA_ALIGNMENT);
+    }
+
+    std::string absolute_path(const std::string& filepath)
+    {
+        std::error_code ec;
+        auto path = std::filesystem::absolute(filepath, ec);
+        return ec ? filepath : path.lexically_normal().string();
+    }
+
+    bool read_source_stamp(const std::string& filepath, SourceStamp& stamp)
+    {
+        std::error_code ec;
+        stamp.Size = std::filesystem::file_size(filepath, ec);
+        if (ec)
+            return false;
+
+        auto modified = std::filesystem::last_write_time(filepath, ec);
+        if (ec)
+            return false;
+
+        stamp.ModifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+        return true;
+    }
+
+    bool hash_file_contents(const std::string& filepath, uint64_t& hash)
+    {
+        MappedFile file;
+        if (!file.Open(filepath))
+            return false;
+
+        hash = HashBytes(file.GetData(), file.GetSize());
+        return true;
+    }
+
+    // Covers everything in the key except the source file itself
+    uint64_t hash_settings(const MeshCacheKey& key)
+    {
+        const Axis axes[6] = {
+            key.SourceSystem.RightDirection, key.SourceSystem.UpDirection, key.SourceSystem.ForwardDirection,
+            key.TargetSystem.RightDirection, key.TargetSystem.UpDirection, key.TargetSystem.ForwardDirection,
+        };
+
+        uint8_t settingBytes[13 + sizeof(float)];
+        for (int i = 0; i < 6; i++)
+        {
+            settingBytes[2 * i + 0] = static_cast<uint8_t>(axes[i].Line);
+            settingBytes[2 * i + 1] = static_cast<uint8_t>(axes[i].Sign);
+        }
+
+        settingBytes[12] = key.OptimizeVertexCache ? 1 : 0;
+        std::memcpy(&settingBytes[13], &key.OverdrawThreshold, sizeof(float));
+
+        uint64_t hash = HashBytes(settingBytes, sizeof(settingBytes));
+        return HashBytes(key.ShapeName.data(), key.ShapeName.size(), hash);
+    }
+}
+
+namespace Tile
+{
+    MeshCache::MeshCache(const std::string& directory)
+    :   m_Directory(directory)
+    {}
+
+    std::string MeshCache::GetEntryPath(const MeshCacheKey& key) const
+    {
+        std::string sourcePath = absolute_path(key.SourcePath);
+        uint64_t hash = HashBytes(sourcePath.data(), sourcePath.size(), hash_settings(key));
+
+        char name[17];
+        for (int i = 0; i < 16; i++)
+            name[i] = "0123456789abcdef"[(hash >> (60 - 4 * i)) & 0xF];
+        name[16] = '\0';
+
+        return (std::filesystem::path(m_Directory) / (std::string(name) + ".tmesh")).string();
+    }
+
+    std::unique_ptr<CachedMesh> MeshCache::Load(const MeshCacheKey& key) const
+    {
+        SourceStamp stamp;
+        if (!read_source_stamp(key.SourcePath, stamp))
+            return nullptr;
+
+        auto mesh = std::make_unique<CachedMesh>();
+        if (!mesh->m_File.Open(GetEntryPath(key)))
+            return nullptr;
+
+        const char* data = mesh->m_File.GetData();
+        size_t size = mesh->m_File.GetSize();
+
+        CacheHeader header;
+        if (size < sizeof(header))
+            return nullptr;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+            header.Version != CACHE_VERSION ||
+            header.VertexSize != sizeof(Vertex) ||
+            header.SettingsHash != hash_settings(key))
+            return nullptr;
+
+        // Guards against the (unlikely) case of two sources hashing to the same entry name
+        std::string sourcePath = absolute_path(key.SourcePath);
+        if (header.PathLength != sourcePath.size() ||
+            size < sizeof(header) + header.PathLength ||
+            std::memcmp(data + sizeof(header), sourcePath.data(), sourcePath.size()) != 0)
+            return nullptr;
+
+        if (header.SourceSize != stamp.Size)
+            return nullptr;
+
+        if (header.SourceModifiedTime != stamp.ModifiedTime)
+        {
+            uint64_t contentHash;
+            if (!hash_file_contents(key.SourcePath, contentHash) || contentHash != header.SourceContentHash)
+                return nullptr;
+        }
+
+        size_t vertexOffset = vertex_data_offset(header.PathLength);
+        size_t indexOffset = vertexOffset + sizeof(Vertex) * header.VertexCount;
+        if (size != indexOffset + sizeof(uint32_t) * header.IndexCount)
+            return nullptr;
+
+        mesh->m_Vertices = reinterpret_cast<const Vertex*>(data + vertexOffset);
+        mesh->m_VertexCount = header.VertexCount;
+        mesh->m_Indices = reinterpret_cast<const uint32_t*>(data + indexOffset);
+        mesh->m_IndexCount = header.IndexCount;
+
+        return mesh;
+    }
+
+    bool MeshCache::Store(const MeshCacheKey& key,
+                          const std::vector<Vertex>& vertices,
+                          const std::vector<uint32_t>& indices) const
+    {
+        SourceStamp stamp;
+        CacheHeader header;
+        if (!read_source_stamp(key.SourcePath, stamp) || !hash_file_contents(key.SourcePath, header.SourceContentHash))
+            return false;
+
+        std::string sourcePath = absolute_path(key.SourcePath);
+
+        std::memcpy(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.Version = CACHE_VERSION;
+        header.VertexSize = sizeof(Vertex);
+        header.PathLength = static_cast<uint32_t>(sourcePath.size());
+        header.SourceSize = stamp.Size;
+        header.SourceModifiedTime = stamp.ModifiedTime;
+        header.SettingsHash = hash_settings(key);
+        header.VertexCount = vertices.size();
+        header.IndexCount = indices.size();
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_Directory, ec);
+
+        // Written under a temporary name and renamed into place, so a reader never sees a partial entry
+        std::string entryPath = GetEntryPath(key);
+        std::string tempPath = entryPath + ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cerr << "[WARN] Could not write mesh cache entry: \"" << entryPath << "\"" << std::endl;
+                return false;
+            }
+
+            const char padding[DATA_ALIGNMENT] = {};
+            size_t paddingSize = vertex_data_offset(sourcePath.size()) - sizeof(header) - sourcePath.size();
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(sourcePath.data(), sourcePath.size());
+            file.write(padding, paddingSize);
+            file.write(reinterpret_cast<const char*>(vertices.data()), sizeof(Vertex) * vertices.size());
+            file.write(reinterpret_cast<const char*>(indices.data()), sizeof(uint32_t) * indices.size());
+
+            if (!file)
+            {
+                std::cerr << "[WARN] Could not write mesh cache entry: \"" << entryPath << "\"" << std::endl;
+                file.close();
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tempPath, entryPath, ec);
+        if (ec)
+        {
+            std::cerr << "[WARN] Could not write mesh cache entry: \"" << entryPath << "\". " << ec.message() << std::endl;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "tile/MappedFile.h"
+#include "tile/Model.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tile
+{
+    // Everything the final vertices and indices of a loaded model depend on
+    struct MeshCacheKey
+    {
+        std::string SourcePath;
+        std::string ShapeName;
+
+        CoordinateSystem3D SourceSystem;
+        CoordinateSystem3D TargetSystem;
+
+        // ModelBuilder::SetVertexCacheOptimization()
+        bool OptimizeVertexCache;
+
+        // The ACMR threshold of ModelBuilder::SetOverdrawOptimization(), 0 when it is disabled
+        float OverdrawThreshold;
+    };
+
+    // A mesh read back from the cache. The vertices and indices point straight into the memory
+    // mapped cache file, so they stay valid only as long as this object is alive
+    class CachedMesh
+    {
+    public:
+        inline const Vertex* GetVertices()      const { return m_Vertices;    }
+        inline size_t GetVertexCount()          const { return m_VertexCount; }
+
+        inline const uint32_t* GetIndices()     const { return m_Indices;     }
+        inline size_t GetIndexCount()           const { return m_IndexCount;  }
+
+    private:
+        friend class MeshCache;
+
+        MappedFile m_File;
+
+        const Vertex* m_Vertices = nullptr;
+        size_t m_VertexCount = 0;
+
+        const uint32_t* m_Indices = nullptr;
+        size_t m_IndexCount = 0;
+    };
+
+    // An on-disk cache for the output of ModelBuilder, i.e the deduplicated vertices and the index
+    // stream exactly as they are uploaded to the GPU. Every cached mesh is a single file in the cache
+    // directory, named after a hash of its source path, shape name and coordinate systems.
+    //
+    // An entry is only used if the source file still has the same size and modification time it had
+    // when the entry was stored. If only the modification time differs (the file was touched or copied)
+    // the contents are hashed and compared instead.
+    //
+    // Cache files are written in the native byte order and vertex layout, they are not meant to be
+    // moved between machines. Anything that does not match (magic, version, Vertex size) is a miss.
+    class MeshCache
+    {
+    public:
+        explicit MeshCache(const std::string& directory);
+
+        // Returns nullptr on a cache miss
+        std::unique_ptr<CachedMesh> Load(const MeshCacheKey& key) const;
+
+        // Returns false if the entry could not be written. The cache directory is created if needed
+        bool Store(const MeshCacheKey& key, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) const;
+
+        std::string GetEntryPath(const MeshCacheKey& key) const;
+
+    private:
+        std::string m_Directory;
+    };
+}
@@ -0,0 +1,474 @@
+#include "tile/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    // The LRU cache Forsyth's scoring models. Its size barely matters, as long as it is at least as large as
+    // the hardware's, so that vertices are not considered evicted too early
+    constexpr uint32_t SCORING_CACHE_SIZE = 32;
+
+    // Scoring constants from the paper
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    // Valences above this share the score of this one. Their boost is tiny anyway
+    constexpr uint32_t MAX_SCORED_VALENCE = 64;
+
+    struct ScoreTables
+    {
+        float Cache[SCORING_CACHE_SIZE];
+        float Valence[MAX_SCORED_VALENCE + 1];
+
+        ScoreTables()
+        {
+            for (uint32_t position = 0; position < SCORING_CACHE_SIZE; position++)
+            {
+                // The 3 vertices of the triangle that was just emitted get a fixed score, so that the next
+                // triangle does not simply reuse 2 of them, which would produce long thin strips
+                if (position < 3)
+                {
+                    Cache[position] = LAST_TRIANGLE_SCORE;
+                }
+                else
+                {
+                    float scaler = 1.f / (SCORING_CACHE_SIZE - 3);
+                    Cache[position] = std::pow(1.f - (position - 3) * scaler, CACHE_DECAY_POWER);
+                }
+            }
+
+            // Vertices with few triangles left get a boost, so that they are finished off instead of lingering
+            Valence[0] = 0.f;
+            for (uint32_t valence = 1; valence <= MAX_SCORED_VALENCE; valence++)
+                Valence[valence] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(valence), -VALENCE_BOOST_POWER);
+        }
+
+        float GetScore(uint32_t cachePosition, uint32_t remainingTriangles) const
+        {
+            if (remainingTriangles == 0)
+                return 0.f;
+
+            float score = cachePosition < SCORING_CACHE_SIZE ? Cache[cachePosition] : 0.f;
+            return score + Valence[std::min(remainingTriangles, MAX_SCORED_VALENCE)];
+        }
+    };
+
+    // The FIFO cache AnalyzeVertexCache() simulates. A vertex is in it if fewer than `Size` misses happened
+    // since it was last loaded
+    struct FifoCache
+    {
+        std::vector<uint32_t> LoadedAt;
+        uint32_t Misses = 0;
+        uint32_t Size;
+
+        FifoCache(size_t vertexCount, uint32_t size)
+        :   LoadedAt(vertexCount, 0), Size(size)
+        {}
+
+        // Returns true on a miss
+        bool Access(uint32_t index)
+        {
+            if (LoadedAt[index] != 0 && Misses - LoadedAt[index] < Size)
+                return false;
+
+            LoadedAt[index] = ++Misses;
+            return true;
+        }
+
+        uint32_t AccessTriangle(const uint32_t* corners)
+        {
+            return Access(corners[0]) + Access(corners[1]) + Access(corners[2]);
+        }
+
+        // Makes every vertex miss again
+        void Flush() { Misses += Size; }
+    };
+
+    // The cache the clusters of OptimizeOverdraw() are measured with, the same one AnalyzeVertexCache() defaults to
+    constexpr uint32_t OVERDRAW_CACHE_SIZE = 16;
+
+    // Splits the triangles where the cache optimized order starts over on a new patch of the mesh, i.e where all
+    // 3 corners of a triangle miss. Returns the first triangle of every cluster
+    std::vector<uint32_t> find_hard_boundaries(const std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        FifoCache cache(vertexCount, OVERDRAW_CACHE_SIZE);
+        std::vector<uint32_t> boundaries;
+
+        for (size_t triangle = 0; triangle < indices.size() / 3; triangle++)
+        {
+            if (cache.AccessTriangle(&indices[3 * triangle]) == 3 || triangle == 0)
+                boundaries.push_back(static_cast<uint32_t>(triangle));
+        }
+
+        return boundaries;
+    }
+
+    // Splits every hard cluster further, into the smallest clusters whose ACMR (measured on their own, with a
+    // cold cache) is within `threshold` times the ACMR of the whole hard cluster
+    std::vector<uint32_t> find_soft_boundaries(const std::vector<uint32_t>& indices, size_t vertexCount,
+                                               const std::vector<uint32_t>& hardBoundaries, float threshold)
+    {
+        FifoCache cache(vertexCount, OVERDRAW_CACHE_SIZE);
+        std::vector<uint32_t> boundaries;
+
+        size_t triangleCount = indices.size() / 3;
+        for (size_t cluster = 0; cluster < hardBoundaries.size(); cluster++)
+        {
+            size_t begin = hardBoundaries[cluster];
+            size_t end = cluster + 1 < hardBoundaries.size() ? hardBoundaries[cluster + 1] : triangleCount;
+
+            cache.Flush();
+            uint32_t clusterMisses = 0;
+            for (size_t triangle = begin; triangle < end; triangle++)
+                clusterMisses += cache.AccessTriangle(&indices[3 * triangle]);
+
+            float targetACMR = threshold * clusterMisses / (end - begin);
+
+            boundaries.push_back(static_cast<uint32_t>(begin));
+
+            cache.Flush();
+            uint32_t runningMisses = 0;
+            uint32_t runningTriangles = 0;
+
+            for (size_t triangle = begin; triangle < end; triangle++)
+            {
+                runningMisses += cache.AccessTriangle(&indices[3 * triangle]);
+                runningTriangles++;
+
+                // Starting over on the next triangle costs a cold cache, which the ACMR of this cluster pays for
+                if (static_cast<float>(runningMisses) / runningTriangles <= targetACMR)
+                {
+                    boundaries.push_back(static_cast<uint32_t>(triangle + 1));
+
+                    cache.Flush();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+
+            // The triangles after the last split rarely reach the target on their own, so they are merged into
+            // the cluster before them. That also drops the boundary at `end` if the last split landed there
+            if (boundaries.back() != begin)
+                boundaries.pop_back();
+        }
+
+        return boundaries;
+    }
+}
+
+namespace Tile
+{
+    VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStats stats;
+        if (indices.empty())
+            return stats;
+
+        FifoCache cache(vertexCount, cacheSize);
+        size_t referencedVertices = 0;
+
+        for (uint32_t index : indices)
+        {
+            if (cache.LoadedAt[index] == 0)
+                referencedVertices++;
+
+            cache.Access(index);
+        }
+
+        stats.ACMR = static_cast<float>(cache.Misses) / (indices.size() / 3);
+        stats.ATVR = static_cast<float>(cache.Misses) / referencedVertices;
+        return stats;
+    }
+
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        static const ScoreTables scores;
+
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return;
+
+        // The triangles of every vertex, in one array. Emitted triangles are swapped to the end of their
+        // vertex's range, so the first remainingTriangles[vertex] of them are the ones still to be emitted
+        std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            remainingTriangles[indices[i]]++;
+
+        std::vector<uint32_t> adjacencyStarts(vertexCount + 1, 0);
+        for (size_t vertex = 0; vertex < vertexCount; vertex++)
+            adjacencyStarts[vertex + 1] = adjacencyStarts[vertex] + remainingTriangles[vertex];
+
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> cursors(adjacencyStarts.begin(), adjacencyStarts.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; i++)
+                adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<uint32_t> cachePositions(vertexCount, NONE);
+        std::vector<float> vertexScores(vertexCount);
+        for (size_t vertex = 0; vertex < vertexCount; vertex++)
+            vertexScores[vertex] = scores.GetScore(NONE, remainingTriangles[vertex]);
+
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        for (size_t triangle = 0; triangle < triangleCount; triangle++)
+        {
+            const uint32_t* corners = &indices[3 * triangle];
+            triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+        }
+
+        // The cache holds up to 3 extra vertices while a triangle is being added, before the oldest are evicted
+        uint32_t cache[SCORING_CACHE_SIZE + 3];
+        uint32_t newCache[SCORING_CACHE_SIZE + 3];
+        uint32_t cacheSize = 0;
+
+        std::vector<uint32_t> output(triangleCount * 3);
+
+        uint32_t bestTriangle = static_cast<uint32_t>(
+            std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+
+        // Where to continue looking for a triangle when none of the ones around the cache are left
+        size_t inputCursor = 0;
+
+        for (size_t outputTriangle = 0; outputTriangle < triangleCount; outputTriangle++)
+        {
+            if (bestTriangle == NONE)
+            {
+                while (emitted[inputCursor])
+                    inputCursor++;
+
+                bestTriangle = static_cast<uint32_t>(inputCursor);
+            }
+
+            const uint32_t* corners = &indices[3 * bestTriangle];
+            std::copy(corners, corners + 3, &output[3 * outputTriangle]);
+            emitted[bestTriangle] = 1;
+
+            // Take the triangle out of its vertices' remaining triangles
+            for (int i = 0; i < 3; i++)
+            {
+                uint32_t vertex = corners[i];
+                uint32_t* begin = &adjacency[adjacencyStarts[vertex]];
+                uint32_t* end = begin + remainingTriangles[vertex];
+
+                std::iter_swap(std::find(begin, end, bestTriangle), end - 1);
+                remainingTriangles[vertex]--;
+            }
+
+            // The triangle's vertices move to the front of the LRU cache
+            uint32_t newCacheSize = 0;
+            for (int i = 0; i < 3; i++)
+            {
+                if (std::find(newCache, newCache + newCacheSize, corners[i]) == newCache + newCacheSize)
+                    newCache[newCacheSize++] = corners[i];
+            }
+
+            for (uint32_t i = 0; i < cacheSize; i++)
+            {
+                if (std::find(corners, corners + 3, cache[i]) == corners + 3)
+                    newCache[newCacheSize++] = cache[i];
+            }
+
+            // Rescore every vertex whose cache position changed, including the evicted ones, and pass the
+            // difference on to their remaining triangles
+            for (uint32_t i = 0; i < newCacheSize; i++)
+            {
+                uint32_t vertex = newCache[i];
+                cachePositions[vertex] = i < SCORING_CACHE_SIZE ? i : NONE;
+
+                float score = scores.GetScore(cachePositions[vertex], remainingTriangles[vertex]);
+                float delta = score - vertexScores[vertex];
+                vertexScores[vertex] = score;
+
+                uint32_t begin = adjacencyStarts[vertex];
+                for (uint32_t j = begin; j < begin + remainingTriangles[vertex]; j++)
+                    triangleScores[adjacency[j]] += delta;
+            }
+
+            cacheSize = std::min(newCacheSize, SCORING_CACHE_SIZE);
+            std::copy(newCache, newCache + cacheSize, cache);
+
+            // The next triangle is the best one around the cache. Triangles away from it all score lower
+            bestTriangle = NONE;
+            float bestScore = -1.f;
+
+            for (uint32_t i = 0; i < cacheSize; i++)
+            {
+                uint32_t vertex = cache[i];
+                uint32_t begin = adjacencyStarts[vertex];
+
+                for (uint32_t j = begin; j < begin + remainingTriangles[vertex]; j++)
+                {
+                    uint32_t triangle = adjacency[j];
+                    if (triangleScores[triangle] > bestScore)
+                    {
+                        bestScore = triangleScores[triangle];
+                        bestTriangle = triangle;
+                    }
+                }
+            }
+        }
+
+        indices.swap(output);
+    }
+
+    size_t OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float acmrThreshold)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return 0;
+
+        std::vector<uint32_t> hardBoundaries = find_hard_boundaries(indices, vertices.size());
+        std::vector<uint32_t> clusters = find_soft_boundaries(indices, vertices.size(), hardBoundaries, acmrThreshold);
+
+        glm::vec3 meshCentroid(0.f);
+        for (uint32_t index : indices)
+            meshCentroid += vertices[index].position;
+
+        meshCentroid = meshCentroid / static_cast<float>(indices.size());
+
+        // How likely a cluster is to occlude the rest of the mesh: the further out its (area weighted) centroid
+        // lies along its average normal, the more of the mesh is behind it whenever it faces the camera
+        std::vector<float> occlusionPotential(clusters.size());
+        for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+        {
+            size_t begin = clusters[cluster];
+            size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+
+            glm::vec3 centroid(0.f);
+            glm::vec3 normal(0.f);
+            float area = 0.f;
+
+            for (size_t triangle = begin; triangle < end; triangle++)
+            {
+                const glm::vec3& a = vertices[indices[3 * triangle + 0]].position;
+                const glm::vec3& b = vertices[indices[3 * triangle + 1]].position;
+                const glm::vec3& c = vertices[indices[3 * triangle + 2]].position;
+
+                // Twice the area, which does not matter for a weight
+                glm::vec3 areaNormal = glm::cross(b - a, c - a);
+                float triangleArea = glm::length(areaNormal);
+
+                centroid += (a + b + c) * (triangleArea / 3.f);
+                normal += areaNormal;
+                area += triangleArea;
+            }
+
+            float normalLength = glm::length(normal);
+            if (area == 0.f || normalLength == 0.f)
+                continue;
+
+            occlusionPotential[cluster] = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+        }
+
+        std::vector<uint32_t> order(clusters.size());
+        for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+            order[cluster] = static_cast<uint32_t>(cluster);
+
+        std::stable_sort(order.begin(), order.end(), [&occlusionPotential](uint32_t a, uint32_t b) {
+            return occlusionPotential[a] > occlusionPotential[b];
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(triangleCount * 3);
+
+        for (uint32_t cluster : order)
+        {
+            size_t begin = clusters[cluster];
+            size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+            output.insert(output.end(), indices.begin() + 3 * begin, indices.begin() + 3 * end);
+        }
+
+        indices.swap(output);
+        return clusters.size();
+    }
+
+    void SplitIntoShortIndexChunks(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+                                   std::vector<Vertex>& chunkVertices, std::vector<uint16_t>& chunkIndices,
+                                   std::vector<IndexChunk>& chunks)
+    {
+        constexpr size_t MAX_CHUNK_VERTICES = size_t(std::numeric_limits<uint16_t>::max()) + 1;
+
+        chunkVertices.clear();
+        chunkIndices.clear();
+        chunks.clear();
+
+        chunkVertices.reserve(vertexCount);
+        chunkIndices.reserve(indexCount);
+
+        // The index of every vertex in the current chunk, valid if the vertex's chunk is the current one
+        std::vector<uint32_t> vertexChunk(vertexCount, NONE);
+        std::vector<uint16_t> localIndex(vertexCount);
+
+        IndexChunk chunk = { 0, 0, 0 };
+        uint32_t chunkNumber = 0;
+
+        for (size_t i = 0; i + 3 <= indexCount; i += 3)
+        {
+            size_t newVertices = 0;
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[i + corner];
+
+                // A corner repeated within the triangle counts once
+                bool repeated = (corner > 0 && vertex == indices[i]) || (corner > 1 && vertex == indices[i + 1]);
+                if (vertexChunk[vertex] != chunkNumber && !repeated)
+                    newVertices++;
+            }
+
+            size_t chunkVertexCount = chunkVertices.size() - chunk.BaseVertex;
+            if (chunkVertexCount + newVertices > MAX_CHUNK_VERTICES)
+            {
+                chunks.push_back(chunk);
+                chunk = { static_cast<uint32_t>(chunkIndices.size()), 0, static_cast<int32_t>(chunkVertices.size()) };
+                chunkNumber++;
+            }
+
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = indices[i + corner];
+                if (vertexChunk[vertex] != chunkNumber)
+                {
+                    vertexChunk[vertex] = chunkNumber;
+                    localIndex[vertex] = static_cast<uint16_t>(chunkVertices.size() - chunk.BaseVertex);
+                    chunkVertices.push_back(vertices[vertex]);
+                }
+
+                chunkIndices.push_back(localIndex[vertex]);
+            }
+
+            chunk.IndexCount += 3;
+        }
+
+        if (chunk.IndexCount > 0)
+            chunks.push_back(chunk);
+    }
+
+    void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::vector<uint32_t> remap(vertices.size(), NONE);
+
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == NONE)
+            {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        vertices.swap(reordered);
+    }
+}
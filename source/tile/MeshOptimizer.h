@@ -0,0 +1,53 @@
+#pragma once
+
+#include "tile/Model.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tile
+{
+    // How well an indexed triangle list uses the GPU's post-transform vertex cache, simulated as a FIFO cache
+    struct VertexCacheStats
+    {
+        // Average cache miss ratio, i.e vertex shader invocations per triangle. Between 3 (every corner misses)
+        // and about 0.5 (every vertex is transformed once, in a large regular mesh)
+        float ACMR = 0.f;
+
+        // Average transformed vertex ratio, i.e vertex shader invocations per referenced vertex. 1 is optimal
+        float ATVR = 0.f;
+    };
+
+    VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+    // Reorders the triangles of an indexed triangle list for post-transform vertex cache locality, after Tom
+    // Forsyth's "Linear-Speed Vertex Cache Optimisation". Triangles keep their winding order. `vertexCount` is
+    // one past the largest index
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    // Reorders the clusters of a vertex cache optimized triangle list so that the ones likely to occlude the
+    // rest of the mesh are drawn first, which cuts down on overdraw from any viewpoint. After Sander et al.'s
+    // "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+    //
+    // The clusters are runs of the input triangles, as short as they can be while their ACMR (each measured with
+    // a cold 16 entry FIFO cache) stays within `acmrThreshold` times that of the patch they were split from, so
+    // the threshold bounds how much worse the vertex cache gets. Higher thresholds give smaller clusters and so
+    // more freedom to sort them. Triangles keep their winding order. Returns the number of clusters
+    size_t OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float acmrThreshold = 1.05f);
+
+    // Splits an indexed triangle list into chunks that reference at most 65536 vertices each, so that all of it
+    // can be drawn with 16 bit indices relative to each chunk's base vertex. Every chunk gets its own copy of
+    // the vertices it references, so the ones shared between chunks are duplicated. Triangles keep their order,
+    // and vertex cache and fetch optimized meshes keep most of their locality. Vertices no triangle references
+    // are dropped
+    void SplitIntoShortIndexChunks(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+                                   std::vector<Vertex>& chunkVertices, std::vector<uint16_t>& chunkIndices,
+                                   std::vector<IndexChunk>& chunks);
+
+    // Reorders the vertices into the order the indices first reference them in (and remaps the indices), so
+    // that the vertex buffer is read close to sequentially. Vertices no index references are dropped.
+    //
+    // Meant to run after OptimizeVertexCache() (and OptimizeOverdraw()), which decide that order
+    void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+}
@@ -1,11 +1,28 @@
 #include "tile/Model.h"
-
+#include "tile/Instancing.h"
+#include "tile/MeshCache.h"
+#include "tile/MeshOptimizer.h"
+#include "tile/ObjParser.h"
+#include "tile/ThreadPool.h"
+#include "tile/Triangulator.h"
+#include "tile/VertexQuantization.h"
+#include "tile/opengl_inc.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <TinyObjLoader/tiny_obj_loader.h>
 
 #include <glm/matrix.hpp>
 #include <glm/mat3x3.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TILE_SPACE_CONVERTER_SSE
+    #include <emmintrin.h>
+#endif
+
 namespace
 {
     using namespace Tile;
@@ -96,33 +113,351 @@ namespace
     {
         return IsSameHandedness(SpaceConverter(first, second));
     }
+
+    // Triangulates the faces [faceBegin, faceEnd) of `mesh` and calls emit() with every corner of every
+    // triangle. `faceSizes` holds the corner count of every face of `mesh`, and `cornerBegin` is the index of
+    // the first corner of `faceBegin` in mesh.indices.
+    //
+    // Faces with more than 3 corners go through `triangulator`, using their (already converted) positions
+    template <typename EmitFunc>
+    void emit_triangles(const tinyobj::mesh_t& mesh,
+                        const std::vector<uint32_t>& faceSizes,
+                        const std::vector<float>& positions,
+                        size_t faceBegin,
+                        size_t faceEnd,
+                        size_t cornerBegin,
+                        bool toggleWindingOrder,
+                        Triangulator& triangulator,
+                        EmitFunc&& emit)
+    {
+        std::vector<glm::vec3> face_positions;
+        std::vector<uint32_t> triangles;
+
+        size_t mesh_indicies_index = cornerBegin; // Index into mesh.indices
+
+        for (size_t face_index = faceBegin; face_index < faceEnd; face_index++)
+        {
+            uint32_t face_vertex_count = faceSizes[face_index];
+            const tinyobj::index_t* face_index_elems = mesh.indices.data() + mesh_indicies_index;
+
+            triangles.clear();
+            if (face_vertex_count == 3)
+            {
+                triangles.insert(triangles.end(), { 0, 1, 2 });
+            }
+            else
+            {
+                face_positions.resize(face_vertex_count);
+                for (uint32_t i = 0; i < face_vertex_count; i++)
+                {
+                    const float* position = &positions[3 * static_cast<size_t>(face_index_elems[i].vertex_index)];
+                    face_positions[i] = glm::vec3(position[0], position[1], position[2]);
+                }
+
+                triangulator.Triangulate(face_positions.data(), face_vertex_count, triangles);
+            }
+
+            for (size_t i = 0; i < triangles.size(); i += 3)
+            {
+                const auto& face_index_elem_a = face_index_elems[triangles[i + 0]];
+                const auto& face_index_elem_b = face_index_elems[triangles[i + 1]];
+                const auto& face_index_elem_c = face_index_elems[triangles[i + 2]];
+
+                // flip the first and third vertices for back-face culling
+                // if model has been reflected during the coordinate system conversion
+                if (toggleWindingOrder)
+                {
+                    emit(face_index_elem_c);
+                    emit(face_index_elem_b);
+                    emit(face_index_elem_a);
+                }
+                else
+                {
+                    emit(face_index_elem_a);
+                    emit(face_index_elem_b);
+                    emit(face_index_elem_c);
+                }
+            }
+
+            mesh_indicies_index += face_vertex_count;
+        }
+    }
+
+    inline size_t triangulated_index_count(uint32_t face_vertex_count)
+    {
+        return face_vertex_count >= 3 ? 3 * (face_vertex_count - 2) : 0;
+    }
+
+    // Widens tinyobj's per-face corner counts. Returns false if they do not add up to the number of corners,
+    // which is what happens when tinyobj truncates the corner count of a face with more than 255 corners
+    bool collect_face_sizes(const std::vector<tinyobj::shape_t>& shapes, std::vector<std::vector<uint32_t>>& faceSizes)
+    {
+        faceSizes.resize(shapes.size());
+
+        bool consistent = true;
+        for (size_t i = 0; i < shapes.size(); i++)
+        {
+            const auto& mesh = shapes[i].mesh;
+            faceSizes[i].assign(mesh.num_face_vertices.begin(), mesh.num_face_vertices.end());
+
+            size_t cornerCount = 0;
+            for (auto face_vertex_count : mesh.num_face_vertices)
+                cornerCount += face_vertex_count;
+
+            consistent = consistent && cornerCount == mesh.indices.size();
+        }
+
+        return consistent;
+    }
+
+    inline float flip_sign(float value, uint32_t signBit)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits ^= signBit;
+        std::memcpy(&value, &bits, sizeof(bits));
+        return value;
+    }
+
+    // Converts packed vec3s such that component i of the result is component S<i> of the source, with its
+    // sign bit flipped by signBits[i]. There is one instantiation per permutation, so all the shuffles are
+    // known at compile time
+    template <int SX, int SY, int SZ>
+    void convert_vec3_array(float* vecs, size_t count, const uint32_t signBits[3])
+    {
+        size_t i = 0;
+
+#ifdef TILE_SPACE_CONVERTER_SSE
+        const __m128 signX = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(signBits[0])));
+        const __m128 signY = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(signBits[1])));
+        const __m128 signZ = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(signBits[2])));
+
+        // Used when there is no permutation. The sign masks repeat every 3 registers just like the components do
+        const __m128 signA =
+            _mm_shuffle_ps(_mm_unpacklo_ps(signX, signY), _mm_unpacklo_ps(signZ, signX), _MM_SHUFFLE(1, 0, 1, 0));
+        const __m128 signB =
+            _mm_shuffle_ps(_mm_unpacklo_ps(signY, signZ), _mm_unpacklo_ps(signX, signY), _MM_SHUFFLE(1, 0, 1, 0));
+        const __m128 signC =
+            _mm_shuffle_ps(_mm_unpacklo_ps(signZ, signX), _mm_unpacklo_ps(signY, signZ), _MM_SHUFFLE(1, 0, 1, 0));
+
+        // 4 vec3s at a time, which is exactly 3 registers:
+        //     a = x0 y0 z0 x1 | b = y1 z1 x2 y2 | c = z2 x3 y3 z3
+        for (; i + 4 <= count; i += 4)
+        {
+            float* block = vecs + 3 * i;
+            __m128 a = _mm_loadu_ps(block + 0);
+            __m128 b = _mm_loadu_ps(block + 4);
+            __m128 c = _mm_loadu_ps(block + 8);
+
+            if constexpr (SX == 0 && SY == 1 && SZ == 2)
+            {
+                // No permutation (e.g the default Y-down to Y-up conversion), only the signs change
+                a = _mm_xor_ps(a, signA);
+                b = _mm_xor_ps(b, signB);
+                c = _mm_xor_ps(c, signC);
+            }
+            else
+            {
+                // Transpose into one register per component, so that the permutation is just picking registers
+                __m128 xs = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+                __m128 ys = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                                           _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 zs = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                                           _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+                const __m128 components[3] = { xs, ys, zs };
+                xs = _mm_xor_ps(components[SX], signX);
+                ys = _mm_xor_ps(components[SY], signY);
+                zs = _mm_xor_ps(components[SZ], signZ);
+
+                // ... and back
+                a = _mm_shuffle_ps(_mm_shuffle_ps(xs, ys, _MM_SHUFFLE(0, 0, 0, 0)),
+                                   _mm_shuffle_ps(zs, xs, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+                b = _mm_shuffle_ps(_mm_shuffle_ps(ys, zs, _MM_SHUFFLE(1, 1, 1, 1)),
+                                   _mm_shuffle_ps(xs, ys, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+                c = _mm_shuffle_ps(_mm_shuffle_ps(zs, xs, _MM_SHUFFLE(3, 3, 2, 2)),
+                                   _mm_shuffle_ps(ys, zs, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            }
+
+            _mm_storeu_ps(block + 0, a);
+            _mm_storeu_ps(block + 4, b);
+            _mm_storeu_ps(block + 8, c);
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            float* vec = vecs + 3 * i;
+            const float source[3] = { vec[0], vec[1], vec[2] };
+
+            vec[0] = flip_sign(source[SX], signBits[0]);
+            vec[1] = flip_sign(source[SY], signBits[1]);
+            vec[2] = flip_sign(source[SZ], signBits[2]);
+        }
+    }
 }
 
 
 namespace Tile {
 
-    Model::Model() {}
+    const VertexLayout VERTEX_LAYOUT = {
+        {0, "ia_Pos",       3, VertAttribComponentType::Float, false},
+        {1, "ia_Normal",    3, VertAttribComponentType::Float, false},
+        {2, "ia_TexCoords", 2, VertAttribComponentType::Float, false},
+    };
+
+    Model::Model()
+    :   m_VA(std::make_unique<VertexArray>()),
+        m_VBuf(std::make_unique<VertexBuffer>()),
+        m_IBuf(std::make_unique<IndexBuffer>())
+    {}
+
+    Model::Model(std::shared_ptr<GeometryPool> pool, const GeometryAllocation& allocation,
+                 const std::vector<IndexChunk>& chunks, const glm::mat4& dequantize)
+    :   m_Pool(std::move(pool)),
+        m_PoolAllocation(allocation),
+        m_VertexCount(allocation.VertexCount),
+        m_VertexBufferSize(GeometryPool::GetVertexSize(allocation.Format) * allocation.VertexCount),
+        m_DequantizeTransform(dequantize),
+        m_HasIndexBuffer(allocation.IndexCount > 0),
+        m_IndexCount(allocation.IndexCount),
+        m_IndexChunks(chunks)
+    {}
+
+    Model::~Model()
+    {
+        if (m_Pool)
+            m_Pool->Free(m_PoolAllocation);
+    }
+
+    const VertexArray& Model::GetVA() const
+    {
+        return m_Pool ? m_Pool->GetVA(m_PoolAllocation.Format) : *m_VA;
+    }
+
+    const VertexBuffer& Model::GetVBuf() const
+    {
+        return m_Pool ? m_Pool->GetVertexBuffer(m_PoolAllocation.Format) : *m_VBuf;
+    }
+
+    const IndexBuffer& Model::GetIBuf() const
+    {
+        return m_Pool ? m_Pool->GetIndexBuffer() : *m_IBuf;
+    }
 
     void Model::CreateIndexBuffer(const std::vector<uint32_t>& indices)
     {
-        m_IndexCount = indices.size();
+        CreateIndexBuffer(indices.data(), indices.size());
+    }
+
+    void Model::CreateIndexBuffer(const uint32_t* indices, size_t count)
+    {
+        uint32_t maxIndex = 0;
+        for (size_t i = 0; i < count; i++)
+            maxIndex = std::max(maxIndex, indices[i]);
+
+        if (maxIndex <= std::numeric_limits<uint16_t>::max())
+        {
+            std::vector<uint16_t> narrowed(indices, indices + count);
+            CreateIndexBuffer(narrowed.data(), count, { { 0, static_cast<uint32_t>(count), 0 } });
+            return;
+        }
+
+        m_IndexCount = count;
         m_HasIndexBuffer = true;
+        m_IndexChunks = { { 0, static_cast<uint32_t>(count), 0 } };
+
+        m_VA->AddIndexBuffer(*m_IBuf);
+        m_IBuf->SetIndices(indices, sizeof(uint32_t) * m_IndexCount);
+    }
+
+    void Model::CreateIndexBuffer(const uint16_t* indices, size_t count, const std::vector<IndexChunk>& chunks)
+    {
+        m_IndexCount = count;
+        m_HasIndexBuffer = true;
+        m_IndexChunks = chunks;
+
+        m_VA->AddIndexBuffer(*m_IBuf);
+        m_IBuf->SetIndices(indices, sizeof(uint16_t) * m_IndexCount);
+    }
+
+    void Model::Draw() const
+    {
+        GetVA().Bind();
+
+        if (!m_HasIndexBuffer)
+        {
+            gl::glDrawArrays(gl::GL_TRIANGLES, m_PoolAllocation.FirstVertex, m_VertexCount);
+            return;
+        }
+
+        gl::GLenum indexType = GetIBuf().GetGLIndexType();
+        size_t indexSize = GetIBuf().GetIndexSize();
+
+        for (const IndexChunk& chunk : m_IndexChunks)
+        {
+            const void* offset = reinterpret_cast<const void*>(chunk.FirstIndex * indexSize);
 
-        m_VA.AddIndexBuffer(m_IBuf);
-        m_IBuf.SetIndices(indices.data(), sizeof(uint32_t) * m_IndexCount);
+            if (chunk.BaseVertex == 0)
+                gl::glDrawElements(gl::GL_TRIANGLES, chunk.IndexCount, indexType, offset);
+            else
+                gl::glDrawElementsBaseVertex(gl::GL_TRIANGLES, chunk.IndexCount, indexType, offset, chunk.BaseVertex);
+        }
+    }
+
+    void Model::DrawInstanced(const InstanceBuffer& instances) const
+    {
+        auto instanceCount = static_cast<gl::GLsizei>(instances.GetInstanceCount());
+        if (instanceCount == 0)
+            return;
+
+        if (m_Pool)
+            m_Pool->AddInstanceAttributes(instances.GetBuffer(), instances.GetLayout());
+        else
+            m_VA->AddVertexBuffer(instances.GetBuffer(), instances.GetLayout());
+
+        GetVA().Bind();
+
+        if (!m_HasIndexBuffer)
+        {
+            gl::glDrawArraysInstanced(gl::GL_TRIANGLES, m_PoolAllocation.FirstVertex, m_VertexCount, instanceCount);
+            return;
+        }
+
+        gl::GLenum indexType = GetIBuf().GetGLIndexType();
+        size_t indexSize = GetIBuf().GetIndexSize();
+
+        for (const IndexChunk& chunk : m_IndexChunks)
+        {
+            const void* offset = reinterpret_cast<const void*>(chunk.FirstIndex * indexSize);
+            gl::glDrawElementsInstancedBaseVertex(gl::GL_TRIANGLES, chunk.IndexCount, indexType, offset, instanceCount,
+                                                  chunk.BaseVertex);
+        }
     }
 
     void Model::CreateVertexBuffer(const std::vector<Vertex>& vertices)
     {
-        m_VertexCount = vertices.size();
+        CreateVertexBuffer(vertices.data(), vertices.size());
+    }
+
+    void Model::CreateVertexBuffer(const Vertex* vertices, size_t count)
+    {
+        m_VertexCount = count;
+        m_VertexBufferSize = sizeof(Vertex) * count;
+        m_DequantizeTransform = glm::mat4(1.f);
         
-        m_VA.AddVertexBuffer(m_VBuf, {
-            {0, "ia_Pos",       3, VertAttribComponentType::Float, false},
-            {1, "ia_Normal",    3, VertAttribComponentType::Float, false},
-            {2, "ia_TexCoords", 2, VertAttribComponentType::Float, false},
-        });
+        m_VA->AddVertexBuffer(*m_VBuf, VERTEX_LAYOUT);
+        m_VBuf->SetData(vertices, m_VertexBufferSize);
+    }
+
+    void Model::CreateVertexBuffer(const QuantizedVertex* vertices, size_t count, const glm::mat4& dequantize)
+    {
+        m_VertexCount = count;
+        m_VertexBufferSize = sizeof(QuantizedVertex) * count;
+        m_DequantizeTransform = dequantize;
 
-        m_VBuf.SetData(vertices.data(), sizeof(Vertex) * m_VertexCount);
+        m_VA->AddVertexBuffer(*m_VBuf, QUANTIZED_VERTEX_LAYOUT);
+        m_VBuf->SetData(vertices, m_VertexBufferSize);
     }
 
     /* ============================================================================================================ */
@@ -146,6 +481,43 @@ namespace Tile {
         vec[2] = vecCopy[m_MoveZ.SourceCompLocation] * m_MoveZ.Multiplier;
     }
 
+    void SpaceConverter::ConvertArrayInPlace(float* vecs, size_t count) const
+    {
+        using ConvertFunc = void (*)(float*, size_t, const uint32_t*);
+
+        struct Permutation
+        {
+            uint8_t X, Y, Z;
+            ConvertFunc Func;
+        };
+
+        static constexpr Permutation PERMUTATIONS[] = {
+            { 0, 1, 2, convert_vec3_array<0, 1, 2> },
+            { 0, 2, 1, convert_vec3_array<0, 2, 1> },
+            { 1, 0, 2, convert_vec3_array<1, 0, 2> },
+            { 1, 2, 0, convert_vec3_array<1, 2, 0> },
+            { 2, 0, 1, convert_vec3_array<2, 0, 1> },
+            { 2, 1, 0, convert_vec3_array<2, 1, 0> },
+        };
+
+        const uint32_t signBits[3] = {
+            m_MoveX.Multiplier < 0 ? 0x80000000u : 0u,
+            m_MoveY.Multiplier < 0 ? 0x80000000u : 0u,
+            m_MoveZ.Multiplier < 0 ? 0x80000000u : 0u,
+        };
+
+        for (const auto& permutation : PERMUTATIONS)
+        {
+            if (permutation.X == m_MoveX.SourceCompLocation &&
+                permutation.Y == m_MoveY.SourceCompLocation &&
+                permutation.Z == m_MoveZ.SourceCompLocation)
+            {
+                permutation.Func(vecs, count, signBits);
+                return;
+            }
+        }
+    }
+
     /* ============================================================================================================== */
     /* ================================================ ModelBuilder ================================================ */
     /* ============================================================================================================== */
@@ -154,115 +526,432 @@ namespace Tile {
     // Any non-trivial model will have atleast quite a few vertices
     // so it is good to initialize the vector to with preallocated space for
     // some vertices
-    :   m_Vertices(32),
+    :   m_SourceSystem {
+            { AxisLine::LINE_X, +1 },
+            { AxisLine::LINE_Y, -1 },
+            { AxisLine::LINE_Z, -1 },
+        },
+        m_TargetSystem {
+            { AxisLine::LINE_X, +1 },
+            { AxisLine::LINE_Y, +1 },
+            { AxisLine::LINE_Z, -1 },
+        },
+        m_Vertices(32),
         m_Indices(3 * 48)
     {}
 
+    // Defined here so that ThreadPool can stay forward declared in the header
+    ModelBuilder::~ModelBuilder() = default;
+
     std::shared_ptr<Model> ModelBuilder::LoadWavefrontObj(const std::string& filepath, const std::string& shapeName)
+    {
+        MeshCache cache(m_CacheDirectory);
+        MeshCacheKey cacheKey = {
+            filepath, shapeName, m_SourceSystem, m_TargetSystem,
+            m_OptimizeVertexCache || m_OptimizeOverdraw,
+            m_OptimizeOverdraw ? m_OverdrawThreshold : 0.f,
+        };
+
+        if (!m_CacheDirectory.empty())
+        {
+            if (auto cached = cache.Load(cacheKey))
+            {
+                // Uploaded straight out of the mapped cache file
+                return CreateModel(cached->GetVertices(), cached->GetVertexCount(),
+                                   cached->GetIndices(), cached->GetIndexCount());
+            }
+        }
+
+        if (!BuildWavefrontObj(filepath, shapeName))
+        {
+            // Return an empty model so that things do not break due to null pointers
+            auto model = std::make_shared<Model>();
+            model->CreateVertexBuffer(m_Vertices); // m_Vertices is already empty at this point
+            return model;
+        }
+
+        if (!m_CacheDirectory.empty())
+            cache.Store(cacheKey, m_Vertices, m_Indices);
+
+        return CreateModel(m_Vertices.data(), m_Vertices.size(), m_Indices.data(), m_Indices.size());
+    }
+
+    std::shared_ptr<Model> ModelBuilder::CreateModel(const Vertex* vertices, size_t vertexCount,
+                                                     const uint32_t* indices, size_t indexCount) const
+    {
+        // Smaller models get 16 bit indices as they are. The pool only takes chunked indices
+        bool chunked = m_GeometryPool ||
+                       (m_ChunkIndices && vertexCount > std::numeric_limits<uint16_t>::max() + size_t(1));
+
+        std::vector<Vertex> chunkVertices;
+        std::vector<uint16_t> chunkIndices;
+        std::vector<IndexChunk> chunks;
+
+        if (chunked)
+        {
+            SplitIntoShortIndexChunks(vertices, vertexCount, indices, indexCount, chunkVertices, chunkIndices, chunks);
+            vertices = chunkVertices.data();
+            vertexCount = chunkVertices.size();
+        }
+
+        if (m_GeometryPool)
+        {
+            GeometryAllocation allocation;
+            glm::mat4 dequantize(1.f);
+
+            if (m_QuantizeVertices)
+            {
+                QuantizedMesh quantized = QuantizeVertices(vertices, vertexCount);
+                dequantize = quantized.Dequantize;
+                allocation = m_GeometryPool->Allocate(VertexFormat::Quantized, quantized.Vertices.data(),
+                                                      static_cast<uint32_t>(vertexCount), chunkIndices.data(),
+                                                      static_cast<uint32_t>(chunkIndices.size()));
+            }
+            else
+            {
+                allocation = m_GeometryPool->Allocate(VertexFormat::Full, vertices, static_cast<uint32_t>(vertexCount),
+                                                      chunkIndices.data(), static_cast<uint32_t>(chunkIndices.size()));
+            }
+
+            for (IndexChunk& chunk : chunks)
+            {
+                chunk.FirstIndex += allocation.FirstIndex;
+                chunk.BaseVertex += static_cast<int32_t>(allocation.FirstVertex);
+            }
+
+            return std::make_shared<Model>(m_GeometryPool, allocation, chunks, dequantize);
+        }
+
+        auto model = std::make_shared<Model>();
+
+        if (m_QuantizeVertices)
+        {
+            QuantizedMesh quantized = QuantizeVertices(vertices, vertexCount);
+            model->CreateVertexBuffer(quantized.Vertices.data(), quantized.Vertices.size(), quantized.Dequantize);
+        }
+        else
+        {
+            model->CreateVertexBuffer(vertices, vertexCount);
+        }
+
+        if (chunked)
+            model->CreateIndexBuffer(chunkIndices.data(), chunkIndices.size(), chunks);
+        else
+            model->CreateIndexBuffer(indices, indexCount);
+
+        return model;
+    }
+
+    bool ModelBuilder::BuildWavefrontObj(const std::string& filepath, const std::string& shapeName)
     {
         attrib = std::make_unique<tinyobj::attrib_t>();
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> mats;
         std::string warn, err;
 
+        // The corner count of every face of shapes[i] is in faceSizes[i]
+        std::vector<std::vector<uint32_t>> faceSizes;
+
         m_Vertices.clear();
         m_Indices.clear();
-        m_UniqueVertices.clear();
+        m_UniqueVertices.Clear();
+        m_UniqueTriples.clear();
+        m_UniqueTriplesTable.Clear();
+
+        bool loaded;
+        if (m_ParseMode == ObjParseMode::Parallel)
+        {
+            ObjParser parser(GetThreadPool());
+            parser.SetMemoryMapping(m_UseMemoryMapping);
+            loaded = parser.LoadFile(filepath, attrib.get(), &shapes, &faceSizes, &err);
+        }
+        else
+        {
+            // Faces are triangulated below, with Triangulator, so tinyobj leaves them as they are
+            loaded = tinyobj::LoadObj(attrib.get(), &shapes, &mats, &warn, &err, filepath.c_str(), nullptr, false);
+            if (loaded && !collect_face_sizes(shapes, faceSizes))
+            {
+                // num_face_vertices is an unsigned char, so tinyobj can not describe faces with more than 255
+                // corners without triangulating them. Let it triangulate them instead
+                std::cerr << "[WARN] \"" << filepath << "\" has faces with more than 255 corners, which tinyobj "
+                          << "can not load untriangulated. Loading it triangulated by tinyobj instead" << std::endl;
+
+                loaded = tinyobj::LoadObj(attrib.get(), &shapes, &mats, &warn, &err, filepath.c_str());
+                collect_face_sizes(shapes, faceSizes);
+            }
+        }
 
-        if (!tinyobj::LoadObj(attrib.get(), &shapes, &mats, &warn, &err, filepath.c_str()))
+        if (!loaded)
         {
             std::cerr << "[ERROR] Failed to load model: \"" << filepath << "\". "
                     << err << warn << std::endl;
 
+            return false;
+        }
 
-            // Return an empty model so that things do not break due to null pointers
-            auto model = std::make_shared<Model>();
-            model->CreateVertexBuffer(m_Vertices); // m_Vertices is already empty at this point
-            return model;
+        converter = std::make_unique<SpaceConverter>(m_SourceSystem, m_TargetSystem);
+        bool toggleWindingOrder = !IsSameHandedness(*converter);
+
+        // Convert every position and normal once, up front, instead of every time a face corner uses it
+        converter->ConvertArrayInPlace(attrib->vertices.data(), attrib->vertices.size() / 3);
+        converter->ConvertArrayInPlace(attrib->normals.data(), attrib->normals.size() / 3);
+
+        // The number of indices is known exactly from the face sizes. The number of unique vertices is
+        // not, but it is usually close to the largest attribute count (e.g one vertex per position)
+        size_t indexCount = 0;
+        for (size_t shapeIndex = 0; shapeIndex < shapes.size(); shapeIndex++)
+        {
+            if (shapeName != "" && shapes[shapeIndex].name != shapeName)
+                continue;
+
+            for (auto face_vertex_count : faceSizes[shapeIndex])
+                indexCount += triangulated_index_count(face_vertex_count);
         }
 
-        // This should be taken as input instead of being hardcoded here... 
-        CoordinateSystem3D source = {
-            { AxisLine::LINE_X, +1 },
-            { AxisLine::LINE_Y, -1 },
-            { AxisLine::LINE_Z, -1 },
+        size_t expectedUniqueVertices = std::min(indexCount, std::max({ attrib->vertices.size() / 3,
+                                                                         attrib->normals.size() / 3,
+                                                                         attrib->texcoords.size() / 2 }));
+
+        m_Indices.reserve(indexCount);
+        m_Vertices.reserve(expectedUniqueVertices);
+        m_UniqueVertices.Reserve(expectedUniqueVertices);
+
+        if (m_IndexTripleDedup)
+        {
+            BuildFromIndexTriples(shapes, faceSizes, shapeName, toggleWindingOrder, expectedUniqueVertices);
+        }
+        else
+        {
+            Triangulator triangulator;
+
+            for (size_t shapeIndex = 0; shapeIndex < shapes.size(); shapeIndex++)
+            {
+                const auto& shape = shapes[shapeIndex];
+
+                // Load only the given shape, if specified. If no shape is specified
+                // then load all the shapes
+                if (shapeName != "" && shape.name != shapeName)
+                    continue;
+
+                emit_triangles(shape.mesh, faceSizes[shapeIndex], attrib->vertices, 0, faceSizes[shapeIndex].size(),
+                               0, toggleWindingOrder, triangulator,
+                               [this](const tinyobj::index_t& index_elem) { AddVertex(index_elem); });
+            }
+        }
+
+        if (m_OptimizeVertexCache || m_OptimizeOverdraw)
+            OptimizeMesh(filepath);
+
+        return true;
+    }
+
+    void ModelBuilder::OptimizeMesh(const std::string& filepath)
+    {
+        VertexCacheStats before = AnalyzeVertexCache(m_Indices, m_Vertices.size());
+
+        OptimizeVertexCache(m_Indices, m_Vertices.size());
+
+        size_t clusterCount = 0;
+        if (m_OptimizeOverdraw)
+            clusterCount = OptimizeOverdraw(m_Indices, m_Vertices, m_OverdrawThreshold);
+
+        OptimizeVertexFetch(m_Vertices, m_Indices);
+
+        VertexCacheStats after = AnalyzeVertexCache(m_Indices, m_Vertices.size());
+
+        std::cout << "[INFO] Optimized \"" << filepath << "\" for the vertex cache. ACMR: " << before.ACMR << " -> "
+                  << after.ACMR << ", ATVR: " << before.ATVR << " -> " << after.ATVR << std::endl;
+
+        if (m_OptimizeOverdraw)
+            std::cout << "[INFO] Sorted the triangles of \"" << filepath << "\" for overdraw in " << clusterCount
+                      << " clusters" << std::endl;
+    }
+
+    void ModelBuilder::AddVertex(const tinyobj::index_t& index_elem)
+    {
+        Vertex vertex = AssembleVertex(index_elem);
+
+        auto unique = m_UniqueVertices.FindOrInsert(vertex, m_Vertices.data());
+        if (unique.Inserted)
+            m_Vertices.push_back(vertex);
+
+        m_Indices.push_back(unique.Index);
+    }
+
+    void ModelBuilder::BuildFromIndexTriples(const std::vector<tinyobj::shape_t>& shapes,
+                                             const std::vector<std::vector<uint32_t>>& faceSizes,
+                                             const std::string& shapeName,
+                                             bool toggleWindingOrder,
+                                             size_t expectedUniqueVertices)
+    {
+        // Faces are triangulated in ranges of about this many indices, each range on its own
+        constexpr size_t INDICES_PER_RANGE = 1 << 16;
+
+        // Below this many items splitting the per-triple and per-index passes up costs more than it saves
+        constexpr size_t PARALLEL_THRESHOLD = 1 << 16;
+        constexpr size_t ITEMS_PER_TASK = 1 << 14;
+
+        auto run_tasks = [this](size_t taskCount, const std::function<void(size_t)>& task) {
+            if (taskCount == 1)
+                task(0);
+            else if (taskCount > 1)
+                GetThreadPool().ParallelFor(taskCount, task);
         };
 
-        CoordinateSystem3D target = {
-            { AxisLine::LINE_X, +1 },
-            { AxisLine::LINE_Y, +1 },
-            { AxisLine::LINE_Z, -1 },
+        auto for_each_range = [&](size_t count, const auto& func) {
+            size_t taskCount = count < PARALLEL_THRESHOLD ? 1 : (count + ITEMS_PER_TASK - 1) / ITEMS_PER_TASK;
+            size_t itemsPerTask = (count + taskCount - 1) / taskCount;
+
+            run_tasks(taskCount, [&](size_t task) {
+                size_t begin = task * itemsPerTask;
+                func(begin, std::min(begin + itemsPerTask, count));
+            });
         };
 
-        converter = std::make_unique<SpaceConverter>(source, target);
-        bool toggleWindingOrder = !IsSameHandedness(*converter);
+        // A range of consecutive faces of one mesh. It is triangulated into its own slice of m_Indices, which
+        // first holds indices into the range's own unique triples
+        struct FaceRange
+        {
+            const tinyobj::mesh_t* Mesh;
+            const std::vector<uint32_t>* FaceSizes;
+            size_t FaceBegin, FaceEnd;
+            size_t CornerBegin;             // Index of the first corner of FaceBegin in Mesh->indices
+            size_t IndexBegin, IndexEnd;    // Slice of m_Indices
+
+            std::vector<tinyobj::index_t> UniqueTriples;
+
+            // Maps the range's unique triples to the global unique triples, and later to the final vertices
+            std::vector<uint32_t> LocalToGlobal;
+        };
+
+        // The ranges only depend on the face sizes, never on the thread count, so the output does not either
+        std::vector<FaceRange> ranges;
+        size_t indexCount = 0;
 
-        for (const auto& shape: shapes)
+        for (size_t shapeIndex = 0; shapeIndex < shapes.size(); shapeIndex++)
         {
-            // Load only the given shape, if specified. If no shape is specified
-            // then load all the shapes
-            if (shapeName != "" && shape.name != shapeName)
+            if (shapeName != "" && shapes[shapeIndex].name != shapeName)
                 continue;
 
-            const auto& mesh = shape.mesh;
-            
-            int face_index = 0;
-            int mesh_indicies_index = 0; // Index into shape.mesh.indices
+            const auto& mesh = shapes[shapeIndex].mesh;
+            const auto& sizes = faceSizes[shapeIndex];
+            size_t faceCount = sizes.size();
+            size_t corner = 0;
 
-            while (mesh_indicies_index < mesh.indices.size())
+            FaceRange range = { &mesh, &sizes, 0, 0, 0, indexCount, indexCount, {}, {} };
+
+            for (size_t face = 0; face < faceCount; face++)
             {
-                auto face_vertex_count = mesh.num_face_vertices[face_index];
-
-                // Face triangulation
-                // 
-                // This code currently only successfully triangulates Simple Convex Polygons
-                // Concave and/or Complex polygons will give incorrect visual results
-                for (int i = 0; i < face_vertex_count - 2; i ++)
-                {  
-                    // form a triangle with vertices (0, i + 1, i + 2)
-                    const auto& face_index_elem_a = mesh.indices[mesh_indicies_index + 0 + 0];
-                    const auto& face_index_elem_b = mesh.indices[mesh_indicies_index + i + 1];
-                    const auto& face_index_elem_c = mesh.indices[mesh_indicies_index + i + 2];
-
-                    // flip the first and third vertices for back-face culling
-                    // if model has been reflected during the coordinate system conversion 
-                    if (toggleWindingOrder) 
-                    {
-                        AddVertex(face_index_elem_c);
-                        AddVertex(face_index_elem_b);
-                        AddVertex(face_index_elem_a);
-                    }
-                    else
-                    {
-                        AddVertex(face_index_elem_a);
-                        AddVertex(face_index_elem_b);
-                        AddVertex(face_index_elem_c);
-                    }
+                uint32_t face_vertex_count = sizes[face];
+                corner += face_vertex_count;
+                indexCount += triangulated_index_count(face_vertex_count);
+
+                if (indexCount - range.IndexBegin >= INDICES_PER_RANGE || face + 1 == faceCount)
+                {
+                    range.FaceEnd = face + 1;
+                    range.IndexEnd = indexCount;
+                    ranges.push_back(std::move(range));
+
+                    range = { &mesh, &sizes, face + 1, face + 1, corner, indexCount, indexCount, {}, {} };
                 }
+            }
+        }
+
+        // Triangulate and deduplicate every range on its own
+        m_Indices.resize(indexCount);
+
+        run_tasks(ranges.size(), [&](size_t rangeIndex) {
+            FaceRange& range = ranges[rangeIndex];
+            uint32_t* indices = m_Indices.data() + range.IndexBegin;
+
+            DedupTable<tinyobj::index_t, IndexTripleHash, IndexTripleEqual> uniqueTriples;
+            uniqueTriples.Reserve((range.IndexEnd - range.IndexBegin) / 4);
+
+            Triangulator triangulator;
+
+            emit_triangles(*range.Mesh, *range.FaceSizes, attrib->vertices, range.FaceBegin, range.FaceEnd,
+                           range.CornerBegin, toggleWindingOrder, triangulator,
+                           [&](const tinyobj::index_t& index_elem) {
+                               auto unique = uniqueTriples.FindOrInsert(index_elem, range.UniqueTriples.data());
+                               if (unique.Inserted)
+                                   range.UniqueTriples.push_back(index_elem);
+
+                               *indices++ = unique.Index;
+                           });
+        });
+
+        // Merge the ranges' unique triples, in order. Each range's triples are in order of first use within the
+        // range, so the global ones end up in order of first use over the whole model, just like in a serial pass
+        m_UniqueTriples.reserve(expectedUniqueVertices);
+        m_UniqueTriplesTable.Reserve(expectedUniqueVertices);
 
-                mesh_indicies_index += face_vertex_count;
-                face_index++;
+        for (auto& range : ranges)
+        {
+            range.LocalToGlobal.resize(range.UniqueTriples.size());
+
+            for (size_t i = 0; i < range.UniqueTriples.size(); i++)
+            {
+                auto unique = m_UniqueTriplesTable.FindOrInsert(range.UniqueTriples[i], m_UniqueTriples.data());
+                if (unique.Inserted)
+                    m_UniqueTriples.push_back(range.UniqueTriples[i]);
+
+                range.LocalToGlobal[i] = unique.Index;
             }
+
+            range.UniqueTriples = {};
         }
 
-        auto model = std::make_shared<Model>();
-        model->CreateVertexBuffer(m_Vertices);
-        model->CreateIndexBuffer(m_Indices);
-        return model;
+        // Assemble every unique triple exactly once
+        std::vector<Vertex> tripleVertices(m_UniqueTriples.size());
+        for_each_range(m_UniqueTriples.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                tripleVertices[i] = AssembleVertex(m_UniqueTriples[i]);
+        });
+
+        // Different triples can still produce the same vertex (e.g duplicate 'v' lines), so the triples are
+        // deduplicated by value too. They are in order of first use, so the vertices end up in the same order
+        // as when every corner is deduplicated by value
+        std::vector<uint32_t> tripleToVertex(m_UniqueTriples.size());
+        for (size_t i = 0; i < tripleVertices.size(); i++)
+        {
+            auto unique = m_UniqueVertices.FindOrInsert(tripleVertices[i], m_Vertices.data());
+            if (unique.Inserted)
+                m_Vertices.push_back(tripleVertices[i]);
+
+            tripleToVertex[i] = unique.Index;
+        }
+
+        // Finally point every range's indices at the final vertices
+        run_tasks(ranges.size(), [&](size_t rangeIndex) {
+            FaceRange& range = ranges[rangeIndex];
+
+            for (auto& index : range.LocalToGlobal)
+                index = tripleToVertex[index];
+
+            for (size_t i = range.IndexBegin; i < range.IndexEnd; i++)
+                m_Indices[i] = range.LocalToGlobal[m_Indices[i]];
+        });
     }
 
-    void ModelBuilder::AddVertex(const tinyobj::index_t& index_elem)
+    ThreadPool& ModelBuilder::GetThreadPool()
+    {
+        if (!m_ThreadPool)
+            m_ThreadPool = std::make_unique<ThreadPool>();
+
+        return *m_ThreadPool;
+    }
+
+    Vertex ModelBuilder::AssembleVertex(const tinyobj::index_t& index_elem) const
     {
         Vertex vertex;
 
+        // Positions and normals have already been converted to the target system by BuildWavefrontObj()
         vertex.position = {
             attrib->vertices[3 * index_elem.vertex_index + 0],
             attrib->vertices[3 * index_elem.vertex_index + 1],
             attrib->vertices[3 * index_elem.vertex_index + 2],
         };
 
-        converter->ConvertInPlace(vertex.position);
-        
         // Normals are optional in obj files
         if (index_elem.normal_index >= 0)
         {
@@ -271,8 +960,6 @@ namespace Tile {
                 attrib->normals[3 * index_elem.normal_index + 1],
                 attrib->normals[3 * index_elem.normal_index + 2],
             };
-
-            converter->ConvertInPlace(vertex.normal);
         }
         else {
             // Maybe change the default...
@@ -291,12 +978,6 @@ namespace Tile {
             vertex.textureCoords = { 0.f, 0.f };
         }
 
-        if (m_UniqueVertices.count(vertex) == 0)
-        {
-            m_UniqueVertices[vertex] = static_cast<uint32_t>(m_Vertices.size());
-            m_Vertices.push_back(vertex);
-        }
-
-        m_Indices.push_back(m_UniqueVertices[vertex]);
+        return vertex;
     }
 }
\ No newline at end of file
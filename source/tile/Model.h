@@ -1,15 +1,19 @@
 #pragma once
 
 #include "TinyObjLoader/tiny_obj_loader.h"
+#include "tile/DedupTable.h"
+#include "tile/GeometryPool.h"
 #include "tile/gl_wrappers.h"
 
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <memory>
 #include <unordered_map>
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
@@ -21,6 +25,10 @@ namespace tinyobj
 }
 
 namespace Tile {
+    class InstanceBuffer;
+    class ThreadPool;
+    struct QuantizedVertex;
+
     struct Vertex
     {
         glm::vec3 position;
@@ -61,35 +69,157 @@ namespace std {
 
 namespace Tile
 {
+    // Hashes the bit patterns of a Vertex's floats, which is a lot cheaper than going through
+    // std::hash<Vertex>. -0.0 is hashed like +0.0, so that the hash agrees with Vertex::operator==
+    struct VertexBitsHash
+    {
+        size_t operator()(const Vertex& vertex) const
+        {
+            static_assert(sizeof(Vertex) == 8 * sizeof(uint32_t), "Vertex is expected to be 8 tightly packed floats");
+
+            uint32_t words[8];
+            std::memcpy(words, &vertex, sizeof(words));
+
+            uint64_t pairs[4];
+            for (int i = 0; i < 4; i++)
+            {
+                uint32_t low = words[2 * i + 0] == 0x80000000u ? 0u : words[2 * i + 0];
+                uint32_t high = words[2 * i + 1] == 0x80000000u ? 0u : words[2 * i + 1];
+                pairs[i] = (static_cast<uint64_t>(high) << 32) | low;
+            }
+
+            uint64_t hash = pairs[0] * 0x9E3779B97F4A7C15ull ^ pairs[1] * 0xBF58476D1CE4E5B9ull ^
+                            pairs[2] * 0x94D049BB133111EBull ^ pairs[3] * 0xD6E8FEB86659FD93ull;
+
+            hash ^= hash >> 32;
+            hash *= 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    // Hash and equality for the (position, normal, texcoord) index triple of a face corner
+    struct IndexTripleHash
+    {
+        size_t operator()(const tinyobj::index_t& index) const
+        {
+            uint64_t positionAndNormal = static_cast<uint64_t>(static_cast<uint32_t>(index.vertex_index)) |
+                                         static_cast<uint64_t>(static_cast<uint32_t>(index.normal_index)) << 32;
+            uint64_t texcoord = static_cast<uint32_t>(index.texcoord_index);
+
+            uint64_t hash = positionAndNormal * 0x9E3779B97F4A7C15ull ^ texcoord * 0xBF58476D1CE4E5B9ull;
+            hash ^= hash >> 32;
+            hash *= 0x94D049BB133111EBull;
+            hash ^= hash >> 29;
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct IndexTripleEqual
+    {
+        bool operator()(const tinyobj::index_t& a, const tinyobj::index_t& b) const
+        {
+            return  a.vertex_index == b.vertex_index &&
+                    a.normal_index == b.normal_index &&
+                    a.texcoord_index == b.texcoord_index;
+        }
+    };
+
+    // A range of a model's index buffer whose indices are relative to `BaseVertex`, so that meshes with more
+    // vertices than 16 bit indices can address are still drawn with them (see SplitIntoShortIndexChunks())
+    struct IndexChunk
+    {
+        uint32_t FirstIndex;
+        uint32_t IndexCount;
+        int32_t BaseVertex;
+    };
+
+    // The layout of vertex buffers holding Vertex-es
+    extern const VertexLayout VERTEX_LAYOUT;
 
     class Model
     {
     public:
 
+        // A model with its own vertex array and buffers, filled in by the Create...Buffer() functions
         Model();
 
-        ~Model() = default;
+        // A model whose geometry lives in `pool` (at `allocation`, which is freed with the model) and which owns
+        // no GPU objects itself. The chunks are absolute, i.e their first indices and base vertices point into
+        // the pool's buffers
+        Model(std::shared_ptr<GeometryPool> pool, const GeometryAllocation& allocation,
+              const std::vector<IndexChunk>& chunks, const glm::mat4& dequantize);
+
+        ~Model();
 
-        inline const VertexArray& GetVA()       const { return m_VA;   }
-        inline const VertexBuffer& GetVBuf()    const { return m_VBuf; }
-        inline const IndexBuffer& GetIBuf()     const { return m_IBuf; }
+        Model(const Model&) = delete;
+        Model& operator=(const Model&) = delete;
+
+        // The pool's vertex array and buffers for pooled models
+        const VertexArray& GetVA()       const;
+        const VertexBuffer& GetVBuf()    const;
+        const IndexBuffer& GetIBuf()     const;
+
+        inline bool IsPooled() const { return m_Pool != nullptr; }
+        inline const std::shared_ptr<GeometryPool>& GetPool() const { return m_Pool; }
+        inline const GeometryAllocation& GetPoolAllocation() const { return m_PoolAllocation; }
 
         inline int GetVertexCount()     const { return m_VertexCount;    }
         inline int GetIndexCount()      const { return m_IndexCount;     }
         inline bool HasIndexBuffer()    const { return m_HasIndexBuffer; }
 
+        // The vertex and index buffer sizes in bytes
+        inline size_t GetVertexBufferSize() const { return m_VertexBufferSize; }
+        inline size_t GetIndexBufferSize()  const { return GetIBuf().GetIndexSize() * static_cast<size_t>(m_IndexCount); }
+
+        inline IndexType GetIndexType() const { return GetIBuf().GetIndexType(); }
+        inline const std::vector<IndexChunk>& GetIndexChunks() const { return m_IndexChunks; }
+
+        // Has to be applied to the positions before the model matrix (see QuantizedMesh::Dequantize). The
+        // identity unless the vertex buffer holds QuantizedVertex-es
+        inline const glm::mat4& GetDequantizeTransform() const { return m_DequantizeTransform; }
+
+        // The functions below are only for models with their own buffers
+
         void CreateVertexBuffer(const std::vector<Vertex>& vertices);
         void CreateIndexBuffer(const std::vector<uint32_t>& indices);
 
+        void CreateVertexBuffer(const Vertex* vertices, size_t count);
+
+        // Uploads 16 bit indices instead if every index fits in them
+        void CreateIndexBuffer(const uint32_t* indices, size_t count);
+
+        void CreateVertexBuffer(const QuantizedVertex* vertices, size_t count, const glm::mat4& dequantize);
+
+        // Indices relative to the base vertex of the chunk they are in
+        void CreateIndexBuffer(const uint16_t* indices, size_t count, const std::vector<IndexChunk>& chunks);
+
+        // Draws the whole model as triangles with the bound shader, one draw call per index chunk.
+        // Binds the vertex array
+        void Draw() const;
+
+        // Draws every instance in `instances` with one draw call per index chunk. The instance attributes are
+        // attached to the vertex array first (for pooled models to the pool's), so the shader has to take them
+        // like InstancedDiffuseModel.glsl (or ...TRS.glsl) does
+        void DrawInstanced(const InstanceBuffer& instances) const;
+
     private:
-        VertexArray m_VA;
+        // Null for pooled models
+        std::unique_ptr<VertexArray> m_VA;
+        std::unique_ptr<VertexBuffer> m_VBuf;
+        std::unique_ptr<IndexBuffer> m_IBuf;
+
+        // Null for models with their own buffers
+        std::shared_ptr<GeometryPool> m_Pool;
+        GeometryAllocation m_PoolAllocation;
 
-        VertexBuffer m_VBuf;
         int m_VertexCount = 0;
+        size_t m_VertexBufferSize = 0;
+        glm::mat4 m_DequantizeTransform = glm::mat4(1.f);
 
         bool m_HasIndexBuffer = false;
-        IndexBuffer m_IBuf;
         int m_IndexCount = 0;
+        std::vector<IndexChunk> m_IndexChunks;
     };
 
     /* ========================================================= */
@@ -147,6 +277,11 @@ namespace Tile
 
         void ConvertInPlace(glm::vec3& vec) const;
 
+        // Converts `count` tightly packed vec3s (x0, y0, z0, x1, y1, z1, ...) in place, e.g the positions or
+        // normals of a tinyobj::attrib_t. Gives the same results as calling ConvertInPlace() on each of them,
+        // but the permutation is picked once for the whole array and the vectors are converted 4 at a time with SSE
+        void ConvertArrayInPlace(float* vecs, size_t count) const;
+
         struct CompMove 
         {
             uint8_t SourceCompLocation;
@@ -162,10 +297,76 @@ namespace Tile
     /* ========================================================================================================= */
     /* ============================================== SPACE STUFF ============================================== */
     /* ========================================================================================================= */
+
+    // Which parser ModelBuilder reads .obj files with. Both produce the exact same models
+    enum class ObjParseMode
+    {
+        // tinyobj::LoadObj(), single threaded
+        TinyObj,
+
+        // Tile::ObjParser, parses chunks of the file in parallel
+        Parallel
+    };
+
     class ModelBuilder
     {
     public:
         ModelBuilder();
+        ~ModelBuilder();
+
+        inline void SetParseMode(ObjParseMode mode) { m_ParseMode = mode; }
+        inline ObjParseMode GetParseMode() const { return m_ParseMode; }
+
+        // Whether the parallel parser memory maps the source file (the default) or reads it into
+        // memory first. Has no effect on ObjParseMode::TinyObj
+        inline void SetMemoryMapping(bool enabled) { m_UseMemoryMapping = enabled; }
+
+        // When enabled (the default) face corners are first deduplicated on their (position, normal, texcoord)
+        // index triple, so that a Vertex is only assembled and converted once per unique triple instead of once
+        // per corner. The unique triples are then deduplicated by value like before, so the output is the same
+        inline void SetIndexTripleDedup(bool enabled) { m_IndexTripleDedup = enabled; }
+
+        // The coordinate system the .obj files are authored in (source) and the one the
+        // models are converted to (target)
+        inline void SetCoordinateSystems(const CoordinateSystem3D& source, const CoordinateSystem3D& target)
+        {
+            m_SourceSystem = source;
+            m_TargetSystem = target;
+        }
+
+        // When enabled, the triangles of every built model are reordered for post-transform vertex cache
+        // locality and its vertices for sequential fetching (see MeshOptimizer.h), and the vertex cache
+        // statistics before and after are reported. Off by default, since it costs a fair bit of build time
+        inline void SetVertexCacheOptimization(bool enabled) { m_OptimizeVertexCache = enabled; }
+
+        // When enabled, LoadWavefrontObj() uploads QuantizedVertex-es (16 bytes) instead of full Vertex-es
+        // (32 bytes). Whoever draws the model then has to apply Model::GetDequantizeTransform() to the positions.
+        // Only affects the upload, the built (and cached) vertices stay full floats
+        inline void SetVertexQuantization(bool enabled) { m_QuantizeVertices = enabled; }
+
+        // Models with up to 65536 vertices always get 16 bit indices. When enabled, LoadWavefrontObj() splits
+        // larger ones into chunks of at most that many vertices so that they get them too, at the cost of
+        // duplicating the vertices shared between chunks and a draw call per chunk
+        inline void SetIndexChunking(bool enabled) { m_ChunkIndices = enabled; }
+
+        // When set, LoadWavefrontObj() uploads into the pool (always with chunked 16 bit indices) and returns
+        // models that are handles into it. Null (the default) gives every model its own buffers
+        inline void SetGeometryPool(std::shared_ptr<GeometryPool> pool) { m_GeometryPool = std::move(pool); }
+
+        // When enabled, the vertex cache ordered triangles are additionally split into clusters which are sorted
+        // so that the ones likely to occlude the rest of the model are drawn first (see OptimizeOverdraw()).
+        // `acmrThreshold` bounds how much the vertex cache may suffer for it. Runs the vertex cache optimization
+        // too, whether that is enabled or not, since the clusters are cut from its order
+        inline void SetOverdrawOptimization(bool enabled, float acmrThreshold = 1.05f)
+        {
+            m_OptimizeOverdraw = enabled;
+            m_OverdrawThreshold = acmrThreshold;
+        }
+
+        // Directory for the binary mesh cache (see MeshCache). When set, LoadWavefrontObj() first looks for
+        // an up to date cached copy of the model and only parses the .obj file on a miss, storing the result
+        // for the next time. Empty (the default) disables the cache
+        inline void SetCacheDirectory(const std::string& directory) { m_CacheDirectory = directory; }
 
         inline std::shared_ptr<Model> LoadWavefrontObj(const std::string& filepath)
         {
@@ -174,10 +375,58 @@ namespace Tile
 
         std::shared_ptr<Model> LoadWavefrontObj(const std::string& filepath, const std::string& shapeName);
 
+        // Does everything LoadWavefrontObj() does except creating the GPU buffers. The resulting
+        // vertices and indices are available through GetVertices() and GetIndices() afterwards.
+        //
+        // Returns false if the file could not be loaded
+        bool BuildWavefrontObj(const std::string& filepath, const std::string& shapeName);
+
+        inline const std::vector<Vertex>& GetVertices()     const { return m_Vertices; }
+        inline const std::vector<uint32_t>& GetIndices()    const { return m_Indices;  }
+
     private:
         void AddVertex(const tinyobj::index_t& index_elem);
 
+        Vertex AssembleVertex(const tinyobj::index_t& index_elem) const;
+
+        // Triangulates and deduplicates the faces in index triple mode. Ranges of faces are triangulated and
+        // deduplicated on the thread pool, then merged in order, so the result does not depend on the thread count
+        void BuildFromIndexTriples(const std::vector<tinyobj::shape_t>& shapes,
+                                   const std::vector<std::vector<uint32_t>>& faceSizes,
+                                   const std::string& shapeName,
+                                   bool toggleWindingOrder,
+                                   size_t expectedUniqueVertices);
+
+        // Creates the GPU buffers of a loaded model (or allocates it in the geometry pool), chunking the indices
+        // and quantizing the vertices first if enabled
+        std::shared_ptr<Model> CreateModel(const Vertex* vertices, size_t vertexCount,
+                                           const uint32_t* indices, size_t indexCount) const;
+
+        // Runs the vertex cache, overdraw (if enabled) and vertex fetch optimizations on m_Indices and m_Vertices
+        void OptimizeMesh(const std::string& filepath);
+
+        ThreadPool& GetThreadPool();
+
     private:
+        ObjParseMode m_ParseMode = ObjParseMode::Parallel;
+        bool m_UseMemoryMapping = true;
+        bool m_IndexTripleDedup = true;
+        bool m_OptimizeVertexCache = false;
+        bool m_OptimizeOverdraw = false;
+        float m_OverdrawThreshold = 1.05f;
+        bool m_QuantizeVertices = false;
+        bool m_ChunkIndices = false;
+
+        std::shared_ptr<GeometryPool> m_GeometryPool;
+
+        CoordinateSystem3D m_SourceSystem;
+        CoordinateSystem3D m_TargetSystem;
+
+        std::string m_CacheDirectory;
+
+        // Created on first use by the parallel parser or BuildFromIndexTriples()
+        std::unique_ptr<ThreadPool> m_ThreadPool;
+
 
         std::unique_ptr<SpaceConverter> converter;
 
@@ -185,7 +434,11 @@ namespace Tile
         std::vector<uint32_t> m_Indices;
 
         // A map from a given (unique) vertex to its index in `m_Vertices`
-        std::unordered_map<Vertex, uint32_t> m_UniqueVertices; 
+        DedupTable<Vertex, VertexBitsHash> m_UniqueVertices;
+
+        // The unique index triples seen so far and a map from each of them to its index in `m_UniqueTriples`
+        std::vector<tinyobj::index_t> m_UniqueTriples;
+        DedupTable<tinyobj::index_t, IndexTripleHash, IndexTripleEqual> m_UniqueTriplesTable;
 
         std::unique_ptr<tinyobj::attrib_t> attrib;
     };
@@ -0,0 +1,696 @@
+#include "tile/ObjParser.h"
+#include "tile/MappedFile.h"
+#include "tile/ThreadPool.h"
+
+#include <TinyObjLoader/tiny_obj_loader.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+    using namespace Tile;
+
+    // Chunks smaller than this are not worth a separate task
+    constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+    // How many chunks each thread gets (on average). More chunks than threads evens out
+    // the load when some parts of the file are denser than others
+    constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    inline bool is_space(char c) { return c == ' ' || c == '\t'; }
+    inline bool is_digit(char c) { return static_cast<unsigned int>(c - '0') < 10u; }
+
+    // Same as the `isspace()` check done by `atoi()`
+    inline bool is_atoi_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    // Tries to parse a floating point number in [s, s_end)
+    //
+    // This follows the grammar AND the arithmetic of tinyobj's tryParseDouble() so that both loaders
+    // produce bit-identical values. The only difference is that this one never reads at or past s_end.
+    bool parse_double(const char* s, const char* s_end, double* result)
+    {
+        if (s >= s_end)
+            return false;
+
+        double mantissa = 0.0;
+        int exponent = 0;
+
+        char sign = '+';
+        char exp_sign = '+';
+        const char* curr = s;
+
+        int read = 0;
+        bool end_not_reached = false;
+        bool leading_decimal_dots = false;
+
+        if (*curr == '+' || *curr == '-')
+        {
+            sign = *curr;
+            curr++;
+            if ((curr != s_end) && (*curr == '.'))
+                leading_decimal_dots = true;
+        }
+        else if (is_digit(*curr)) { }
+        else if (*curr == '.')
+            leading_decimal_dots = true;
+        else
+            return false;
+
+        // Integer part
+        end_not_reached = (curr != s_end);
+        if (!leading_decimal_dots)
+        {
+            while (end_not_reached && is_digit(*curr))
+            {
+                mantissa *= 10;
+                mantissa += static_cast<int>(*curr - 0x30);
+                curr++;
+                read++;
+                end_not_reached = (curr != s_end);
+            }
+
+            if (read == 0)
+                return false;
+        }
+
+        if (!end_not_reached)
+            goto assemble;
+
+        // Decimal part
+        if (*curr == '.')
+        {
+            curr++;
+            read = 1;
+            end_not_reached = (curr != s_end);
+            while (end_not_reached && is_digit(*curr))
+            {
+                static const double pow_lut[] = {
+                    1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001,
+                };
+                const int lut_entries = sizeof pow_lut / sizeof pow_lut[0];
+
+                mantissa += static_cast<int>(*curr - 0x30) *
+                            (read < lut_entries ? pow_lut[read] : std::pow(10.0, -read));
+                read++;
+                curr++;
+                end_not_reached = (curr != s_end);
+            }
+        }
+        else if (*curr == 'e' || *curr == 'E') { }
+        else
+            goto assemble;
+
+        if (!end_not_reached)
+            goto assemble;
+
+        // Exponent part
+        if (*curr == 'e' || *curr == 'E')
+        {
+            curr++;
+            end_not_reached = (curr != s_end);
+            if (end_not_reached && (*curr == '+' || *curr == '-'))
+            {
+                exp_sign = *curr;
+                curr++;
+            }
+            else if (end_not_reached && is_digit(*curr)) { }
+            else
+                return false;
+
+            read = 0;
+            end_not_reached = (curr != s_end);
+            while (end_not_reached && is_digit(*curr))
+            {
+                if (exponent > (std::numeric_limits<int>::max() / 10))
+                    return false;
+
+                exponent *= 10;
+                exponent += static_cast<int>(*curr - 0x30);
+                curr++;
+                read++;
+                end_not_reached = (curr != s_end);
+            }
+            exponent *= (exp_sign == '+' ? 1 : -1);
+            if (read == 0)
+                return false;
+        }
+
+    assemble:
+        *result = (sign == '+' ? 1 : -1) *
+                  (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+        return true;
+    }
+
+    // Reads the next whitespace separated real number of the line, or `default_value` if it is missing or malformed
+    inline float parse_real(const char*& token, const char* line_end, double default_value = 0.0)
+    {
+        while (token < line_end && is_space(*token))
+            token++;
+
+        const char* end = token;
+        while (end < line_end && !is_space(*end) && *end != '\r')
+            end++;
+
+        double val = default_value;
+        parse_double(token, end, &val);
+        token = end;
+
+        return static_cast<float>(val);
+    }
+
+    // Works like atoi(), but stops at `end`
+    inline int parse_int(const char* token, const char* end)
+    {
+        while (token < end && is_atoi_space(*token))
+            token++;
+
+        bool negative = false;
+        if (token < end && (*token == '+' || *token == '-'))
+        {
+            negative = *token == '-';
+            token++;
+        }
+
+        int64_t value = 0;
+        while (token < end && is_digit(*token))
+        {
+            value = value * 10 + (*token - '0');
+            token++;
+        }
+
+        return static_cast<int>(negative ? -value : value);
+    }
+
+    // Advances `token` to the next '/', ' ', '\t' or '\r'
+    inline void skip_index_token(const char*& token, const char* end)
+    {
+        while (token < end && *token != '/' && !is_space(*token) && *token != '\r')
+            token++;
+    }
+
+    enum IndexComponent : uint8_t
+    {
+        COMPONENT_VERTEX = 0,
+        COMPONENT_NORMAL = 1,
+        COMPONENT_TEXCOORD = 2,
+    };
+
+    // Makes an OBJ index zero based. Negative indices are relative to the current attribute count `n`.
+    // Zero is not allowed by the spec
+    inline bool fix_index(int idx, int n, int* ret, bool* is_relative)
+    {
+        *is_relative = idx < 0;
+
+        if (idx > 0)
+        {
+            *ret = idx - 1;
+            return true;
+        }
+
+        if (idx < 0)
+        {
+            *ret = n + idx;
+            return true;
+        }
+
+        return false;
+    }
+
+    struct GroupMarker
+    {
+        // Index (local to the chunk) of the first face that belongs to this group
+        size_t FaceIndex;
+        std::string Name;
+    };
+
+    // A relative index that was resolved against chunk-local attribute counts, and has
+    // to be shifted once the counts of the preceding chunks are known
+    struct RelativeIndexFixup
+    {
+        size_t CornerIndex;
+        IndexComponent Component;
+    };
+
+    struct ObjChunk
+    {
+        const char* Begin;
+        const char* End;
+
+        std::vector<float> Vertices;
+        std::vector<float> Normals;
+        std::vector<float> Texcoords;
+
+        // All the face corners of this chunk, and the number of corners of each face
+        std::vector<tinyobj::index_t> Corners;
+        std::vector<uint32_t> FaceSizes;
+
+        std::vector<GroupMarker> Groups;
+        std::vector<RelativeIndexFixup> Fixups;
+
+        size_t LineCount = 0;
+
+        bool Failed = false;
+        size_t ErrorLine = 0;
+    };
+
+    // Parses one face corner (i, i/j/k, i//k or i/j). Mirrors tinyobj's parseTriple()
+    bool parse_face_corner(const char*& token, const char* end, ObjChunk& chunk, tinyobj::index_t* ret)
+    {
+        const int vsize = static_cast<int>(chunk.Vertices.size() / 3);
+        const int vnsize = static_cast<int>(chunk.Normals.size() / 3);
+        const int vtsize = static_cast<int>(chunk.Texcoords.size() / 2);
+
+        const size_t cornerIndex = chunk.Corners.size();
+        bool relative;
+
+        tinyobj::index_t index { -1, -1, -1 };
+
+        auto fix = [&](int* out, int n, IndexComponent component) {
+            if (!fix_index(parse_int(token, end), n, out, &relative))
+                return false;
+
+            if (relative)
+                chunk.Fixups.push_back({ cornerIndex, component });
+
+            skip_index_token(token, end);
+            return true;
+        };
+
+        if (!fix(&index.vertex_index, vsize, COMPONENT_VERTEX))
+            return false;
+
+        if (token == end || token[0] != '/')
+        {
+            *ret = index;
+            return true;
+        }
+        token++;
+
+        // i//k
+        if (token < end && token[0] == '/')
+        {
+            token++;
+            if (!fix(&index.normal_index, vnsize, COMPONENT_NORMAL))
+                return false;
+
+            *ret = index;
+            return true;
+        }
+
+        // i/j/k or i/j
+        if (!fix(&index.texcoord_index, vtsize, COMPONENT_TEXCOORD))
+            return false;
+
+        if (token == end || token[0] != '/')
+        {
+            *ret = index;
+            return true;
+        }
+
+        // i/j/k
+        token++;
+        if (!fix(&index.normal_index, vnsize, COMPONENT_NORMAL))
+            return false;
+
+        *ret = index;
+        return true;
+    }
+
+    // Returns false on a malformed line
+    bool parse_line(const char* token, const char* end, ObjChunk& chunk)
+    {
+        while (token < end && is_space(*token))
+            token++;
+
+        if (token == end || token[0] == '#')
+            return true;
+
+        char c0 = token[0];
+        char c1 = token + 1 < end ? token[1] : '\0';
+        char c2 = token + 2 < end ? token[2] : '\0';
+
+        // vertex
+        if (c0 == 'v' && is_space(c1))
+        {
+            token += 2;
+            float x = parse_real(token, end);
+            float y = parse_real(token, end);
+            float z = parse_real(token, end);
+
+            chunk.Vertices.push_back(x);
+            chunk.Vertices.push_back(y);
+            chunk.Vertices.push_back(z);
+            return true;
+        }
+
+        // normal
+        if (c0 == 'v' && c1 == 'n' && is_space(c2))
+        {
+            token += 3;
+            float x = parse_real(token, end);
+            float y = parse_real(token, end);
+            float z = parse_real(token, end);
+
+            chunk.Normals.push_back(x);
+            chunk.Normals.push_back(y);
+            chunk.Normals.push_back(z);
+            return true;
+        }
+
+        // texcoord
+        if (c0 == 'v' && c1 == 't' && is_space(c2))
+        {
+            token += 3;
+            float u = parse_real(token, end);
+            float v = parse_real(token, end);
+
+            chunk.Texcoords.push_back(u);
+            chunk.Texcoords.push_back(v);
+            return true;
+        }
+
+        // face
+        if (c0 == 'f' && is_space(c1))
+        {
+            token += 2;
+            while (token < end && is_space(*token))
+                token++;
+
+            uint32_t faceSize = 0;
+            while (token < end)
+            {
+                tinyobj::index_t index;
+                if (!parse_face_corner(token, end, chunk, &index))
+                    return false;
+
+                chunk.Corners.push_back(index);
+                faceSize++;
+
+                while (token < end && (is_space(*token) || *token == '\r'))
+                    token++;
+            }
+
+            chunk.FaceSizes.push_back(faceSize);
+            return true;
+        }
+
+        // group name
+        if (c0 == 'g' && is_space(c1))
+        {
+            // The first "name" is the 'g' itself. Multiple group names are joined
+            // with a space, same as tinyobj
+            std::string name;
+            int nameCount = 0;
+
+            while (token < end)
+            {
+                while (token < end && is_space(*token))
+                    token++;
+
+                const char* nameEnd = token;
+                while (nameEnd < end && !is_space(*nameEnd) && *nameEnd != '\r')
+                    nameEnd++;
+
+                if (nameCount == 1)
+                    name.assign(token, nameEnd);
+                else if (nameCount > 1)
+                    name.append(" ").append(token, nameEnd);
+
+                nameCount++;
+                token = nameEnd;
+
+                while (token < end && (is_space(*token) || *token == '\r'))
+                    token++;
+            }
+
+            chunk.Groups.push_back({ chunk.FaceSizes.size(), name });
+            return true;
+        }
+
+        // object name
+        if (c0 == 'o' && is_space(c1))
+        {
+            chunk.Groups.push_back({ chunk.FaceSizes.size(), std::string(token + 2, end) });
+            return true;
+        }
+
+        // Everything else is either not needed or not supported
+        return true;
+    }
+
+    void parse_chunk(ObjChunk& chunk)
+    {
+        const char* cursor = chunk.Begin;
+
+        while (cursor < chunk.End)
+        {
+            // A line ends at "\n", "\r\n" or a lone "\r"
+            const char* lineEnd = cursor;
+            while (lineEnd < chunk.End && *lineEnd != '\n' && *lineEnd != '\r')
+                lineEnd++;
+
+            const char* next = lineEnd;
+            if (next < chunk.End)
+            {
+                if (*next == '\r' && next + 1 < chunk.End && next[1] == '\n')
+                    next += 2;
+                else
+                    next += 1;
+            }
+
+            chunk.LineCount++;
+
+            if (!parse_line(cursor, lineEnd, chunk))
+            {
+                chunk.Failed = true;
+                chunk.ErrorLine = chunk.LineCount;
+                return;
+            }
+
+            cursor = next;
+        }
+    }
+
+    // Splits [data, data + size) into roughly `count` pieces, each one starting at the beginning of a line
+    std::vector<ObjChunk> split_into_chunks(const char* data, size_t size, size_t count)
+    {
+        std::vector<ObjChunk> chunks;
+        const char* end = data + size;
+        const size_t targetSize = size / count + 1;
+
+        const char* begin = data;
+        while (begin < end)
+        {
+            const char* split = begin + targetSize < end ? begin + targetSize : end;
+
+            const char* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+            split = newline ? newline + 1 : end;
+
+            ObjChunk chunk;
+            chunk.Begin = begin;
+            chunk.End = split;
+            chunks.push_back(std::move(chunk));
+
+            begin = split;
+        }
+
+        return chunks;
+    }
+
+    template <typename T>
+    void copy_into(std::vector<T>& dest, size_t offset, const std::vector<T>& src)
+    {
+        if (!src.empty())
+            std::memcpy(dest.data() + offset, src.data(), src.size() * sizeof(T));
+    }
+}
+
+namespace Tile
+{
+    ObjParser::ObjParser(ThreadPool& pool)
+    :   m_Pool(pool)
+    {}
+
+    bool ObjParser::LoadFile(const std::string& filepath,
+                             tinyobj::attrib_t* attrib,
+                             std::vector<tinyobj::shape_t>* shapes,
+                             std::vector<std::vector<uint32_t>>* faceSizes,
+                             std::string* err)
+    {
+        // Read to the end in blocks when not mapped, which works for pipes as well (and fails on directories)
+        MappedFile file;
+        if (!file.Open(filepath, m_UseMemoryMapping))
+        {
+            if (err)
+                (*err) += "Cannot open file [" + filepath + "]\n";
+            return false;
+        }
+
+        return ParseChunks(file.GetData(), file.GetSize(), &file, attrib, shapes, faceSizes, err);
+    }
+
+    bool ObjParser::Parse(const char* data,
+                          size_t size,
+                          tinyobj::attrib_t* attrib,
+                          std::vector<tinyobj::shape_t>* shapes,
+                          std::vector<std::vector<uint32_t>>* faceSizes,
+                          std::string* err)
+    {
+        return ParseChunks(data, size, nullptr, attrib, shapes, faceSizes, err);
+    }
+
+    bool ObjParser::ParseChunks(const char* data,
+                                size_t size,
+                                MappedFile* source,
+                                tinyobj::attrib_t* attrib,
+                                std::vector<tinyobj::shape_t>* shapes,
+                                std::vector<std::vector<uint32_t>>* faceSizes,
+                                std::string* err)
+    {
+        size_t chunkCount = m_Pool.GetThreadCount() * CHUNKS_PER_THREAD;
+        if (size / chunkCount < MIN_CHUNK_SIZE)
+            chunkCount = size / MIN_CHUNK_SIZE + 1;
+
+        std::vector<ObjChunk> chunks = split_into_chunks(data, size, chunkCount);
+
+        /* ------------------------------------------- Parse ------------------------------------------- */
+
+        m_Pool.ParallelFor(chunks.size(), [&](size_t i) {
+            parse_chunk(chunks[i]);
+
+            // Everything needed has been copied out of the chunk by now
+            if (source)
+                source->Discard(chunks[i].Begin, chunks[i].End);
+        });
+
+        size_t linesBefore = 0;
+        for (const auto& chunk : chunks)
+        {
+            if (chunk.Failed)
+            {
+                if (err)
+                {
+                    std::stringstream ss;
+                    ss << "Failed parse `f' line(e.g. zero value for face index. line "
+                       << linesBefore + chunk.ErrorLine << ".)\n";
+                    (*err) += ss.str();
+                }
+                return false;
+            }
+
+            linesBefore += chunk.LineCount;
+        }
+
+        /* ------------------------------------------- Stitch ------------------------------------------- */
+
+        // Where each chunk's data starts in the merged arrays
+        struct ChunkOffsets
+        {
+            size_t Vertices, Normals, Texcoords;
+        };
+
+        std::vector<ChunkOffsets> offsets(chunks.size());
+        ChunkOffsets totals = { 0, 0, 0 };
+
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            offsets[i] = totals;
+            totals.Vertices += chunks[i].Vertices.size();
+            totals.Normals += chunks[i].Normals.size();
+            totals.Texcoords += chunks[i].Texcoords.size();
+        }
+
+        *attrib = tinyobj::attrib_t();
+        attrib->vertices.resize(totals.Vertices);
+        attrib->normals.resize(totals.Normals);
+        attrib->texcoords.resize(totals.Texcoords);
+
+        m_Pool.ParallelFor(chunks.size(), [&](size_t i) {
+            ObjChunk& chunk = chunks[i];
+
+            copy_into(attrib->vertices, offsets[i].Vertices, chunk.Vertices);
+            copy_into(attrib->normals, offsets[i].Normals, chunk.Normals);
+            copy_into(attrib->texcoords, offsets[i].Texcoords, chunk.Texcoords);
+
+            // Relative indices were resolved against the counts of this chunk alone
+            for (const auto& fixup : chunk.Fixups)
+            {
+                tinyobj::index_t& index = chunk.Corners[fixup.CornerIndex];
+                switch (fixup.Component)
+                {
+                case COMPONENT_VERTEX:
+                    index.vertex_index += static_cast<int>(offsets[i].Vertices / 3);
+                    break;
+                case COMPONENT_NORMAL:
+                    index.normal_index += static_cast<int>(offsets[i].Normals / 3);
+                    break;
+                case COMPONENT_TEXCOORD:
+                    index.texcoord_index += static_cast<int>(offsets[i].Texcoords / 2);
+                    break;
+                }
+            }
+
+            std::vector<float>().swap(chunk.Vertices);
+            std::vector<float>().swap(chunk.Normals);
+            std::vector<float>().swap(chunk.Texcoords);
+        });
+
+        /* ------------------------------------------- Shapes ------------------------------------------- */
+
+        // A new shape starts at every 'g' or 'o' record. Shapes without any faces are dropped, and so are
+        // faces with less than 3 corners (like tinyobj does)
+        shapes->clear();
+        faceSizes->clear();
+
+        tinyobj::shape_t shape;
+        std::vector<uint32_t> shapeFaceSizes;
+
+        auto append = [&](const ObjChunk& chunk, size_t faceEnd, size_t& face, size_t& corner) {
+            for (; face < faceEnd; face++)
+            {
+                uint32_t faceSize = chunk.FaceSizes[face];
+                if (faceSize >= 3)
+                {
+                    auto first = chunk.Corners.begin() + corner;
+                    shape.mesh.indices.insert(shape.mesh.indices.end(), first, first + faceSize);
+                    shapeFaceSizes.push_back(faceSize);
+                }
+
+                corner += faceSize;
+            }
+        };
+
+        auto flush = [&](const std::string& nextName) {
+            if (!shape.mesh.indices.empty())
+            {
+                shapes->push_back(std::move(shape));
+                faceSizes->push_back(std::move(shapeFaceSizes));
+            }
+
+            shape = tinyobj::shape_t();
+            shape.name = nextName;
+            shapeFaceSizes.clear();
+        };
+
+        for (const auto& chunk : chunks)
+        {
+            size_t face = 0;
+            size_t corner = 0;
+
+            for (const auto& group : chunk.Groups)
+            {
+                append(chunk, group.FaceIndex, face, corner);
+                flush(group.Name);
+            }
+
+            append(chunk, chunk.FaceSizes.size(), face, corner);
+        }
+        flush("");
+
+        return true;
+    }
+}
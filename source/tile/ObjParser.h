@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// forward declaration
+namespace tinyobj
+{
+    struct attrib_t;
+    struct shape_t;
+}
+
+namespace Tile
+{
+    class ThreadPool;
+    class MappedFile;
+
+    // A Wavefront OBJ parser that splits the file into chunks at line boundaries and parses the
+    // chunks on a ThreadPool. The per-chunk attribute arrays and faces are then stitched back together,
+    // with relative (negative) indices resolved against the global attribute counts.
+    //
+    // Its output matches tinyobj::LoadObj() with triangulation off: numbers are parsed exactly the way
+    // tinyobj does it and faces are left as they are in the file, so ModelBuilder ends up with the same
+    // polygons either way. The one difference is that tinyobj::mesh_t::num_face_vertices can not hold faces
+    // with more than 255 corners, so it is left empty and the face sizes of shapes[i] go to faceSizes[i].
+    //
+    // Only the records ModelBuilder consumes are read, i.e 'v', 'vn', 'vt', 'f', 'g' and 'o'. Materials,
+    // smoothing groups, vertex colors, lines and points are ignored.
+    //
+    // Lines are tokenized in place with hand-written number parsers, so no std::string or stream is
+    // created per line. By default LoadFile() memory maps the file (see MappedFile) and parses straight
+    // out of the mapped pages, dropping each chunk's pages once it has been parsed.
+    class ObjParser
+    {
+    public:
+        explicit ObjParser(ThreadPool& pool);
+
+        ObjParser(const ObjParser& other) = delete;
+        ObjParser& operator=(const ObjParser& other) = delete;
+
+        // When disabled, LoadFile() reads the whole file into memory instead (see MappedFile::Open())
+        inline void SetMemoryMapping(bool enabled) { m_UseMemoryMapping = enabled; }
+
+        bool LoadFile(const std::string& filepath,
+                      tinyobj::attrib_t* attrib,
+                      std::vector<tinyobj::shape_t>* shapes,
+                      std::vector<std::vector<uint32_t>>* faceSizes,
+                      std::string* err);
+
+        // Parses an in-memory OBJ file. `data` does not need to be null terminated
+        bool Parse(const char* data,
+                   size_t size,
+                   tinyobj::attrib_t* attrib,
+                   std::vector<tinyobj::shape_t>* shapes,
+                   std::vector<std::vector<uint32_t>>* faceSizes,
+                   std::string* err);
+
+    private:
+        // `source` is the file `data` was mapped from, if any
+        bool ParseChunks(const char* data,
+                         size_t size,
+                         MappedFile* source,
+                         tinyobj::attrib_t* attrib,
+                         std::vector<tinyobj::shape_t>* shapes,
+                         std::vector<std::vector<uint32_t>>* faceSizes,
+                         std::string* err);
+
+    private:
+        ThreadPool& m_Pool;
+        bool m_UseMemoryMapping = true;
+    };
+}
@@ -0,0 +1,202 @@
+#include "tile/ProgramCache.h"
+
+#include "tile/Hash.h"
+#include "tile/MappedFile.h"
+#include "tile/opengl_inc.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+    using namespace Tile;
+
+    // Bump whenever the layout of a cache file or the way the key is made changes
+    constexpr uint32_t CACHE_VERSION = 1;
+    constexpr char CACHE_MAGIC[4] = { 'T', 'P', 'R', 'G' };
+
+    // A cache file is laid out as:
+    //     CacheHeader | program binary
+    struct CacheHeader
+    {
+        char Magic[4];
+        uint32_t Version;
+        uint64_t Key;
+
+        uint32_t BinaryFormat;
+        uint32_t BinarySize;
+    };
+
+    uint64_t hash_gl_string(gl::GLenum name, uint64_t seed)
+    {
+        const char* value = reinterpret_cast<const char*>(gl::glGetString(name));
+        if (!value)
+            return seed;
+
+        return HashBytes(value, std::strlen(value), seed);
+    }
+
+    // The formats glProgramBinary() takes, anything else is an error rather than a failed link
+    std::vector<gl::GLenum> supported_binary_formats()
+    {
+        int formatCount = 0;
+        gl::glGetIntegerv(gl::GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+        std::vector<int> formats(std::max(formatCount, 0));
+        if (formatCount > 0)
+            gl::glGetIntegerv(gl::GL_PROGRAM_BINARY_FORMATS, formats.data());
+
+        return std::vector<gl::GLenum>(formats.begin(), formats.end());
+    }
+}
+
+namespace Tile
+{
+    ProgramCache::ProgramCache(const std::string& directory)
+    :   m_Directory(directory)
+    {
+        m_DriverHash = hash_gl_string(gl::GL_VENDOR, 0);
+        m_DriverHash = hash_gl_string(gl::GL_RENDERER, m_DriverHash);
+        m_DriverHash = hash_gl_string(gl::GL_VERSION, m_DriverHash);
+
+        m_Supported = !supported_binary_formats().empty();
+    }
+
+    uint64_t ProgramCache::MakeKey(const ShaderSources& sources) const
+    {
+        // In a fixed order of stages, ShaderSources' is unspecified
+        uint64_t hash = m_DriverHash;
+        for (ShaderType type : { ShaderType::Vertex, ShaderType::Fragment })
+        {
+            auto it = sources.find(type);
+            if (it == sources.end())
+                continue;
+
+            uint8_t stage = static_cast<uint8_t>(type);
+            hash = HashBytes(&stage, sizeof(stage), hash);
+            hash = HashBytes(it->second.data(), it->second.size(), hash);
+        }
+
+        return hash;
+    }
+
+    std::string ProgramCache::GetEntryPath(uint64_t key) const
+    {
+        char name[17];
+        for (int i = 0; i < 16; i++)
+            name[i] = "0123456789abcdef"[(key >> (60 - 4 * i)) & 0xF];
+        name[16] = '\0';
+
+        return (std::filesystem::path(m_Directory) / (std::string(name) + ".tprog")).string();
+    }
+
+    unsigned int ProgramCache::Load(uint64_t key) const
+    {
+        if (!m_Supported)
+            return 0;
+
+        MappedFile file;
+        if (!file.Open(GetEntryPath(key)))
+            return 0;
+
+        const char* data = file.GetData();
+        size_t size = file.GetSize();
+
+        CacheHeader header;
+        if (size < sizeof(header))
+            return 0;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+            header.Version != CACHE_VERSION ||
+            header.Key != key ||
+            size != sizeof(header) + header.BinarySize)
+            return 0;
+
+        std::vector<gl::GLenum> formats = supported_binary_formats();
+        if (std::find(formats.begin(), formats.end(), header.BinaryFormat) == formats.end())
+            return 0;
+
+        unsigned int program = gl::glCreateProgram();
+        gl::glProgramBinary(program, header.BinaryFormat, data + sizeof(header),
+                            static_cast<gl::GLsizei>(header.BinarySize));
+
+        int success = gl::GL_FALSE;
+        gl::glGetProgramiv(program, gl::GL_LINK_STATUS, &success);
+        if (success == gl::GL_FALSE)
+        {
+            gl::glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    bool ProgramCache::Store(uint64_t key, unsigned int program) const
+    {
+        if (!m_Supported)
+            return false;
+
+        int length = 0;
+        gl::glGetProgramiv(program, gl::GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return false;
+
+        std::vector<char> binary(length);
+        gl::GLsizei written = 0;
+        gl::GLenum format = 0;
+        gl::glGetProgramBinary(program, length, &written, &format, binary.data());
+        if (written <= 0)
+            return false;
+
+        CacheHeader header;
+        std::memcpy(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.Version = CACHE_VERSION;
+        header.Key = key;
+        header.BinaryFormat = static_cast<uint32_t>(format);
+        header.BinarySize = static_cast<uint32_t>(written);
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_Directory, ec);
+
+        // Written under a temporary name and renamed into place, so a reader never sees a partial entry
+        std::string entryPath = GetEntryPath(key);
+        std::string tempPath = entryPath + ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cerr << "[WARN] Could not write program cache entry: \"" << entryPath << "\"" << std::endl;
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), written);
+
+            if (!file)
+            {
+                std::cerr << "[WARN] Could not write program cache entry: \"" << entryPath << "\"" << std::endl;
+                file.close();
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tempPath, entryPath, ec);
+        if (ec)
+        {
+            std::cerr << "[WARN] Could not write program cache entry: \"" << entryPath << "\". " << ec.message()
+                      << std::endl;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "tile/Shader.h"
+
+#include <cstdint>
+#include <string>
+
+namespace Tile
+{
+    // An on-disk cache of linked programs, as glGetProgramBinary() returns them, so that a program only has
+    // to be compiled from source the first time it is used. Every program is a single file in the cache
+    // directory, named after its key.
+    //
+    // The key is a hash of the program's sources and the GL_VENDOR, GL_RENDERER and GL_VERSION strings, so
+    // a changed shader or a driver update is a miss. The driver may still reject a binary it produced (they
+    // are allowed to), Load() then fails like on a miss and the entry is overwritten by the next Store()
+    class ProgramCache
+    {
+    public:
+        // Needs the context the programs are made for to be current, for the driver strings
+        explicit ProgramCache(const std::string& directory);
+
+        uint64_t MakeKey(const ShaderSources& sources) const;
+
+        // Returns a linked program, or 0 on a cache miss
+        unsigned int Load(uint64_t key) const;
+
+        // Returns false if the entry could not be written. Binaries are only retrievable from programs that
+        // were linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set. The cache directory is created if needed
+        bool Store(uint64_t key, unsigned int program) const;
+
+        std::string GetEntryPath(uint64_t key) const;
+
+        // Whether the driver has any binary format, if not every Load() misses and Store() fails
+        inline bool IsSupported() const { return m_Supported; }
+
+    private:
+        std::string m_Directory;
+
+        uint64_t m_DriverHash = 0;
+        bool m_Supported = false;
+    };
+}
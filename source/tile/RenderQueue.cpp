@@ -0,0 +1,192 @@
+#include "tile/RenderQueue.h"
+#include "tile/GlState.h"
+#include "tile/Model.h"
+#include "tile/Shader.h"
+#include "tile/ShaderConstants.h"
+#include "tile/Texture.h"
+#include "tile/gl_wrappers.h"
+#include "tile/opengl_inc.h"
+
+#include <algorithm>
+
+#include <glm/geometric.hpp>
+
+namespace
+{
+    using namespace Tile;
+
+    constexpr int PASS_SHIFT = 60;
+    constexpr uint64_t FIELD_MASK_16 = 0xFFFF;
+
+    // Least significant digit first, 8 bits per pass. The keys end up in `keys` and `order` follows them.
+    // Passes over digits that are the same in every key (e.g the unused bits, or the pass when everything is
+    // opaque) change nothing and are skipped
+    void radix_sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order,
+                    std::vector<uint64_t>& scratchKeys, std::vector<uint32_t>& scratchOrder)
+    {
+        constexpr int DIGIT_COUNT = 8;
+        constexpr int BUCKET_COUNT = 256;
+
+        size_t count = keys.size();
+        scratchKeys.resize(count);
+        scratchOrder.resize(count);
+
+        // All the digits' histograms in one go over the keys
+        uint32_t histograms[DIGIT_COUNT][BUCKET_COUNT] = {};
+        for (uint64_t key : keys)
+        {
+            for (int digit = 0; digit < DIGIT_COUNT; digit++)
+                histograms[digit][(key >> (8 * digit)) & 0xFF]++;
+        }
+
+        for (int digit = 0; digit < DIGIT_COUNT; digit++)
+        {
+            uint32_t* histogram = histograms[digit];
+            if (histogram[(keys[0] >> (8 * digit)) & 0xFF] == count)
+                continue;
+
+            // Into the offsets every bucket starts at
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+            {
+                uint32_t bucketSize = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketSize;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t target = histogram[(keys[i] >> (8 * digit)) & 0xFF]++;
+                scratchKeys[target] = keys[i];
+                scratchOrder[target] = order[i];
+            }
+
+            keys.swap(scratchKeys);
+            order.swap(scratchOrder);
+        }
+    }
+
+    void apply_pass_state(RenderPass pass)
+    {
+        GlStateCache& state = GetGlState();
+
+        if (pass == RenderPass::Opaque)
+        {
+            state.Disable(gl::GL_BLEND);
+            state.Enable(gl::GL_CULL_FACE);
+        }
+        else
+        {
+            state.Disable(gl::GL_CULL_FACE);
+            state.Enable(gl::GL_BLEND);
+        }
+    }
+}
+
+namespace Tile
+{
+    uint64_t RenderQueue::MakeSortKey(RenderPass pass, uint32_t shaderID, uint32_t textureID, float depth)
+    {
+        auto quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.f, 1.f) * DEPTH_MAX);
+        uint64_t shader = shaderID & FIELD_MASK_16;
+        uint64_t texture = textureID & FIELD_MASK_16;
+
+        uint64_t key = static_cast<uint64_t>(pass) << PASS_SHIFT;
+
+        if (pass == RenderPass::Opaque)
+            return key | shader << 44 | texture << 28 | quantizedDepth << 4;
+
+        // Farthest first
+        return key | (DEPTH_MAX - quantizedDepth) << 36 | shader << 20 | texture << 4;
+    }
+
+    void RenderQueue::Begin(const glm::vec3& viewPosition, float farPlane)
+    {
+        m_Packets.clear();
+        m_Keys.clear();
+        m_Order.clear();
+
+        m_ViewPosition = viewPosition;
+        m_InverseFarPlane = farPlane > 0.f ? 1.f / farPlane : 1.f;
+        m_Sorted = true;
+    }
+
+    void RenderQueue::Submit(RenderPass pass, Shader& shader, const Model& model, const glm::mat4& transform,
+                             const glm::vec3& color, const Texture* texture)
+    {
+        DrawPacket packet;
+        packet.Program = &shader;
+        packet.Tex = texture;
+        packet.Mesh = &model;
+        packet.Transform = transform;
+        packet.Color = color;
+
+        float depth = glm::length(glm::vec3(transform[3]) - m_ViewPosition) * m_InverseFarPlane;
+        Push(packet, pass, texture ? texture->GetID() : 0, depth);
+    }
+
+    void RenderQueue::Submit(RenderPass pass, Shader& shader, const VertexArray& vertices, uint32_t vertexCount,
+                             float depth, const Texture* texture)
+    {
+        DrawPacket packet;
+        packet.Program = &shader;
+        packet.Tex = texture;
+        packet.Vertices = &vertices;
+        packet.VertexCount = vertexCount;
+
+        Push(packet, pass, texture ? texture->GetID() : 0, depth);
+    }
+
+    void RenderQueue::Push(const DrawPacket& packet, RenderPass pass, uint32_t textureID, float depth)
+    {
+        m_Keys.push_back(MakeSortKey(pass, packet.Program->GetID(), textureID, depth));
+        m_Order.push_back(static_cast<uint32_t>(m_Packets.size()));
+        m_Packets.push_back(packet);
+        m_Sorted = false;
+    }
+
+    void RenderQueue::Sort()
+    {
+        if (!m_Sorted && !m_Keys.empty())
+            radix_sort(m_Keys, m_Order, m_ScratchKeys, m_ScratchOrder);
+
+        m_Sorted = true;
+    }
+
+    void RenderQueue::Execute(ShaderConstants& constants)
+    {
+        Sort();
+
+        // The state cache filters whatever does not change from one packet to the next
+        for (size_t i = 0; i < m_Order.size(); i++)
+        {
+            const DrawPacket& packet = m_Packets[m_Order[i]];
+
+            Shader* program = packet.Program;
+            if (!program->IsReady())
+            {
+                program = packet.Mesh ? m_FallbackShader : nullptr;
+                if (!program || !program->IsReady())
+                    continue;
+            }
+
+            apply_pass_state(static_cast<RenderPass>(m_Keys[i] >> PASS_SHIFT));
+            program->Bind();
+
+            if (packet.Tex)
+                packet.Tex->Bind(0);
+
+            if (packet.Mesh)
+            {
+                constants.SetObject(MakeObjectConstants(packet.Transform, packet.Mesh->GetDequantizeTransform(),
+                                                        packet.Color));
+                packet.Mesh->Draw();
+            }
+            else if (packet.Vertices)
+            {
+                packet.Vertices->Bind();
+                gl::glDrawArrays(gl::GL_TRIANGLES, 0, static_cast<gl::GLsizei>(packet.VertexCount));
+            }
+        }
+    }
+}
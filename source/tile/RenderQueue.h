@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace Tile
+{
+    class Model;
+    class Shader;
+    class ShaderConstants;
+    class Texture;
+    class VertexArray;
+
+    // Executed in this order
+    enum class RenderPass : uint8_t
+    {
+        // Depth tested and written, back faces culled, no blending
+        Opaque,
+
+        // Blended, no culling (e.g the world grid)
+        Transparent
+    };
+
+    // What it takes to issue one draw. Packets are not moved by the sorting, only their keys are
+    struct DrawPacket
+    {
+        Shader* Program = nullptr;
+
+        // Bound to slot 0 if there is one
+        const Texture* Tex = nullptr;
+
+        // Either a model, drawn with its ObjectConstants made from the fields below ...
+        const Model* Mesh = nullptr;
+        glm::mat4 Transform { 1.f };
+        glm::vec3 Color { 1.f };
+
+        // ... or a vertex array, drawn as VertexCount vertices with the constants left as they are
+        const VertexArray* Vertices = nullptr;
+        uint32_t VertexCount = 0;
+    };
+
+    // Collects the frame's draws and issues them in an order that keeps state changes and overdraw down,
+    // instead of the order they were submitted in.
+    //
+    // Every packet gets a 64 bit key, from the most significant bits:
+    //   opaque:      pass (4) | shader (16) | texture (16) | depth, front to back (24) | unused (4)
+    //   transparent: pass (4) | depth, back to front (24) | shader (16) | texture (16) | unused (4)
+    // so opaque draws are grouped by state and then sorted for early-Z, and blended draws composite in the
+    // right order. The shader and texture fields are the low bits of the GL names, a collision only costs a
+    // state change. The keys are radix sorted, which is linear in the packet count
+    class RenderQueue
+    {
+    public:
+        // The depth field's range; depths are distances from the view position divided by the far plane
+        static constexpr uint32_t DEPTH_MAX = (1u << 24) - 1;
+
+        static uint64_t MakeSortKey(RenderPass pass, uint32_t shaderID, uint32_t textureID, float depth);
+
+        // Forgets the packets submitted since the last Begin(). Depths are measured from `viewPosition`
+        void Begin(const glm::vec3& viewPosition, float farPlane);
+
+        // Depth is the distance to the model's origin
+        void Submit(RenderPass pass, Shader& shader, const Model& model, const glm::mat4& transform,
+                    const glm::vec3& color, const Texture* texture = nullptr);
+
+        // `depth` is in [0, 1], 0 at the view position and 1 at the far plane
+        void Submit(RenderPass pass, Shader& shader, const VertexArray& vertices, uint32_t vertexCount,
+                    float depth, const Texture* texture = nullptr);
+
+        // Orders the packets by their keys. Done by Execute() if it has not been already
+        void Sort();
+
+        // Issues the packets in key order. Sets the pass state and each model's ObjectConstants, the frame's
+        // have to be set already. The packets stay until the next Begin()
+        void Execute(ShaderConstants& constants);
+
+        // Draws the model packets whose shader is not ready yet (see ShaderCompileMode::Async), so that a shader
+        // that is still compiling does not hold the frame up. Without one, and for vertex array packets, such
+        // packets are skipped
+        inline void SetFallbackShader(Shader* shader) { m_FallbackShader = shader; }
+
+        inline size_t GetPacketCount() const { return m_Packets.size(); }
+
+    private:
+        void Push(const DrawPacket& packet, RenderPass pass, uint32_t textureID, float depth);
+
+    private:
+        std::vector<DrawPacket> m_Packets;
+
+        // m_Keys[i] is the key of m_Packets[m_Order[i]]
+        std::vector<uint64_t> m_Keys;
+        std::vector<uint32_t> m_Order;
+
+        // The radix sort's ping pong buffers, kept so that they are not reallocated every frame
+        std::vector<uint64_t> m_ScratchKeys;
+        std::vector<uint32_t> m_ScratchOrder;
+
+        Shader* m_FallbackShader = nullptr;
+
+        glm::vec3 m_ViewPosition { 0.f };
+        float m_InverseFarPlane = 1.f;
+        bool m_Sorted = true;
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Tile
+{
+    // The kinds of state changes that go through GlStateCache, and uniform uploads, which Shader filters the same way
+    enum class StateChange
+    {
+        Program,
+        VertexArray,
+        Buffer,
+        Texture,
+        ActiveTexture,
+        Capability,
+        Uniform
+    };
+
+    constexpr int STATE_CHANGE_KIND_COUNT = 7;
+
+    // How many of the state changes requested through GlStateCache reached GL (issued) and how many were
+    // skipped because they would not have changed anything (filtered). The application resets them every frame
+    struct RenderStats
+    {
+        uint32_t Issued[STATE_CHANGE_KIND_COUNT] = {};
+        uint32_t Filtered[STATE_CHANGE_KIND_COUNT] = {};
+
+        inline uint32_t GetIssued(StateChange kind)     const { return Issued[static_cast<int>(kind)];   }
+        inline uint32_t GetFiltered(StateChange kind)   const { return Filtered[static_cast<int>(kind)]; }
+
+        uint32_t GetIssued() const
+        {
+            uint32_t total = 0;
+            for (uint32_t count : Issued)
+                total += count;
+            return total;
+        }
+
+        uint32_t GetFiltered() const
+        {
+            uint32_t total = 0;
+            for (uint32_t count : Filtered)
+                total += count;
+            return total;
+        }
+    };
+
+    inline const char* StateChangeName(StateChange kind)
+    {
+        switch (kind)
+        {
+        case StateChange::Program:          return "program";
+        case StateChange::VertexArray:      return "vertex array";
+        case StateChange::Buffer:           return "buffer";
+        case StateChange::Texture:          return "texture";
+        case StateChange::ActiveTexture:    return "active texture";
+        case StateChange::Capability:       return "capability";
+        case StateChange::Uniform:          return "uniform";
+
+        default:
+            return "";
+        }
+    }
+}
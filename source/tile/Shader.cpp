@@ -1,7 +1,12 @@
 #include "tile/Shader.h"
 
+#include "tile/GlState.h"
+#include "tile/ProgramCache.h"
+#include "tile/gl_extensions.h"
 #include "tile/opengl_inc.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -27,50 +32,136 @@ namespace {
         }
     }
 
-    bool read_shader_source_from_file(const std::string& filepath, ShaderSources& outSources);
+    bool read_shader_source_from_file(const std::string& filepath, ShaderSources& outSources,
+                                      std::vector<std::string>* outKeywords);
+
+    // Compiles the stages and links them without asking for the result, which would make the driver finish
+    unsigned int submit_program(const ShaderSources& sources, bool retrievable,
+                                std::vector<std::pair<ShaderType, unsigned int>>& outStages);
+
+    // Ints set samplers too
+    bool is_uniform_type_compatible(uint32_t declared, uint32_t requested)
+    {
+        if (declared == requested)
+            return true;
+
+        if (requested != UniformType<int>::GL_TYPE)
+            return false;
+
+        switch (declared)
+        {
+        case gl::GL_BOOL:
+        case gl::GL_SAMPLER_2D:
+        case gl::GL_SAMPLER_2D_ARRAY:
+        case gl::GL_SAMPLER_CUBE:
+        case gl::GL_SAMPLER_BUFFER:
+        case gl::GL_INT_SAMPLER_BUFFER:
+        case gl::GL_UNSIGNED_INT_SAMPLER_BUFFER:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // The bytes a value of `type` takes in the shadow, 0 for the types it does not keep
+    uint32_t uniform_value_size(uint32_t type)
+    {
+        switch (type)
+        {
+        case gl::GL_BOOL:
+        case gl::GL_INT:
+        case gl::GL_UNSIGNED_INT:
+        case gl::GL_FLOAT:
+        case gl::GL_SAMPLER_2D:
+        case gl::GL_SAMPLER_2D_ARRAY:
+        case gl::GL_SAMPLER_CUBE:
+        case gl::GL_SAMPLER_BUFFER:
+        case gl::GL_INT_SAMPLER_BUFFER:
+        case gl::GL_UNSIGNED_INT_SAMPLER_BUFFER:
+            return 4;
+
+        case gl::GL_FLOAT_VEC2:     return 2 * 4;
+        case gl::GL_FLOAT_VEC3:     return 3 * 4;
+        case gl::GL_FLOAT_VEC4:     return 4 * 4;
+        case gl::GL_FLOAT_MAT3:     return 9 * 4;
+        case gl::GL_FLOAT_MAT4:     return 16 * 4;
+
+        default:
+            return 0;
+        }
+    }
 }
 
 namespace Tile
 {
-    Shader::Shader(const ShaderSources& sources, const std::string& debug_name) 
+    Shader::Shader(const ShaderSources& sources, const std::string& debug_name, const ProgramCache* cache,
+                   ShaderCompileMode mode) 
     : m_DebugName(debug_name)
     {
-        int programId = gl::glCreateProgram();
+        uint64_t cacheKey = 0;
+        if (cache)
+        {
+            cacheKey = cache->MakeKey(sources);
+            m_ProgramID = cache->Load(cacheKey);
+        }
 
-        std::vector<unsigned int> children;
+        // Also when the driver rejected the cached binary, which then gets replaced
+        if (m_ProgramID == 0)
+        {
+            m_ProgramID = submit_program(sources, cache != nullptr, m_PendingStages);
+            m_PendingCache = cache;
+            m_PendingCacheKey = cacheKey;
 
-        for(auto& it : sources)
+            if (mode == ShaderCompileMode::Blocking)
+                FinishCompile();
+        }
+        else
         {
-            uint openglType;
-            switch(it.first)
-                {
-                case ShaderType::Vertex: {
-                    openglType = gl::GL_VERTEX_SHADER;
-                    break;
-                }
+            ReflectUniforms();
+            m_Status = ShaderStatus::Ready;
+        }
+    }
 
-                case ShaderType::Fragment: {
-                    openglType = gl::GL_FRAGMENT_SHADER;
-                    break;
-                }
+    bool Shader::Poll()
+    {
+        if (m_Status == ShaderStatus::Pending)
+        {
+            if (GetGlExtensions().ParallelShaderCompile)
+            {
+                int completed = gl::GL_FALSE;
+                gl::glGetProgramiv(m_ProgramID, gl::GL_COMPLETION_STATUS_KHR, &completed);
+                if (completed == gl::GL_FALSE)
+                    return false;
             }
 
-            const char* sourceStr = it.second.c_str();
+            FinishCompile();
+        }
 
-            uint sid = gl::glCreateShader(openglType);
-            children.push_back(sid);
-            gl::glShaderSource(sid, 1, &sourceStr, NULL);
-            gl::glCompileShader(sid);
-            
-            int success;
-            gl::glGetShaderiv(sid, gl::GL_COMPILE_STATUS, &success);
+        return m_Status == ShaderStatus::Ready;
+    }
 
-            if(success)
-            {
-                gl::glAttachShader(programId, sid);
-            }
-            else
+    void Shader::Wait()
+    {
+        if (m_Status == ShaderStatus::Pending)
+            FinishCompile();
+    }
+
+    void Shader::FinishCompile()
+    {
+        int success;
+        gl::glGetProgramiv(m_ProgramID, gl::GL_LINK_STATUS, &success);
+
+        if(success == gl::GL_FALSE)
+        {
+            // Nothing was asked until now, so that the driver did not have to finish any stage early
+            for (const auto& [type, sid] : m_PendingStages)
             {
+                int compiled;
+                gl::glGetShaderiv(sid, gl::GL_COMPILE_STATUS, &compiled);
+                if (compiled)
+                    continue;
+
                 int len;
                 gl::glGetShaderiv(sid, gl::GL_INFO_LOG_LENGTH, &len);
                 char* infoLog = (char*)alloca(len * sizeof(char));
@@ -79,143 +170,335 @@ namespace Tile
 
                 std::cerr 
                     << "[ERROR] Shader compilation error ("
-                    << "name=\"" << debug_name << "\", "
-                    << "type="   << shader_type_string(it.first)
+                    << "name=\"" << m_DebugName << "\", "
+                    << "type="   << shader_type_string(type)
                     << "): " << infoLog;
             }
-        }
 
-        /* =================================================================== */
-        /* =================================================================== */
-        /* ========================== Linking Stage ========================== */
-        /* =================================================================== */
-        /* =================================================================== */
+            int len;
+            gl::glGetProgramiv(m_ProgramID, gl::GL_INFO_LOG_LENGTH, &len);
+            char* infoLog = (char*)alloca(len * sizeof(char));
 
-        gl::glLinkProgram(programId);
+            gl::glGetProgramInfoLog(m_ProgramID, len, NULL, infoLog);
+
+            std::cerr 
+                << "[ERROR] Shader link error ("
+                << "name=\"" << m_DebugName << "\", "
+                << "): " << infoLog;
+        }
 
-        for(int sid : children)
+        for (const auto& [type, sid] : m_PendingStages)
         {
+            gl::glDetachShader(m_ProgramID, sid);
             gl::glDeleteShader(sid);
         }
 
-        int success;
-        gl::glGetProgramiv(programId, gl::GL_LINK_STATUS, &success);
+        m_PendingStages.clear();
 
-        if(success == gl::GL_FALSE)
+        if (success == gl::GL_FALSE)
         {
-            int len;
-            gl::glGetProgramiv(programId, gl::GL_INFO_LOG_LENGTH, &len);
-            char* infoLog = (char*)alloca(len * sizeof(char));
+            gl::glDeleteProgram(m_ProgramID);
+            m_ProgramID = 0;
+            m_Status = ShaderStatus::Failed;
+        }
+        else
+        {
+            if (m_PendingCache)
+                m_PendingCache->Store(m_PendingCacheKey, m_ProgramID);
 
-            gl::glGetProgramInfoLog(programId, len, NULL, infoLog);
+            ReflectUniforms();
+            m_Status = ShaderStatus::Ready;
+        }
 
-            std::cerr 
-                << "[ERROR] Shader link error ("
-                << "name=\"" << debug_name << "\", "
-                << "): " << infoLog;
+        m_PendingCache = nullptr;
+    }
+
+    void Shader::ReflectUniforms()
+    {
+        int uniformCount = 0, maxNameLength = 0;
+        gl::glGetProgramiv(m_ProgramID, gl::GL_ACTIVE_UNIFORMS, &uniformCount);
+        gl::glGetProgramiv(m_ProgramID, gl::GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::vector<char> name(std::max(maxNameLength, 1));
+        m_Uniforms.clear();
+        m_UniformValues.clear();
+
+        for (int i = 0; i < uniformCount; i++)
+        {
+            gl::GLsizei length = 0;
+            gl::GLint size = 0;
+            gl::GLenum type;
+            gl::glGetActiveUniform(m_ProgramID, i, static_cast<gl::GLsizei>(name.size()), &length, &size, &type,
+                                   name.data());
+
+            // Members of uniform blocks have no location
+            int location = gl::glGetUniformLocation(m_ProgramID, name.data());
+            if (location < 0)
+                continue;
+
+            // Unknown until it is first set, it could have an initializer
+            uint32_t valueOffset = static_cast<uint32_t>(m_UniformValues.size());
+            uint32_t valueSize = uniform_value_size(type) * static_cast<uint32_t>(std::max(size, 1));
+            if (valueSize > 0)
+                m_UniformValues.resize(m_UniformValues.size() + 1 + valueSize, 0);
+
+            std::string_view uniformName(name.data(), length);
+            UniformInfo uniform { HashUniformName(uniformName), location, static_cast<uint32_t>(type), valueOffset,
+                                  valueSize };
+            m_Uniforms.push_back(uniform);
+
+            // Arrays are listed as "name[0]", they can be set by "name" as well
+            if (uniformName.size() > 3 && uniformName.substr(uniformName.size() - 3) == "[0]")
+            {
+                uniform.Hash = HashUniformName(uniformName.substr(0, uniformName.size() - 3));
+                m_Uniforms.push_back(uniform);
+            }
         }
-        else {
-            m_ProgramID = programId;
+
+        std::sort(m_Uniforms.begin(), m_Uniforms.end(),
+                  [](const UniformInfo& a, const UniformInfo& b) { return a.Hash < b.Hash; });
+
+        for (size_t i = 1; i < m_Uniforms.size(); i++)
+        {
+            if (m_Uniforms[i].Hash == m_Uniforms[i - 1].Hash)
+            {
+                std::cerr << "[ERROR] Two uniforms of Shader(name=" << m_DebugName << ") have the same hash"
+                          << std::endl;
+            }
         }
     }
 
     void Shader::Bind() const
     {
-        gl::glUseProgram(m_ProgramID);
+        GetGlState().UseProgram(m_ProgramID);
     }
 
     void Shader::Unbind() const
     {
-        gl::glUseProgram(0);
+        GetGlState().UseProgram(0);
     }
 
 
     void Shader::SetUniformIntArray(const std::string& name, int* values, uint32_t count)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniform1iv(location, count, values);
+        const UniformInfo* uniform = FindUniform(HashUniformName(name), name.c_str());
+        if (uniform && ShouldUpload(uniform->ValueOffset, uniform->ValueSize, values, count * sizeof(int)))
+            gl::glUniform1iv(uniform->Location, count, values);
     }
 
     void Shader::SetUniformFloatArray(const std::string& name, float* values, uint32_t count)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniform1fv(location, count, values);
+        const UniformInfo* uniform = FindUniform(HashUniformName(name), name.c_str());
+        if (uniform && ShouldUpload(uniform->ValueOffset, uniform->ValueSize, values, count * sizeof(float)))
+            gl::glUniform1fv(uniform->Location, count, values);
     }
 
     void Shader::SetUniformInt(const std::string& name, int value)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniform1i(location, value);
+        SetUniform(UniformName { HashUniformName(name), name.c_str() }, value);
     }
 
     void Shader::SetUniformFloat(const std::string& name, float value)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniform1f(location, value);
+        SetUniform(UniformName { HashUniformName(name), name.c_str() }, value);
     }
     
     void Shader::SetUniformFloat2(const std::string& name, const glm::vec2& value)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniform2f(location, value.x, value.y);
+        SetUniform(UniformName { HashUniformName(name), name.c_str() }, value);
     }
 
     void Shader::SetUniformFloat3(const std::string& name, const glm::vec3& value)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniform3f(location, value.x, value.y, value.z);
+        SetUniform(UniformName { HashUniformName(name), name.c_str() }, value);
     }
 
     void Shader::SetUniformFloat4(const std::string& name, const glm::vec4& value)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniform4f(location, value.x, value.y, value.z, value.w);
+        SetUniform(UniformName { HashUniformName(name), name.c_str() }, value);
     }
 
     void Shader::SetUniformMat3(const std::string& name, const glm::mat3& matrix)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniformMatrix3fv(location, 1, gl::GL_FALSE, glm::value_ptr(matrix));
+        SetUniform(UniformName { HashUniformName(name), name.c_str() }, matrix);
     }
 
     void Shader::SetUniformMat4(const std::string& name, const glm::mat4& matrix)
     {
-        int location = GetUniformLocation(name);
-        gl::glUniformMatrix4fv(location, 1, gl::GL_FALSE, glm::value_ptr(matrix));
+        SetUniform(UniformName { HashUniformName(name), name.c_str() }, matrix);
     }
 
-    int Shader::GetUniformLocation(const std::string& name) const 
+    const Shader::UniformInfo* Shader::FindUniform(uint64_t hash, const char* name) const
     {
-        if(m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
-        {
-            return m_UniformLocationCache[name];
-        }
+        auto it = std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), hash,
+                                   [](const UniformInfo& uniform, uint64_t h) { return uniform.Hash < h; });
+
+        if (it != m_Uniforms.end() && it->Hash == hash)
+            return &*it;
 
-        int location = gl::glGetUniformLocation(m_ProgramID, name.c_str());
-        if(location == -1)
+        if (std::find(m_MissingUniforms.begin(), m_MissingUniforms.end(), hash) == m_MissingUniforms.end())
         {
             std::cerr 
                 << "[ERROR] Uniform \"" << name << "\" not found for Shader("
                 << "name=" << m_DebugName << ")";
+
+            m_MissingUniforms.push_back(hash);
+        }
+
+        return nullptr;
+    }
+
+    const Shader::UniformInfo* Shader::ResolveUniform(UniformName name, uint32_t type) const
+    {
+        const UniformInfo* uniform = FindUniform(name.Hash, name.Text);
+        if (!uniform)
+            return nullptr;
+
+        if (!is_uniform_type_compatible(uniform->Type, type))
+        {
+            std::cerr << "[ERROR] Uniform \"" << name.Text << "\" of Shader(name=" << m_DebugName
+                      << ") is not of the type it is set as" << std::endl;
+            return nullptr;
+        }
+
+        return uniform;
+    }
+
+    bool Shader::ShouldUpload(uint32_t valueOffset, uint32_t valueSize, const void* value, size_t size)
+    {
+        GlStateCache& state = GetGlState();
+        if (valueSize == 0)
+        {
+            state.CountStateChange(StateChange::Uniform, true);
+            return true;
+        }
+
+        uint8_t* known = &m_UniformValues[valueOffset];
+        uint8_t* shadow = known + 1;
+
+        if (size != valueSize)
+        {
+            *known = 0;
+            state.CountStateChange(StateChange::Uniform, true);
+            return true;
+        }
+
+        if (state.IsFiltering() && *known && std::memcmp(shadow, value, size) == 0)
+        {
+            state.CountStateChange(StateChange::Uniform, false);
+            return false;
         }
 
-        m_UniformLocationCache[name] = location;
+        // Kept up to date when not filtering too, so that turning it back on is safe
+        std::memcpy(shadow, value, size);
+        *known = 1;
+
+        state.CountStateChange(StateChange::Uniform, true);
+        return true;
+    }
+
+    void Shader::UploadUniform(int location, int value)
+    {
+        gl::glUniform1i(location, value);
+    }
+
+    void Shader::UploadUniform(int location, float value)
+    {
+        gl::glUniform1f(location, value);
+    }
+
+    void Shader::UploadUniform(int location, const glm::vec2& value)
+    {
+        gl::glUniform2f(location, value.x, value.y);
+    }
+
+    void Shader::UploadUniform(int location, const glm::vec3& value)
+    {
+        gl::glUniform3f(location, value.x, value.y, value.z);
+    }
+
+    void Shader::UploadUniform(int location, const glm::vec4& value)
+    {
+        gl::glUniform4f(location, value.x, value.y, value.z, value.w);
+    }
+
+    void Shader::UploadUniform(int location, const glm::mat3& value)
+    {
+        gl::glUniformMatrix3fv(location, 1, gl::GL_FALSE, glm::value_ptr(value));
+    }
 
-        return location;
+    void Shader::UploadUniform(int location, const glm::mat4& value)
+    {
+        gl::glUniformMatrix4fv(location, 1, gl::GL_FALSE, glm::value_ptr(value));
     }
 
     std::shared_ptr<Shader> Shader::LoadFromFile(const std::string& filepath, 
-                                                 const std::string& debug_name)
+                                                 const std::string& debug_name,
+                                                 const ProgramCache* cache,
+                                                 ShaderCompileMode mode)
     {
         ShaderSources sources;
-        read_shader_source_from_file(filepath, sources);
-        return std::make_shared<Shader>(sources, debug_name);
+        read_shader_source_from_file(filepath, sources, nullptr);
+        return std::make_shared<Shader>(sources, debug_name, cache, mode);
+    }
+
+    bool Shader::ReadSourcesFromFile(const std::string& filepath, ShaderSources& outSources,
+                                     std::vector<std::string>* outKeywords)
+    {
+        return read_shader_source_from_file(filepath, outSources, outKeywords);
     }
     
 }
 
 namespace {
-    bool read_shader_source_from_file(const std::string& filepath, ShaderSources& outSources) 
+    unsigned int submit_program(const ShaderSources& sources, bool retrievable,
+                                std::vector<std::pair<ShaderType, unsigned int>>& outStages)
+    {
+        int programId = gl::glCreateProgram();
+
+        for(auto& it : sources)
+        {
+            uint openglType;
+            switch(it.first)
+                {
+                case ShaderType::Vertex: {
+                    openglType = gl::GL_VERTEX_SHADER;
+                    break;
+                }
+
+                case ShaderType::Fragment: {
+                    openglType = gl::GL_FRAGMENT_SHADER;
+                    break;
+                }
+            }
+
+            const char* sourceStr = it.second.c_str();
+
+            uint sid = gl::glCreateShader(openglType);
+            outStages.push_back({ it.first, sid });
+            gl::glShaderSource(sid, 1, &sourceStr, NULL);
+            gl::glCompileShader(sid);
+            gl::glAttachShader(programId, sid);
+        }
+
+        /* =================================================================== */
+        /* =================================================================== */
+        /* ========================== Linking Stage ========================== */
+        /* =================================================================== */
+        /* =================================================================== */
+
+        // Or glGetProgramBinary() might have nothing to return
+        if (retrievable)
+            gl::glProgramParameteri(programId, gl::GL_PROGRAM_BINARY_RETRIEVABLE_HINT, gl::GL_TRUE);
+
+        // A stage that did not compile fails the link, which is where that is found out
+        gl::glLinkProgram(programId);
+
+        return programId;
+    }
+
+    bool read_shader_source_from_file(const std::string& filepath, ShaderSources& outSources,
+                                      std::vector<std::string>* outKeywords) 
     {
         std::fstream fileStream(filepath);
 
@@ -239,6 +522,17 @@ namespace {
             // if(line.empty())
                 // continue;
 
+            // Not part of any segment's source, see ShaderVariants
+            if(line.rfind("#ShaderKeywords:", 0) == 0)
+            {
+                std::istringstream keywords(line.substr(std::strlen("#ShaderKeywords:")));
+                std::string keyword;
+                while(outKeywords && keywords >> keyword)
+                    outKeywords->push_back(keyword);
+
+                continue;
+            }
+
             if(line.rfind("#ShaderSegment:", 0) == 0)
             {
                 if(writing)
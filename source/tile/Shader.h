@@ -1,8 +1,12 @@
 #pragma once
 
+#include "tile/UniformName.h"
+
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -23,13 +27,44 @@ namespace Tile
 
     using ShaderSources = std::unordered_map< ShaderType, std::string>;
 
+    enum class ShaderCompileMode
+    {
+        // The constructor returns with the program linked (or failed)
+        Blocking,
+
+        // The constructor only hands the sources to the driver, Poll() finishes the program once the driver is
+        // done. Create all the shaders that are needed before polling any, so that they are compiled together
+        Async
+    };
+
+    enum class ShaderStatus
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    class ProgramCache;
+
     class Shader 
     {
     public:
-        Shader(const ShaderSources& sources, const std::string& debug_name);
+        // With a cache, the program is loaded from it when it is there and stored in it when it is not. An async
+        // compile stores it when it finishes, so the cache has to outlive it
+        Shader(const ShaderSources& sources, const std::string& debug_name, const ProgramCache* cache = nullptr,
+               ShaderCompileMode mode = ShaderCompileMode::Blocking);
 
         inline unsigned int GetID() const { return m_ProgramID; }
 
+        // Only a ready shader can be bound or have its uniforms set
+        inline ShaderStatus GetStatus() const { return m_Status; }
+        inline bool IsReady() const { return m_Status == ShaderStatus::Ready; }
+
+        // Finishes a pending program if the driver is done with it and returns whether the shader is ready. Does
+        // not wait with GL_KHR_parallel_shader_compile, without it this waits for the driver like Wait()
+        bool Poll();
+        void Wait();
+
         void Bind() const;
         void Unbind() const;
 
@@ -48,15 +83,97 @@ namespace Tile
         void SetUniformMat3(const std::string& name, const glm::mat3& value);
         void SetUniformMat4(const std::string& name, const glm::mat4& value);
 
+        // Resolves a uniform once, e.g `GetUniform<glm::mat4>("u_Dequantize"_uniform)`
+        template <typename T>
+        UniformHandle<T> GetUniform(UniformName name) const
+        {
+            const UniformInfo* uniform = ResolveUniform(name, UniformType<T>::GL_TYPE);
+            if (!uniform)
+                return {};
+
+            return { uniform->Location, uniform->ValueOffset, uniform->ValueSize };
+        }
+
+        template <typename T>
+        void SetUniform(UniformHandle<T> handle, const T& value)
+        {
+            if (handle.IsValid() && ShouldUpload(handle.ValueOffset, handle.ValueSize, &value, sizeof(T)))
+                UploadUniform(handle.Location, value);
+        }
+
+        // Looks the (already hashed) name up in the reflected uniforms, a binary search
+        template <typename T>
+        void SetUniform(UniformName name, const T& value)
+        {
+            const UniformInfo* uniform = FindUniform(name.Hash, name.Text);
+            if (uniform && ShouldUpload(uniform->ValueOffset, uniform->ValueSize, &value, sizeof(T)))
+                UploadUniform(uniform->Location, value);
+        }
+
         static std::shared_ptr<Shader> LoadFromFile(const std::string& filepath, 
-                                                    const std::string& debug_name);
+                                                    const std::string& debug_name,
+                                                    const ProgramCache* cache = nullptr,
+                                                    ShaderCompileMode mode = ShaderCompileMode::Blocking);
+
+        // The stages of a shader file, split at its "#ShaderSegment:" lines, and the keywords of its
+        // "#ShaderKeywords:" lines (see ShaderVariants). Loaded as a single shader, no keyword is defined
+        static bool ReadSourcesFromFile(const std::string& filepath, ShaderSources& outSources,
+                                        std::vector<std::string>* outKeywords = nullptr);
 
     private:
-        int GetUniformLocation(const std::string& name) const;
+        // Checks the link (and on failure the compile) status and cleans up. Waits for the driver if not done
+        void FinishCompile();
+
+        // What glGetActiveUniform() says about a uniform outside of the uniform blocks
+        struct UniformInfo
+        {
+            uint64_t Hash;
+            int Location;
+            uint32_t Type;
+
+            // The last value set, in m_UniformValues (both names of an array share it). Not kept if the size
+            // is 0, for types the cache does not know
+            uint32_t ValueOffset;
+            uint32_t ValueSize;
+        };
+
+        // Fills m_Uniforms (and makes room for their values) after linking
+        void ReflectUniforms();
+
+        // Null (and a message, once per name) if there is no such uniform
+        const UniformInfo* FindUniform(uint64_t hash, const char* name) const;
+        const UniformInfo* ResolveUniform(UniformName name, uint32_t type) const;
+
+        // Whether `value` differs from the uniform's last value and has to reach GL, updating the copy and
+        // the GL state stats. Values that do not cover the whole uniform (e.g part of an array) always do
+        bool ShouldUpload(uint32_t valueOffset, uint32_t valueSize, const void* value, size_t size);
+
+        static void UploadUniform(int location, int value);
+        static void UploadUniform(int location, float value);
+        static void UploadUniform(int location, const glm::vec2& value);
+        static void UploadUniform(int location, const glm::vec3& value);
+        static void UploadUniform(int location, const glm::vec4& value);
+        static void UploadUniform(int location, const glm::mat3& value);
+        static void UploadUniform(int location, const glm::mat4& value);
 
     private:
-        unsigned int m_ProgramID;
-        mutable std::unordered_map<std::string, int> m_UniformLocationCache;
+        unsigned int m_ProgramID = 0;
+        ShaderStatus m_Status = ShaderStatus::Pending;
+
+        // While pending: the stages, kept for their info logs, and where the program goes once linked
+        std::vector<std::pair<ShaderType, unsigned int>> m_PendingStages;
+        const ProgramCache* m_PendingCache = nullptr;
+        uint64_t m_PendingCacheKey = 0;
+
+        // Sorted by hash
+        std::vector<UniformInfo> m_Uniforms;
+
+        // The values of m_Uniforms, each a byte that says whether it is known followed by the value. GL keeps
+        // uniforms per program, so this stays right across binds as long as all the sets go through here
+        std::vector<uint8_t> m_UniformValues;
+
+        // The names that were asked for but are not there, so that each is only reported once
+        mutable std::vector<uint64_t> m_MissingUniforms;
 
         const std::string m_DebugName;
     };
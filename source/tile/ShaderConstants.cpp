@@ -0,0 +1,109 @@
+#include "tile/ShaderConstants.h"
+#include "tile/GlState.h"
+#include "tile/opengl_inc.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <glm/mat3x3.hpp>
+#include <glm/matrix.hpp>
+
+namespace
+{
+    size_t uniform_buffer_offset_alignment()
+    {
+        gl::GLint alignment = 0;
+        gl::glGetIntegerv(gl::GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+        // The spec's maximum
+        return alignment > 0 ? static_cast<size_t>(alignment) : 256;
+    }
+
+    size_t align_up(size_t size, size_t alignment)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // The frame's constants and `maxObjects` objects' at the alignment, plus the padding up to the first
+    // aligned offset of a region
+    size_t frame_size(size_t maxObjects, size_t alignment)
+    {
+        return align_up(sizeof(Tile::FrameConstants), alignment) +
+               maxObjects * align_up(sizeof(Tile::ObjectConstants), alignment) + alignment;
+    }
+}
+
+namespace Tile
+{
+    FrameConstants MakeFrameConstants(const glm::mat4& projectionView, const glm::vec3& cameraPosition,
+                                      float nearPlane, float farPlane, const glm::vec3& directionToLight)
+    {
+        FrameConstants frame {};
+        frame.ProjectionView = projectionView;
+        frame.InverseProjectionView = glm::inverse(projectionView);
+        frame.CameraPosition = glm::vec4(cameraPosition, 1.f);
+        frame.DirectionToLight = glm::vec4(directionToLight, 0.f);
+        frame.NearPlane = nearPlane;
+        frame.FarPlane = farPlane;
+        return frame;
+    }
+
+    ObjectConstants MakeObjectConstants(const glm::mat4& model, const glm::mat4& dequantize, const glm::vec3& color)
+    {
+        ObjectConstants object;
+        object.PositionTransform = model * dequantize;
+        object.NormalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+        object.Color = glm::vec4(color, 1.f);
+        return object;
+    }
+
+    ShaderConstants::ShaderConstants(size_t maxObjectsPerFrame, StreamBufferMode mode)
+    :   m_MaxObjectsPerFrame(maxObjectsPerFrame),
+        m_Alignment(uniform_buffer_offset_alignment()),
+        m_Buffer(frame_size(maxObjectsPerFrame, m_Alignment), 3, mode)
+    {
+    }
+
+    void ShaderConstants::BeginFrame(const FrameConstants& frame)
+    {
+        m_Buffer.BeginFrame();
+
+        StreamAllocation allocation = m_Buffer.Allocate(sizeof(FrameConstants), m_Alignment);
+        if (!allocation.IsValid())
+            return;
+
+        std::memcpy(allocation.Data, &frame, sizeof(FrameConstants));
+        m_Buffer.Flush();
+
+        GetGlState().BindBufferRange(gl::GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, m_Buffer.GetID(),
+                                     allocation.Offset, sizeof(FrameConstants));
+    }
+
+    bool ShaderConstants::SetObject(const ObjectConstants& object)
+    {
+        StreamAllocation allocation = m_Buffer.Allocate(sizeof(ObjectConstants), m_Alignment);
+        if (!allocation.IsValid())
+        {
+            if (!m_WarnedFull)
+            {
+                std::cerr << "[WARN] More than " << m_MaxObjectsPerFrame
+                          << " objects in a frame, the rest are drawn with the wrong constants" << std::endl;
+            }
+
+            m_WarnedFull = true;
+            return false;
+        }
+
+        std::memcpy(allocation.Data, &object, sizeof(ObjectConstants));
+        m_Buffer.Flush();
+
+        GetGlState().BindBufferRange(gl::GL_UNIFORM_BUFFER, OBJECT_CONSTANTS_BINDING, m_Buffer.GetID(),
+                                     allocation.Offset, sizeof(ObjectConstants));
+        return true;
+    }
+
+    void ShaderConstants::EndFrame()
+    {
+        m_Buffer.EndFrame();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "tile/StreamBuffer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace Tile
+{
+    // The uniform buffer binding points the shaders' blocks are declared at (`layout (std140, binding = ...)`)
+    constexpr uint32_t FRAME_CONSTANTS_BINDING = 0;
+    constexpr uint32_t OBJECT_CONSTANTS_BINDING = 1;
+
+    // The FrameConstants block, std140: only mat4, vec4 and scalars padded to a vec4
+    struct FrameConstants
+    {
+        glm::mat4 ProjectionView;
+        glm::mat4 InverseProjectionView;
+
+        // w unused
+        glm::vec4 CameraPosition;
+        glm::vec4 DirectionToLight;
+
+        float NearPlane;
+        float FarPlane;
+        float Padding[2];
+    };
+
+    // The ObjectConstants block, std140
+    struct ObjectConstants
+    {
+        // model * dequantize
+        glm::mat4 PositionTransform;
+
+        // The inverse transpose of the model matrix, only its upper 3x3 is used
+        glm::mat4 NormalMatrix;
+
+        glm::vec4 Color;
+    };
+
+    static_assert(sizeof(FrameConstants) == 11 * sizeof(glm::vec4), "Has to match the std140 layout");
+    static_assert(sizeof(ObjectConstants) == 9 * sizeof(glm::vec4), "Has to match the std140 layout");
+
+    FrameConstants MakeFrameConstants(const glm::mat4& projectionView, const glm::vec3& cameraPosition,
+                                      float nearPlane, float farPlane, const glm::vec3& directionToLight);
+
+    // Dequantizes the positions with `dequantize` (see Model::GetDequantizeTransform())
+    ObjectConstants MakeObjectConstants(const glm::mat4& model, const glm::mat4& dequantize, const glm::vec3& color);
+
+    // Feeds the shaders' FrameConstants and ObjectConstants uniform blocks from one StreamBuffer, instead of a
+    // glUniform call (and a location lookup by name) per value.
+    //
+    // The frame's constants are written once in BeginFrame() and bound to FRAME_CONSTANTS_BINDING for the
+    // whole frame. Every SetObject() writes another ObjectConstants into the ring and binds just that range to
+    // OBJECT_CONSTANTS_BINDING, so the draws of a frame never overwrite each other's constants and nothing
+    // waits for the GPU as long as the StreamBuffer has frames in flight
+    class ShaderConstants
+    {
+    public:
+        explicit ShaderConstants(size_t maxObjectsPerFrame = 16384,
+                                 StreamBufferMode mode = StreamBufferMode::PersistentMapped);
+
+        void BeginFrame(const FrameConstants& frame);
+
+        // False (and the previous object's constants stay bound) if the frame is out of room
+        bool SetObject(const ObjectConstants& object);
+
+        // Call after the frame's draws
+        void EndFrame();
+
+        inline size_t GetMaxObjectsPerFrame()               const { return m_MaxObjectsPerFrame;   }
+        inline const StreamBufferStats& GetStats()          const { return m_Buffer.GetStats();    }
+
+    private:
+        size_t m_MaxObjectsPerFrame;
+
+        // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+        size_t m_Alignment;
+
+        StreamBuffer m_Buffer;
+        bool m_WarnedFull = false;
+    };
+}
@@ -0,0 +1,99 @@
+#include "tile/ShaderVariants.h"
+
+#include <iostream>
+
+namespace
+{
+    using namespace Tile;
+
+    // After the #version line, which has to come first
+    std::string insert_defines(const std::string& source, const std::string& defines)
+    {
+        size_t version = source.find("#version");
+        if (version == std::string::npos)
+            return defines + source;
+
+        size_t versionEnd = source.find('\n', version);
+        if (versionEnd == std::string::npos)
+            return source + "\n" + defines;
+
+        return source.substr(0, versionEnd + 1) + defines + source.substr(versionEnd + 1);
+    }
+}
+
+namespace Tile
+{
+    ShaderVariants::ShaderVariants(const ShaderSources& sources, const std::vector<std::string>& keywords,
+                                   const std::string& debug_name, const ProgramCache* cache,
+                                   ShaderCompileMode mode)
+    :   m_Sources(sources),
+        m_Keywords(keywords),
+        m_Cache(cache),
+        m_Mode(mode),
+        m_DebugName(debug_name)
+    {
+        if (m_Keywords.size() > MAX_KEYWORDS)
+        {
+            std::cerr << "[WARN] Shader(name=" << m_DebugName << ") declares more than " << MAX_KEYWORDS
+                      << " keywords, the rest are ignored" << std::endl;
+            m_Keywords.resize(MAX_KEYWORDS);
+        }
+    }
+
+    ShaderKeywordMask ShaderVariants::GetKeywordMask(const std::string& keyword) const
+    {
+        for (size_t i = 0; i < m_Keywords.size(); i++)
+        {
+            if (m_Keywords[i] == keyword)
+                return ShaderKeywordMask(1) << i;
+        }
+
+        std::cerr << "[ERROR] Shader(name=" << m_DebugName << ") has no keyword \"" << keyword << "\""
+                  << std::endl;
+        return 0;
+    }
+
+    Shader& ShaderVariants::Get(ShaderKeywordMask keywords)
+    {
+        if (m_Keywords.size() < MAX_KEYWORDS)
+            keywords &= (ShaderKeywordMask(1) << m_Keywords.size()) - 1;
+
+        auto it = m_Variants.find(keywords);
+        if (it != m_Variants.end())
+            return *it->second;
+
+        std::string defines, variantName = m_DebugName;
+        for (size_t i = 0; i < m_Keywords.size(); i++)
+        {
+            if (keywords & (ShaderKeywordMask(1) << i))
+            {
+                defines += "#define " + m_Keywords[i] + "\n";
+                variantName += " " + m_Keywords[i];
+            }
+        }
+
+        ShaderSources sources;
+        for (const auto& [type, source] : m_Sources)
+            sources[type] = insert_defines(source, defines);
+
+        auto variant = std::make_unique<Shader>(sources, variantName, m_Cache, m_Mode);
+        return *m_Variants.emplace(keywords, std::move(variant)).first->second;
+    }
+
+    void ShaderVariants::Poll()
+    {
+        for (auto& [keywords, variant] : m_Variants)
+            variant->Poll();
+    }
+
+    std::shared_ptr<ShaderVariants> ShaderVariants::LoadFromFile(const std::string& filepath,
+                                                                 const std::string& debug_name,
+                                                                 const ProgramCache* cache,
+                                                                 ShaderCompileMode mode)
+    {
+        ShaderSources sources;
+        std::vector<std::string> keywords;
+        Shader::ReadSourcesFromFile(filepath, sources, &keywords);
+        return std::make_shared<ShaderVariants>(sources, keywords, debug_name, cache, mode);
+    }
+}
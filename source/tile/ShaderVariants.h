@@ -0,0 +1,62 @@
+#pragma once
+
+#include "tile/Shader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tile
+{
+    // One bit per keyword of a ShaderVariants, in the order the file declares them
+    using ShaderKeywordMask = uint32_t;
+
+    // The variants of one shader file, made by the feature keywords it declares with lines like
+    //     #ShaderKeywords: TEXTURED VERTEX_COLORS
+    // Every combination of keywords is a variant, compiled with a `#define <KEYWORD>` after the #version line of
+    // each stage for each keyword it has, so that the shader branches with #ifdef instead of on a uniform.
+    //
+    // A variant is only compiled the first time it is asked for, and then kept by its keyword mask. With a program
+    // cache every variant has an entry of its own, as their sources differ
+    class ShaderVariants
+    {
+    public:
+        static constexpr int MAX_KEYWORDS = 32;
+
+        // The cache has to outlive the variants (they are compiled later on)
+        ShaderVariants(const ShaderSources& sources, const std::vector<std::string>& keywords,
+                       const std::string& debug_name, const ProgramCache* cache = nullptr,
+                       ShaderCompileMode mode = ShaderCompileMode::Blocking);
+
+        // 0 (and a message) if there is no such keyword
+        ShaderKeywordMask GetKeywordMask(const std::string& keyword) const;
+
+        // Compiles the variant if it is the first time it is asked for, an async one is pending then. Bits of no
+        // keyword are ignored
+        Shader& Get(ShaderKeywordMask keywords);
+
+        // Polls every variant compiled so far (see Shader::Poll())
+        void Poll();
+
+        inline const std::vector<std::string>& GetKeywords() const { return m_Keywords; }
+        inline size_t GetVariantCount() const { return m_Variants.size(); }
+
+        static std::shared_ptr<ShaderVariants> LoadFromFile(const std::string& filepath,
+                                                            const std::string& debug_name,
+                                                            const ProgramCache* cache = nullptr,
+                                                            ShaderCompileMode mode = ShaderCompileMode::Blocking);
+
+    private:
+        ShaderSources m_Sources;
+        std::vector<std::string> m_Keywords;
+
+        std::unordered_map<ShaderKeywordMask, std::unique_ptr<Shader>> m_Variants;
+
+        const ProgramCache* m_Cache;
+        ShaderCompileMode m_Mode;
+
+        const std::string m_DebugName;
+    };
+}
@@ -0,0 +1,163 @@
+#include "tile/StreamBuffer.h"
+#include "tile/GlState.h"
+#include "tile/gl_extensions.h"
+#include "tile/opengl_inc.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    // A second, then the wait is given up on (which means something went very wrong with the GPU)
+    constexpr uint64_t FENCE_TIMEOUT_NS = 1000000000ull;
+}
+
+namespace Tile
+{
+    StreamBuffer::StreamBuffer(size_t frameSize, uint32_t framesInFlight, StreamBufferMode mode)
+    :   m_Mode(mode),
+        m_FrameSize(frameSize),
+        m_RegionCount(1)
+    {
+        if (m_Mode == StreamBufferMode::PersistentMapped && !GetGlExtensions().BufferStorage)
+        {
+            std::cout << "[WARN] No glBufferStorage, the stream buffer is orphaned instead of persistently mapped"
+                      << std::endl;
+            m_Mode = StreamBufferMode::Orphaning;
+        }
+
+        gl::glGenBuffers(1, &m_BufferID);
+        GetGlState().BindBuffer(gl::GL_COPY_WRITE_BUFFER, m_BufferID);
+
+        if (m_Mode == StreamBufferMode::PersistentMapped)
+        {
+            m_RegionCount = framesInFlight > 0 ? framesInFlight : 1;
+            size_t size = m_FrameSize * m_RegionCount;
+
+            gl::GLbitfield flags = gl::GL_MAP_WRITE_BIT | gl::GL_MAP_PERSISTENT_BIT | gl::GL_MAP_COHERENT_BIT;
+            GetGlExtensions().glBufferStorage(gl::GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+            m_Mapping = static_cast<uint8_t*>(gl::glMapBufferRange(gl::GL_COPY_WRITE_BUFFER, 0, size, flags));
+
+            if (m_Mapping == nullptr)
+                std::cerr << "[ERROR] Could not map the stream buffer" << std::endl;
+        }
+        else
+        {
+            gl::glBufferData(gl::GL_COPY_WRITE_BUFFER, m_FrameSize, nullptr, gl::GL_STREAM_DRAW);
+            m_Staging.resize(m_FrameSize);
+        }
+
+        m_Fences.resize(m_RegionCount, nullptr);
+
+        // So that the first BeginFrame() lands on region 0
+        m_Region = m_RegionCount - 1;
+    }
+
+    StreamBuffer::~StreamBuffer()
+    {
+        for (void* fence : m_Fences)
+        {
+            if (fence != nullptr)
+                gl::glDeleteSync(static_cast<gl::GLsync>(fence));
+        }
+
+        if (m_Mapping != nullptr)
+        {
+            GetGlState().BindBuffer(gl::GL_COPY_WRITE_BUFFER, m_BufferID);
+            gl::glUnmapBuffer(gl::GL_COPY_WRITE_BUFFER);
+        }
+
+        GetGlState().OnBufferDeleted(m_BufferID);
+        gl::glDeleteBuffers(1, &m_BufferID);
+    }
+
+    void StreamBuffer::BeginFrame()
+    {
+        m_Region = (m_Region + 1) % m_RegionCount;
+        m_Head = 0;
+        m_FlushedHead = 0;
+        m_Stats.Frames++;
+
+        WaitForRegion(m_Region);
+    }
+
+    StreamAllocation StreamBuffer::Allocate(size_t size, size_t alignment)
+    {
+        m_Stats.Allocations++;
+
+        // Aligned in the whole buffer, not just within the region
+        size_t regionStart = m_Mode == StreamBufferMode::PersistentMapped ? m_Region * m_FrameSize : 0;
+        size_t offset = regionStart + m_Head;
+        if (alignment > 1)
+            offset = (offset + alignment - 1) / alignment * alignment;
+
+        if (offset + size > regionStart + m_FrameSize)
+        {
+            m_Stats.FailedAllocations++;
+            return StreamAllocation();
+        }
+
+        m_Head = offset + size - regionStart;
+
+        uint8_t* data = m_Mapping != nullptr ? m_Mapping + offset : m_Staging.data() + offset;
+        return { data, offset, size };
+    }
+
+    void StreamBuffer::Flush()
+    {
+        if (m_Mode == StreamBufferMode::PersistentMapped || m_FlushedHead == m_Head)
+            return;
+
+        // Left bound, the state cache skips rebinding it for the next flush
+        GetGlState().BindBuffer(gl::GL_COPY_WRITE_BUFFER, m_BufferID);
+
+        // Only the first flush of a frame can orphan, later ones must keep what was uploaded before them
+        if (m_Mode == StreamBufferMode::Orphaning && m_FlushedHead == 0)
+            gl::glBufferData(gl::GL_COPY_WRITE_BUFFER, m_FrameSize, nullptr, gl::GL_STREAM_DRAW);
+
+        gl::glBufferSubData(gl::GL_COPY_WRITE_BUFFER, m_FlushedHead, m_Head - m_FlushedHead,
+                            m_Staging.data() + m_FlushedHead);
+
+        m_FlushedHead = m_Head;
+    }
+
+    void StreamBuffer::EndFrame()
+    {
+        Flush();
+
+        // The driver takes care of the other modes
+        if (m_Mode != StreamBufferMode::PersistentMapped)
+            return;
+
+        if (m_Fences[m_Region] != nullptr)
+            gl::glDeleteSync(static_cast<gl::GLsync>(m_Fences[m_Region]));
+
+        m_Fences[m_Region] = gl::glFenceSync(gl::GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void StreamBuffer::WaitForRegion(uint32_t region)
+    {
+        auto fence = static_cast<gl::GLsync>(m_Fences[region]);
+        if (fence == nullptr)
+            return;
+
+        // Checking without waiting first, so that only actual stalls are counted
+        gl::GLenum result = gl::glClientWaitSync(fence, gl::GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        if (result == gl::GL_TIMEOUT_EXPIRED)
+        {
+            auto start = std::chrono::steady_clock::now();
+            result = gl::glClientWaitSync(fence, gl::GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+            auto end = std::chrono::steady_clock::now();
+
+            m_Stats.FenceWaits++;
+            m_Stats.FenceWaitMs += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        if (result == gl::GL_WAIT_FAILED || result == gl::GL_TIMEOUT_EXPIRED)
+            std::cerr << "[ERROR] Waiting for the GPU to release a stream buffer region failed" << std::endl;
+
+        gl::glDeleteSync(fence);
+        m_Fences[region] = nullptr;
+    }
+}
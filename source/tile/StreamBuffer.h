@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tile
+{
+    // How a StreamBuffer gets the CPU's writes to the GPU
+    enum class StreamBufferMode
+    {
+        // glBufferStorage with a persistent, coherent mapping that is written to directly. The buffer is split
+        // into one region per frame in flight and a region is only reused once the GPU is done with it (fences)
+        PersistentMapped,
+
+        // The writes go to CPU memory first. Flush() respecifies the buffer with glBufferData(nullptr), so that
+        // the driver can hand out fresh storage instead of waiting for draws still reading the old one, and
+        // uploads them with glBufferSubData
+        Orphaning,
+
+        // Like Orphaning without respecifying the buffer, the driver syncs (or copies) as it sees fit
+        SubData
+    };
+
+    // Where an allocation went: the CPU side memory to write to and the byte offset the data will be at in
+    // the buffer (e.g for glVertexAttribPointer, glBindBufferRange or indirect draws)
+    struct StreamAllocation
+    {
+        void* Data = nullptr;
+        size_t Offset = 0;
+        size_t Size = 0;
+
+        inline bool IsValid() const { return Data != nullptr; }
+    };
+
+    struct StreamBufferStats
+    {
+        uint64_t Frames = 0;
+        uint64_t Allocations = 0;
+
+        // Allocations that did not fit in what was left of the frame's region
+        uint64_t FailedAllocations = 0;
+
+        // BeginFrame() calls that found the GPU still using the region, and how long they waited for it in total
+        uint64_t FenceWaits = 0;
+        double FenceWaitMs = 0.0;
+    };
+
+    // A buffer for data that is written anew every frame (transforms, debug lines, UI geometry, ...).
+    //
+    // Every frame goes BeginFrame(), Allocate() and write as many times as needed, Flush() before the draws
+    // reading the data, EndFrame() after them. Offsets are only valid for the frame they were allocated in.
+    //
+    // PersistentMapped needs GL_ARB_buffer_storage, the buffer falls back to Orphaning without it
+    class StreamBuffer
+    {
+    public:
+        // `frameSize` bytes can be allocated per frame, `framesInFlight` frames are kept apart in
+        // PersistentMapped mode (3 for triple buffering)
+        StreamBuffer(size_t frameSize, uint32_t framesInFlight = 3,
+                     StreamBufferMode mode = StreamBufferMode::PersistentMapped);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        // Moves on to the next region, waiting for the GPU to be done with it if it has to
+        void BeginFrame();
+
+        // `size` bytes at an offset that is a multiple of `alignment` (which does not have to be a power of two,
+        // e.g a vertex stride). Invalid if the frame's region has no room left
+        StreamAllocation Allocate(size_t size, size_t alignment = 16);
+
+        // Makes the frame's writes so far visible to the GPU. A no-op when persistently mapped (the mapping is
+        // coherent), an upload otherwise
+        void Flush();
+
+        // Fences the frame's region, call after submitting the draws that read it
+        void EndFrame();
+
+        inline unsigned int GetID()             const { return m_BufferID;  }
+        inline StreamBufferMode GetMode()       const { return m_Mode;      }
+        inline size_t GetFrameSize()            const { return m_FrameSize; }
+        inline const StreamBufferStats& GetStats() const { return m_Stats; }
+
+        inline void ResetStats() { m_Stats = StreamBufferStats(); }
+
+    private:
+        void WaitForRegion(uint32_t region);
+
+    private:
+        StreamBufferMode m_Mode;
+
+        unsigned int m_BufferID = 0;
+        size_t m_FrameSize;
+        uint32_t m_RegionCount;
+
+        // Persistent mapping of all the regions, null in the other modes
+        uint8_t* m_Mapping = nullptr;
+
+        // Where the writes go in the other modes, a single region that is uploaded by Flush()
+        std::vector<uint8_t> m_Staging;
+
+        // One fence per region, null when the region is free
+        std::vector<void*> m_Fences;
+
+        uint32_t m_Region = 0;
+
+        // Of the current region
+        size_t m_Head = 0;
+        size_t m_FlushedHead = 0;
+
+        StreamBufferStats m_Stats;
+    };
+}
@@ -1,4 +1,6 @@
 #include "tile/Texture.h"
+#include "tile/gl_extensions.h"
+#include "tile/GlState.h"
 #include "tile/opengl_inc.h"
 
 #include <iostream>
@@ -11,9 +13,6 @@ namespace Tile {
     :   m_Width(width),
         m_Height(height)
     {
-        gl::glGenTextures(1, &m_TexId);
-        Bind(0);
-
         gl::GLenum gl_internal_format;
 
         switch (format) {
@@ -25,12 +24,31 @@ namespace Tile {
 
         // gl_internal_format = gl::GL_RGB8;
 
-        gl::glTexStorage2D(gl::GL_TEXTURE_2D, levelCount, gl_internal_format, width, height);
+        const GlExtensions& extensions = GetGlExtensions();
 
-        gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_MIN_FILTER, gl::GL_LINEAR);
-        gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_MAG_FILTER, gl::GL_NEAREST);
-        gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_WRAP_S, gl::GL_REPEAT);
-        gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_WRAP_T, gl::GL_REPEAT);
+        if (extensions.DirectStateAccess)
+        {
+            // Nothing gets bound, so whatever is bound to texture unit 0 stays
+            extensions.glCreateTextures(gl::GL_TEXTURE_2D, 1, &m_TexId);
+            extensions.glTextureStorage2D(m_TexId, levelCount, gl_internal_format, width, height);
+
+            extensions.glTextureParameteri(m_TexId, gl::GL_TEXTURE_MIN_FILTER, gl::GL_LINEAR);
+            extensions.glTextureParameteri(m_TexId, gl::GL_TEXTURE_MAG_FILTER, gl::GL_NEAREST);
+            extensions.glTextureParameteri(m_TexId, gl::GL_TEXTURE_WRAP_S, gl::GL_REPEAT);
+            extensions.glTextureParameteri(m_TexId, gl::GL_TEXTURE_WRAP_T, gl::GL_REPEAT);
+        }
+        else
+        {
+            gl::glGenTextures(1, &m_TexId);
+            Bind(0);
+
+            gl::glTexStorage2D(gl::GL_TEXTURE_2D, levelCount, gl_internal_format, width, height);
+
+            gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_MIN_FILTER, gl::GL_LINEAR);
+            gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_MAG_FILTER, gl::GL_NEAREST);
+            gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_WRAP_S, gl::GL_REPEAT);
+            gl::glTexParameteri(gl::GL_TEXTURE_2D, gl::GL_TEXTURE_WRAP_T, gl::GL_REPEAT);
+        }
 
 
         switch (format) {
@@ -43,22 +61,31 @@ namespace Tile {
 
     Texture2D::~Texture2D()
     {
+        GetGlState().OnTextureDeleted(m_TexId);
         gl::glDeleteTextures(1, &m_TexId);
     }
 
     void Texture2D::Bind(int slot) const
     {
-        gl::glActiveTexture(gl::GL_TEXTURE0 + slot);
-        gl::glBindTexture(gl::GL_TEXTURE_2D, m_TexId);
+        GetGlState().BindTexture(slot, gl::GL_TEXTURE_2D, m_TexId);
     }
 
     void Texture2D::Unbind() const
     {
-        gl::glBindTexture(gl::GL_TEXTURE_2D, 0);
+        GlStateCache& state = GetGlState();
+        state.BindTexture(state.GetActiveTexture(), gl::GL_TEXTURE_2D, 0);
     }
 
     void Texture2D::SetData(int level, int x, int y, int width, int height, const void *data)
     {
+        const GlExtensions& extensions = GetGlExtensions();
+        if (extensions.DirectStateAccess)
+        {
+            extensions.glTextureSubImage2D(m_TexId, level, x, y, width, height, m_FormatComponents, m_FormatTypes,
+                                           data);
+            return;
+        }
+
         Bind(0);
         gl::glTexSubImage2D(
             gl::GL_TEXTURE_2D, 
@@ -0,0 +1,97 @@
+#include "tile/ThreadPool.h"
+
+namespace Tile
+{
+    ThreadPool::ThreadPool(unsigned int workerCount)
+    {
+        if (workerCount == 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+
+        m_Workers.reserve(workerCount);
+        for (unsigned int i = 0; i < workerCount; i++)
+            m_Workers.emplace_back([this]() { WorkerLoop(); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_WakeCondition.notify_all();
+
+        for (auto& worker : m_Workers)
+            worker.join();
+    }
+
+    void ThreadPool::ParallelFor(size_t taskCount, const std::function<void(size_t)>& task)
+    {
+        if (taskCount == 0)
+            return;
+
+        // Not worth waking anyone up for
+        if (taskCount == 1 || m_Workers.empty())
+        {
+            for (size_t i = 0; i < taskCount; i++)
+                task(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Task = &task;
+            m_TaskCount = taskCount;
+            m_NextTask.store(0);
+            m_BusyWorkers = m_Workers.size();
+            m_Generation++;
+        }
+        m_WakeCondition.notify_all();
+
+        RunTasks();
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_DoneCondition.wait(lock, [this]() { return m_BusyWorkers == 0; });
+        m_Task = nullptr;
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        uint64_t seenGeneration = 0;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_WakeCondition.wait(lock, [&]() { return m_Stopping || m_Generation != seenGeneration; });
+
+                if (m_Stopping)
+                    return;
+
+                seenGeneration = m_Generation;
+            }
+
+            RunTasks();
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_BusyWorkers--;
+            }
+            m_DoneCondition.notify_one();
+        }
+    }
+
+    void ThreadPool::RunTasks()
+    {
+        while (true)
+        {
+            size_t taskIndex = m_NextTask.fetch_add(1);
+            if (taskIndex >= m_TaskCount)
+                break;
+
+            (*m_Task)(taskIndex);
+        }
+    }
+}
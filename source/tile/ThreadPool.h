@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tile
+{
+    // A fixed set of worker threads that run "parallel for" style jobs.
+    //
+    // The thread calling ParallelFor() also takes part in the work, so a pool with N workers
+    // runs jobs on N + 1 threads. Only one job can be in flight at a time and ParallelFor() must not be
+    // called from inside a task.
+    class ThreadPool
+    {
+    public:
+        // A worker count of 0 picks one worker per hardware thread (minus the calling thread)
+        explicit ThreadPool(unsigned int workerCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        // Number of threads a job is spread over, including the calling thread
+        inline unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_Workers.size()) + 1; }
+
+        // Calls task(i) for every i in [0, taskCount) and blocks until all of them have returned.
+        // Tasks are handed out in increasing order but may finish in any order.
+        void ParallelFor(size_t taskCount, const std::function<void(size_t)>& task);
+
+    private:
+        void WorkerLoop();
+        void RunTasks();
+
+    private:
+        std::vector<std::thread> m_Workers;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_WakeCondition;
+        std::condition_variable m_DoneCondition;
+
+        const std::function<void(size_t)>* m_Task = nullptr;
+        size_t m_TaskCount = 0;
+        std::atomic<size_t> m_NextTask { 0 };
+
+        // Incremented for every job so that sleeping workers can tell a new job apart from a spurious wakeup
+        uint64_t m_Generation = 0;
+        size_t m_BusyWorkers = 0;
+        bool m_Stopping = false;
+    };
+}
@@ -0,0 +1,388 @@
+#include "tile/Triangulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Twice the signed area of the triangle (a, b, c). Positive if it winds counter clockwise
+    template <typename P>
+    inline double cross(const P& a, const P& b, const P& c)
+    {
+        return (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+    }
+
+    // Inclusive of the triangle's edges. (a, b, c) must wind counter clockwise
+    template <typename P>
+    inline bool is_in_triangle(const P& p, const P& a, const P& b, const P& c)
+    {
+        return cross(a, b, p) >= 0.0 && cross(b, c, p) >= 0.0 && cross(c, a, p) >= 0.0;
+    }
+
+    // Interleaves the low 16 bits of `value` with zeros
+    inline uint32_t spread_bits(uint32_t value)
+    {
+        value = (value | (value << 8)) & 0x00FF00FFu;
+        value = (value | (value << 4)) & 0x0F0F0F0Fu;
+        value = (value | (value << 2)) & 0x33333333u;
+        value = (value | (value << 1)) & 0x55555555u;
+        return value;
+    }
+
+    // Inverse of spread_bits()
+    inline uint32_t compact_bits(uint32_t value)
+    {
+        value &= 0x55555555u;
+        value = (value | (value >> 1)) & 0x33333333u;
+        value = (value | (value >> 2)) & 0x0F0F0F0Fu;
+        value = (value | (value >> 4)) & 0x00FF00FFu;
+        value = (value | (value >> 8)) & 0x0000FFFFu;
+        return value;
+    }
+
+    inline uint32_t z_order(uint32_t x, uint32_t y)
+    {
+        return spread_bits(x) | (spread_bits(y) << 1);
+    }
+
+    // The smallest Z-order index greater than `z` that lies in the box with the corner indices `minZ` and
+    // `maxZ`, where `z` is between the two but outside the box. Tropf and Herzog's BIGMIN
+    uint32_t next_z_in_box(uint32_t z, uint32_t minZ, uint32_t maxZ)
+    {
+        uint32_t bigMin = 0;
+
+        for (int bit = 31; bit >= 0; bit--)
+        {
+            uint32_t mask = 1u << bit;
+
+            // The bits of the same coordinate as `bit`, from `bit` down
+            uint32_t lower = (bit % 2 == 0 ? 0x55555555u : 0xAAAAAAAAu) & static_cast<uint32_t>((2ull << bit) - 1);
+
+            // That coordinate of `value` set to 1000... or 0111... from `bit` down
+            auto with_min = [&](uint32_t value) { return (value & ~lower) | mask; };
+            auto with_max = [&](uint32_t value) { return (value & ~lower) | (lower & ~mask); };
+
+            bool zBit = z & mask, minBit = minZ & mask, maxBit = maxZ & mask;
+
+            if (!zBit && !minBit && maxBit)
+            {
+                bigMin = with_min(minZ);
+                maxZ = with_max(maxZ);
+            }
+            else if (!zBit && minBit && maxBit)
+            {
+                return minZ;
+            }
+            else if (zBit && !minBit && !maxBit)
+            {
+                return bigMin;
+            }
+            else if (zBit && !minBit && maxBit)
+            {
+                minZ = with_min(minZ);
+            }
+        }
+
+        return bigMin;
+    }
+
+    constexpr double Z_ORDER_RESOLUTION = 65535.0;
+}
+
+namespace Tile
+{
+    void Triangulator::Triangulate(const glm::vec3* positions, size_t count, std::vector<uint32_t>& triangles)
+    {
+        if (count < 3)
+            return;
+
+        if (count == 3)
+        {
+            triangles.insert(triangles.end(), { 0, 1, 2 });
+            return;
+        }
+
+        Project(positions, count);
+
+        if (CanFan(count))
+        {
+            for (uint32_t i = 1; i + 1 < count; i++)
+                triangles.insert(triangles.end(), { 0, i, i + 1 });
+            return;
+        }
+
+        EarClip(count, triangles);
+    }
+
+    void Triangulator::Project(const glm::vec3* positions, size_t count)
+    {
+        // Newell's method. The normal points towards the side the polygon winds counter clockwise around
+        double normal[3] = { 0.0, 0.0, 0.0 };
+        for (size_t i = 0, j = count - 1; i < count; j = i++)
+        {
+            const glm::vec3& a = positions[j];
+            const glm::vec3& b = positions[i];
+
+            normal[0] += (static_cast<double>(a.y) - b.y) * (static_cast<double>(a.z) + b.z);
+            normal[1] += (static_cast<double>(a.z) - b.z) * (static_cast<double>(a.x) + b.x);
+            normal[2] += (static_cast<double>(a.x) - b.x) * (static_cast<double>(a.y) + b.y);
+        }
+
+        // Drop the dominant axis. The remaining two are taken in cyclic order (y z, z x or x y), which keeps
+        // the polygon counter clockwise if the normal points along the positive dominant axis
+        int axis = 2;
+        if (std::abs(normal[0]) > std::abs(normal[1]) && std::abs(normal[0]) > std::abs(normal[2]))
+            axis = 0;
+        else if (std::abs(normal[1]) > std::abs(normal[2]))
+            axis = 1;
+
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+        double flip = normal[axis] < 0.0 ? -1.0 : 1.0;
+
+        m_Points.resize(count);
+        for (size_t i = 0; i < count; i++)
+            m_Points[i] = { static_cast<double>(positions[i][u]), flip * positions[i][v] };
+    }
+
+    bool Triangulator::CanFan(size_t count) const
+    {
+        // The fan is valid if the first corner is convex and the directions from it to the other corners turn
+        // counter clockwise monotonically. Then every fan triangle winds the right way and they do not overlap
+        if (cross(m_Points[count - 1], m_Points[0], m_Points[1]) < 0.0)
+            return false;
+
+        for (size_t i = 1; i + 1 < count; i++)
+        {
+            if (cross(m_Points[0], m_Points[i], m_Points[i + 1]) < 0.0)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool Triangulator::IsReflex(uint32_t corner) const
+    {
+        // Collinear corners count as reflex too. They can lie on the edge of a candidate ear
+        return cross(m_Points[m_Prev[corner]], m_Points[corner], m_Points[m_Next[corner]]) <= 0.0;
+    }
+
+    uint32_t Triangulator::QuantizeX(double x) const
+    {
+        return static_cast<uint32_t>(std::clamp((x - m_MinX) * m_InvSize, 0.0, Z_ORDER_RESOLUTION));
+    }
+
+    uint32_t Triangulator::QuantizeY(double y) const
+    {
+        return static_cast<uint32_t>(std::clamp((y - m_MinY) * m_InvSize, 0.0, Z_ORDER_RESOLUTION));
+    }
+
+    void Triangulator::BuildZOrder(size_t count)
+    {
+        double maxX = m_Points[0].X, maxY = m_Points[0].Y;
+        m_MinX = m_Points[0].X;
+        m_MinY = m_Points[0].Y;
+
+        for (size_t i = 1; i < count; i++)
+        {
+            m_MinX = std::min(m_MinX, m_Points[i].X);
+            m_MinY = std::min(m_MinY, m_Points[i].Y);
+            maxX = std::max(maxX, m_Points[i].X);
+            maxY = std::max(maxY, m_Points[i].Y);
+        }
+
+        double size = std::max(maxX - m_MinX, maxY - m_MinY);
+        m_InvSize = size > 0.0 ? Z_ORDER_RESOLUTION / size : 0.0;
+
+        // Sorted as 64 bit keys, with the Z-order index on top of the corner
+        m_SortKeys.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t z = z_order(QuantizeX(m_Points[i].X), QuantizeY(m_Points[i].Y));
+            m_SortKeys[i] = static_cast<uint64_t>(z) << 32 | i;
+        }
+
+        std::sort(m_SortKeys.begin(), m_SortKeys.end());
+
+        m_SortedZ.resize(count);
+        m_SortedCorners.resize(count);
+        m_Rank.resize(count);
+        m_NextLive.resize(count + 1);
+
+        for (uint32_t rank = 0; rank < count; rank++)
+        {
+            uint32_t corner = static_cast<uint32_t>(m_SortKeys[rank]);
+
+            m_SortedZ[rank] = static_cast<uint32_t>(m_SortKeys[rank] >> 32);
+            m_SortedCorners[rank] = corner;
+            m_Rank[corner] = rank;
+            m_NextLive[rank] = m_Reflex[corner] ? rank : rank + 1;
+        }
+
+        m_NextLive[count] = static_cast<uint32_t>(count);
+    }
+
+    uint32_t Triangulator::FindLive(uint32_t rank)
+    {
+        // Path halving, so skipping over long runs of removed corners stays cheap
+        while (m_NextLive[rank] != rank)
+        {
+            m_NextLive[rank] = m_NextLive[m_NextLive[rank]];
+            rank = m_NextLive[rank];
+        }
+
+        return rank;
+    }
+
+    void Triangulator::RemoveReflex(uint32_t corner)
+    {
+        m_Reflex[corner] = false;
+        m_NextLive[m_Rank[corner]] = m_Rank[corner] + 1;
+    }
+
+    bool Triangulator::IsEar(uint32_t prev, uint32_t ear, uint32_t next)
+    {
+        const Point& a = m_Points[prev];
+        const Point& b = m_Points[ear];
+        const Point& c = m_Points[next];
+
+        double minX = std::min({ a.X, b.X, c.X }), maxX = std::max({ a.X, b.X, c.X });
+        double minY = std::min({ a.Y, b.Y, c.Y }), maxY = std::max({ a.Y, b.Y, c.Y });
+
+        // Every point in the bounding box has a Z-order index between the ones of the box's corners, but most
+        // of the indices in that range are usually outside the box. Those are skipped with next_z_in_box()
+        uint32_t boxMinX = QuantizeX(minX), boxMaxX = QuantizeX(maxX);
+        uint32_t boxMinY = QuantizeY(minY), boxMaxY = QuantizeY(maxY);
+
+        uint32_t minZ = z_order(boxMinX, boxMinY);
+        uint32_t maxZ = z_order(boxMaxX, boxMaxY);
+
+        auto first_live_from = [this](uint32_t z, size_t fromRank) {
+            auto it = std::lower_bound(m_SortedZ.begin() + fromRank, m_SortedZ.end(), z);
+            return FindLive(static_cast<uint32_t>(it - m_SortedZ.begin()));
+        };
+
+        size_t count = m_SortedZ.size();
+        uint32_t rank = first_live_from(minZ, 0);
+
+        while (rank < count && m_SortedZ[rank] <= maxZ)
+        {
+            uint32_t z = m_SortedZ[rank];
+            uint32_t x = compact_bits(z), y = compact_bits(z >> 1);
+
+            if (x < boxMinX || x > boxMaxX || y < boxMinY || y > boxMaxY)
+            {
+                rank = first_live_from(next_z_in_box(z, minZ, maxZ), rank + 1);
+                continue;
+            }
+
+            uint32_t corner = m_SortedCorners[rank];
+            if (corner != prev && corner != next)
+            {
+                const Point& p = m_Points[corner];
+                if (p.X >= minX && p.X <= maxX && p.Y >= minY && p.Y <= maxY && is_in_triangle(p, a, b, c))
+                    return false;
+            }
+
+            rank = FindLive(rank + 1);
+        }
+
+        return true;
+    }
+
+    void Triangulator::EarClip(size_t count, std::vector<uint32_t>& triangles)
+    {
+        m_Prev.resize(count);
+        m_Next.resize(count);
+        m_Reflex.resize(count);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            m_Prev[i] = i == 0 ? static_cast<uint32_t>(count - 1) : i - 1;
+            m_Next[i] = i + 1 == count ? 0 : i + 1;
+        }
+
+        size_t reflexCount = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            m_Reflex[i] = IsReflex(i);
+            reflexCount += m_Reflex[i];
+        }
+
+        BuildZOrder(count);
+
+        auto clip = [&](uint32_t ear) {
+            uint32_t prev = m_Prev[ear];
+            uint32_t next = m_Next[ear];
+            triangles.insert(triangles.end(), { prev, ear, next });
+
+            m_Next[prev] = next;
+            m_Prev[next] = prev;
+
+            // The ear itself is only reflex when it is collinear, or the fallback below clips it
+            if (m_Reflex[ear])
+            {
+                RemoveReflex(ear);
+                reflexCount--;
+            }
+
+            // Clipping an ear can only turn its neighbours from reflex to convex, never the other way around
+            for (uint32_t neighbour : { prev, next })
+            {
+                if (m_Reflex[neighbour] && !IsReflex(neighbour))
+                {
+                    RemoveReflex(neighbour);
+                    reflexCount--;
+                }
+            }
+
+            return next;
+        };
+
+        size_t remaining = count;
+        uint32_t corner = 0;
+        size_t stepsWithoutEar = 0;
+
+        while (remaining > 3)
+        {
+            double turn = cross(m_Points[m_Prev[corner]], m_Points[corner], m_Points[m_Next[corner]]);
+
+            // Collinear corners are clipped right away, as zero area triangles, which leaves the shape of the
+            // remaining polygon as it is. They are never ears themselves, and clipping ears tends to leave long
+            // runs of them behind that would otherwise have to be walked past again and again.
+            //
+            // Without reflex corners left, the remaining polygon is convex and every other corner is an ear
+            if (turn == 0.0 || (turn > 0.0 && (reflexCount == 0 || IsEar(m_Prev[corner], corner, m_Next[corner]))))
+            {
+                // Skipping a corner before looking for the next ear spreads the clipping around the polygon.
+                // Trying `next` right away would fan out from `prev`, into ever longer triangles
+                corner = m_Next[clip(corner)];
+                remaining--;
+                stepsWithoutEar = 0;
+                continue;
+            }
+
+            corner = m_Next[corner];
+            if (++stepsWithoutEar <= remaining)
+                continue;
+
+            // A whole lap without an ear, so the polygon is self-intersecting or numerically degenerate. Clip the
+            // first corner that is not reflex, or failing that, any corner. This always makes progress
+            uint32_t fallback = corner;
+            for (uint32_t c = m_Next[corner]; c != corner; c = m_Next[c])
+            {
+                if (!m_Reflex[c])
+                {
+                    fallback = c;
+                    break;
+                }
+            }
+
+            corner = m_Next[clip(fallback)];
+            remaining--;
+            stepsWithoutEar = 0;
+        }
+
+        triangles.insert(triangles.end(), { m_Prev[corner], corner, m_Next[corner] });
+    }
+}
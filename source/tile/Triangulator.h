@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace Tile
+{
+    // Triangulates the polygons of .obj faces.
+    //
+    // When every corner of the polygon is visible from the first one (which includes every convex polygon) the
+    // polygon is simply fanned out from its first corner. Anything else is projected onto the axis plane it is
+    // most aligned with and ear clipped. Only reflex corners can lie inside a candidate ear, and only the ones
+    // inside the ear's bounding box at that. The reflex corners are kept sorted along a Z-order curve, so an
+    // ear test is a range query that only visits the reflex corners in (or right around) the ear's bounding
+    // box, instead of every corner of the polygon. That keeps large concave faces at about O(n log n) instead
+    // of O(n^2).
+    //
+    // The triangles keep the winding order of the polygon. A polygon with N corners always produces N - 2
+    // triangles; self-intersecting or degenerate polygons still do, even though some of them might overlap.
+    //
+    // Not thread safe: it reuses its scratch buffers between calls, so use one instance per thread.
+    class Triangulator
+    {
+    public:
+        // Appends 3 corner indices (from 0 to count - 1) per triangle to `triangles`
+        void Triangulate(const glm::vec3* positions, size_t count, std::vector<uint32_t>& triangles);
+
+    private:
+        struct Point
+        {
+            double X, Y;
+        };
+
+        // Projects the polygon onto 2D, such that it winds counter clockwise
+        void Project(const glm::vec3* positions, size_t count);
+
+        bool CanFan(size_t count) const;
+
+        void EarClip(size_t count, std::vector<uint32_t>& triangles);
+
+        // Sorts the corners by their Z-order index, with the reflex ones live
+        void BuildZOrder(size_t count);
+        uint32_t QuantizeX(double x) const;
+        uint32_t QuantizeY(double y) const;
+
+        // The first live (reflex) corner at or after `rank` in Z-order, or the corner count if there is none
+        uint32_t FindLive(uint32_t rank);
+        void RemoveReflex(uint32_t corner);
+
+        bool IsEar(uint32_t prev, uint32_t ear, uint32_t next);
+        bool IsReflex(uint32_t corner) const;
+
+    private:
+        std::vector<Point> m_Points;
+
+        // The remaining polygon during ear clipping, as a circular doubly linked list
+        std::vector<uint32_t> m_Prev;
+        std::vector<uint32_t> m_Next;
+        std::vector<uint8_t> m_Reflex;
+
+        // Every corner sorted by Z-order index, and the rank of every corner in that order
+        std::vector<uint64_t> m_SortKeys;
+        std::vector<uint32_t> m_SortedZ;
+        std::vector<uint32_t> m_SortedCorners;
+        std::vector<uint32_t> m_Rank;
+
+        // Points every rank at the next rank with a live corner (union-find style, with path halving)
+        std::vector<uint32_t> m_NextLive;
+
+        double m_MinX = 0.0, m_MinY = 0.0;
+        double m_InvSize = 0.0;
+    };
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace Tile
+{
+    // 64 bit FNV-1a
+    constexpr uint64_t HashUniformName(std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : name)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    // A uniform's name and its hash. Made with the _uniform literal the hash is computed at compile time, so
+    // looking the uniform up costs no hashing (and no std::string) at run time
+    struct UniformName
+    {
+        uint64_t Hash;
+
+        // For error messages
+        const char* Text;
+    };
+
+    constexpr UniformName operator""_uniform(const char* text, size_t length)
+    {
+        return { HashUniformName(std::string_view(text, length)), text };
+    }
+
+    // The GL type a uniform has to be declared with to be set from a T (the values of GL's enums, so that this
+    // header does not need GL)
+    template <typename T> struct UniformType;
+    template <> struct UniformType<int>         { static constexpr uint32_t GL_TYPE = 0x1404; };
+    template <> struct UniformType<float>       { static constexpr uint32_t GL_TYPE = 0x1406; };
+    template <> struct UniformType<glm::vec2>   { static constexpr uint32_t GL_TYPE = 0x8B50; };
+    template <> struct UniformType<glm::vec3>   { static constexpr uint32_t GL_TYPE = 0x8B51; };
+    template <> struct UniformType<glm::vec4>   { static constexpr uint32_t GL_TYPE = 0x8B52; };
+    template <> struct UniformType<glm::mat3>   { static constexpr uint32_t GL_TYPE = 0x8B5B; };
+    template <> struct UniformType<glm::mat4>   { static constexpr uint32_t GL_TYPE = 0x8B5C; };
+
+    // A uniform of one particular shader, resolved once with Shader::GetUniform() and then set with
+    // Shader::SetUniform() as often as needed without any lookup. Invalid if the shader has no such uniform
+    // (e.g the compiler optimized it out) or it is not of type T, setting it is a no-op then
+    template <typename T>
+    struct UniformHandle
+    {
+        int Location = -1;
+
+        // Where the shader keeps its copy of the value
+        uint32_t ValueOffset = 0;
+        uint32_t ValueSize = 0;
+
+        inline bool IsValid() const { return Location >= 0; }
+    };
+}
@@ -0,0 +1,136 @@
+#include "tile/VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    uint32_t pack_snorm10(float value)
+    {
+        int32_t quantized = static_cast<int32_t>(std::lround(std::clamp(value, -1.f, 1.f) * 511.f));
+        return static_cast<uint32_t>(quantized) & 0x3FF;
+    }
+}
+
+namespace Tile
+{
+    const VertexLayout QUANTIZED_VERTEX_LAYOUT = {
+        {0, "ia_Pos",       4, VertAttribComponentType::UShort,             true },
+        {1, "ia_Normal",    4, VertAttribComponentType::Int2_10_10_10_Rev,  true },
+        {2, "ia_TexCoords", 2, VertAttribComponentType::HalfFloat,          false},
+    };
+
+    QuantizedMesh QuantizeVertices(const Vertex* vertices, size_t count)
+    {
+        QuantizedMesh mesh;
+        if (count == 0)
+            return mesh;
+
+        glm::vec3 low = vertices[0].position;
+        glm::vec3 high = vertices[0].position;
+        for (size_t i = 1; i < count; i++)
+        {
+            low = glm::min(low, vertices[i].position);
+            high = glm::max(high, vertices[i].position);
+        }
+
+        // Flat axes keep a scale of 1, so that the transform stays invertible
+        glm::vec3 extent = high - low;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (extent[axis] <= 0.f)
+                extent[axis] = 1.f;
+        }
+
+        mesh.Dequantize = glm::mat4(1.f);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mesh.Dequantize[axis][axis] = extent[axis];
+            mesh.Dequantize[3][axis] = low[axis];
+        }
+
+        mesh.Vertices.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const Vertex& vertex = vertices[i];
+            QuantizedVertex& quantized = mesh.Vertices[i];
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                float normalized = (vertex.position[axis] - low[axis]) / extent[axis];
+                quantized.Position[axis] = static_cast<uint16_t>(std::lround(std::clamp(normalized, 0.f, 1.f) * 65535.f));
+            }
+            quantized.Position[3] = 0;
+
+            quantized.Normal = pack_snorm10(vertex.normal.x) |
+                               pack_snorm10(vertex.normal.y) << 10 |
+                               pack_snorm10(vertex.normal.z) << 20;
+
+            quantized.TextureCoords[0] = FloatToHalf(vertex.textureCoords.x);
+            quantized.TextureCoords[1] = FloatToHalf(vertex.textureCoords.y);
+        }
+
+        return mesh;
+    }
+
+    uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        // Infinities and NaNs, which stay NaNs
+        if (magnitude >= 0x7F800000)
+            return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+
+        // 65520 and up round to infinity
+        if (magnitude >= 0x477FF000)
+            return sign | 0x7C00;
+
+        // Below the smallest normal half (2^-14) the result is a multiple of 2^-24, and scaling by 2^24 is exact
+        if (magnitude < 0x38800000)
+        {
+            float absolute;
+            std::memcpy(&absolute, &magnitude, sizeof(absolute));
+            return sign | static_cast<uint16_t>(std::nearbyint(absolute * 16777216.f));
+        }
+
+        // Rebias the exponent from 127 to 15 and round away the 13 extra mantissa bits, ties to even. A carry
+        // out of the mantissa correctly bumps the exponent
+        uint32_t rebiased = magnitude - 0x38000000;
+        return sign | static_cast<uint16_t>((rebiased + 0x0FFF + ((rebiased >> 13) & 1)) >> 13);
+    }
+
+    float HalfToFloat(uint16_t half)
+    {
+        uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1F;
+        uint32_t mantissa = half & 0x3FF;
+
+        float magnitude;
+        if (exponent == 0)
+        {
+            magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        }
+        else if (exponent == 31)
+        {
+            magnitude = mantissa == 0 ? INFINITY : NAN;
+        }
+        else
+        {
+            uint32_t bits = (exponent + 112) << 23 | mantissa << 13;
+            std::memcpy(&magnitude, &bits, sizeof(magnitude));
+        }
+
+        uint32_t bits;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        bits |= sign;
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "tile/Model.h"
+#include "tile/gl_wrappers.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+namespace Tile
+{
+    // A Vertex in half the space, for uploading. Only the GPU reads it, through QUANTIZED_VERTEX_LAYOUT
+    struct QuantizedVertex
+    {
+        // Normalized unsigned shorts spanning the mesh's bounding box, see QuantizedMesh::Dequantize.
+        // The 4th one is padding that keeps the normal 4 byte aligned
+        uint16_t Position[4];
+
+        // Signed normalized 10:10:10:2 (GL_INT_2_10_10_10_REV), x in the lowest bits
+        uint32_t Normal;
+
+        // Half floats
+        uint16_t TextureCoords[2];
+    };
+
+    static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex is expected to be tightly packed");
+
+    // Same locations and names as the layout of full Vertex buffers, so shaders take either as they are
+    extern const VertexLayout QUANTIZED_VERTEX_LAYOUT;
+
+    struct QuantizedMesh
+    {
+        std::vector<QuantizedVertex> Vertices;
+
+        // Maps the normalized positions the vertex shader receives (0 to 1 on every axis) back to the model's
+        // space. It is a scale and a translation, so it goes in front of the model matrix, but normals must
+        // not be transformed by it
+        glm::mat4 Dequantize = glm::mat4(1.f);
+    };
+
+    QuantizedMesh QuantizeVertices(const Vertex* vertices, size_t count);
+
+    // Rounds to nearest even. Out of range values become infinities
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t half);
+}
@@ -1,4 +1,6 @@
 #include "tile/Window.h"
+#include "tile/gl_extensions.h"
+#include "tile/GlState.h"
 #include "tile/opengl_inc.h"
 
 #include <iostream>
@@ -37,6 +39,7 @@ namespace Tile {
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, m_WinProps.Visible ? GLFW_TRUE : GLFW_FALSE);
 
         // This `GLFW_X11_CLASS_NAME` straight up does not work....
         // but according to the documentation it should, unless I do not 
@@ -78,6 +81,11 @@ namespace Tile {
             // Throws an exception if OpenGL library could not be loaded
             gl::init();
             std::cout << "Using OpenGL Version: " << gl::glGetString(gl::GL_VERSION) << std::endl;
+
+            LoadGlExtensions();
+
+            // Nothing is known about a new context's state
+            GetGlState().Invalidate();
         }
         catch(const std::runtime_error& e)
         {
@@ -12,6 +12,9 @@ namespace Tile {
 
         const char* Title;
         const char* X11WinClass;
+
+        // Hidden windows still get a full OpenGL context, e.g for benchmarks rendering offscreen
+        bool Visible = true;
     };
 
     class Window 
@@ -0,0 +1,115 @@
+#include "tile/gl_extensions.h"
+
+#include <cstring>
+#include <iostream>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+namespace
+{
+    using namespace Tile;
+
+    GlExtensions s_Extensions;
+
+    bool is_version_at_least(int major, int minor)
+    {
+        gl::GLint contextMajor = 0, contextMinor = 0;
+        gl::glGetIntegerv(gl::GL_MAJOR_VERSION, &contextMajor);
+        gl::glGetIntegerv(gl::GL_MINOR_VERSION, &contextMinor);
+
+        return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+    }
+
+    // Null if the context does not have it
+    template <typename Function>
+    bool load_function(Function& function, const char* name)
+    {
+        function = reinterpret_cast<Function>(glfwGetProcAddress(name));
+        return function != nullptr;
+    }
+}
+
+namespace Tile
+{
+    void LoadGlExtensions()
+    {
+        s_Extensions = GlExtensions();
+
+        if (is_version_at_least(4, 3) || IsGlExtensionSupported("GL_ARB_multi_draw_indirect"))
+        {
+            s_Extensions.MultiDrawIndirect = load_function(s_Extensions.glMultiDrawElementsIndirect,
+                                                           "glMultiDrawElementsIndirect");
+        }
+
+        if (is_version_at_least(4, 4) || IsGlExtensionSupported("GL_ARB_buffer_storage"))
+            s_Extensions.BufferStorage = load_function(s_Extensions.glBufferStorage, "glBufferStorage");
+
+        if (is_version_at_least(4, 5) || IsGlExtensionSupported("GL_ARB_direct_state_access"))
+        {
+            GlExtensions& e = s_Extensions;
+            bool loaded = true;
+
+            loaded &= load_function(e.glCreateBuffers, "glCreateBuffers");
+            loaded &= load_function(e.glNamedBufferData, "glNamedBufferData");
+            loaded &= load_function(e.glNamedBufferSubData, "glNamedBufferSubData");
+            loaded &= load_function(e.glCopyNamedBufferSubData, "glCopyNamedBufferSubData");
+
+            loaded &= load_function(e.glCreateVertexArrays, "glCreateVertexArrays");
+            loaded &= load_function(e.glVertexArrayVertexBuffer, "glVertexArrayVertexBuffer");
+            loaded &= load_function(e.glVertexArrayElementBuffer, "glVertexArrayElementBuffer");
+            loaded &= load_function(e.glEnableVertexArrayAttrib, "glEnableVertexArrayAttrib");
+            loaded &= load_function(e.glVertexArrayAttribFormat, "glVertexArrayAttribFormat");
+            loaded &= load_function(e.glVertexArrayAttribIFormat, "glVertexArrayAttribIFormat");
+            loaded &= load_function(e.glVertexArrayAttribBinding, "glVertexArrayAttribBinding");
+            loaded &= load_function(e.glVertexArrayBindingDivisor, "glVertexArrayBindingDivisor");
+
+            loaded &= load_function(e.glCreateTextures, "glCreateTextures");
+            loaded &= load_function(e.glTextureStorage2D, "glTextureStorage2D");
+            loaded &= load_function(e.glTextureSubImage2D, "glTextureSubImage2D");
+            loaded &= load_function(e.glTextureParameteri, "glTextureParameteri");
+            loaded &= load_function(e.glBindTextureUnit, "glBindTextureUnit");
+            loaded &= load_function(e.glTextureBuffer, "glTextureBuffer");
+
+            s_Extensions.DirectStateAccess = loaded;
+        }
+
+        if (IsGlExtensionSupported("GL_KHR_parallel_shader_compile"))
+        {
+            s_Extensions.ParallelShaderCompile = load_function(s_Extensions.glMaxShaderCompilerThreadsKHR,
+                                                               "glMaxShaderCompilerThreadsKHR");
+        }
+        else if (IsGlExtensionSupported("GL_ARB_parallel_shader_compile"))
+        {
+            s_Extensions.ParallelShaderCompile = load_function(s_Extensions.glMaxShaderCompilerThreadsKHR,
+                                                               "glMaxShaderCompilerThreadsARB");
+        }
+
+        // As many threads as the driver wants to use (some default to none until asked)
+        if (s_Extensions.ParallelShaderCompile)
+            s_Extensions.glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+
+        if (!s_Extensions.MultiDrawIndirect)
+            std::cout << "[INFO] No glMultiDrawElementsIndirect, indirect draws are issued one by one" << std::endl;
+    }
+
+    const GlExtensions& GetGlExtensions()
+    {
+        return s_Extensions;
+    }
+
+    bool IsGlExtensionSupported(const char* name)
+    {
+        gl::GLint count = 0;
+        gl::glGetIntegerv(gl::GL_NUM_EXTENSIONS, &count);
+
+        for (gl::GLint i = 0; i < count; i++)
+        {
+            const char* extension = reinterpret_cast<const char*>(gl::glGetStringi(gl::GL_EXTENSIONS, i));
+            if (extension != nullptr && std::strcmp(extension, name) == 0)
+                return true;
+        }
+
+        return false;
+    }
+}
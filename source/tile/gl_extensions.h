@@ -0,0 +1,94 @@
+#pragma once
+
+#include "tile/opengl_inc.h"
+
+// slam.h undefines APIENTRY once it is done with it
+#ifdef _WIN32
+    #define TILE_GL_APIENTRY __stdcall
+#else
+    #define TILE_GL_APIENTRY
+#endif
+
+// Enums of the extensions below, missing from the 4.2 headers
+namespace gl
+{
+    // GL_ARB_buffer_storage
+    constexpr GLbitfield GL_MAP_PERSISTENT_BIT                      = 0x0040;
+    constexpr GLbitfield GL_MAP_COHERENT_BIT                        = 0x0080;
+    constexpr GLbitfield GL_DYNAMIC_STORAGE_BIT                     = 0x0100;
+    constexpr GLbitfield GL_CLIENT_STORAGE_BIT                      = 0x0200;
+
+    // GL_KHR_parallel_shader_compile (and GL_ARB_parallel_shader_compile, same values)
+    constexpr GLenum GL_MAX_SHADER_COMPILER_THREADS_KHR             = 0x91B0;
+    constexpr GLenum GL_COMPLETION_STATUS_KHR                       = 0x91B1;
+}
+
+namespace Tile
+{
+    // OpenGL functionality past the 4.2 core profile SLAM loads. All of it is optional, so check the flag
+    // before calling any of the functions (they are null when unsupported)
+    struct GlExtensions
+    {
+        // GL_ARB_multi_draw_indirect, core since 4.3
+        bool MultiDrawIndirect = false;
+        void (TILE_GL_APIENTRY* glMultiDrawElementsIndirect)(gl::GLenum mode, gl::GLenum type, const void* indirect,
+                                                             gl::GLsizei drawCount, gl::GLsizei stride) = nullptr;
+
+        // GL_ARB_buffer_storage, core since 4.4. Immutable buffers that can stay mapped while the GPU uses them
+        bool BufferStorage = false;
+        void (TILE_GL_APIENTRY* glBufferStorage)(gl::GLenum target, gl::GLsizeiptr size, const void* data,
+                                                 gl::GLbitfield flags) = nullptr;
+
+        // GL_ARB_direct_state_access, core since 4.5. Lets the wrappers create and edit objects without binding
+        // them (which is only set when every function below could be loaded)
+        bool DirectStateAccess = false;
+        void (TILE_GL_APIENTRY* glCreateBuffers)(gl::GLsizei count, gl::GLuint* buffers) = nullptr;
+        void (TILE_GL_APIENTRY* glNamedBufferData)(gl::GLuint buffer, gl::GLsizeiptr size, const void* data,
+                                                   gl::GLenum usage) = nullptr;
+        void (TILE_GL_APIENTRY* glNamedBufferSubData)(gl::GLuint buffer, gl::GLintptr offset, gl::GLsizeiptr size,
+                                                      const void* data) = nullptr;
+        void (TILE_GL_APIENTRY* glCopyNamedBufferSubData)(gl::GLuint readBuffer, gl::GLuint writeBuffer,
+                                                          gl::GLintptr readOffset, gl::GLintptr writeOffset,
+                                                          gl::GLsizeiptr size) = nullptr;
+
+        void (TILE_GL_APIENTRY* glCreateVertexArrays)(gl::GLsizei count, gl::GLuint* arrays) = nullptr;
+        void (TILE_GL_APIENTRY* glVertexArrayVertexBuffer)(gl::GLuint vertexArray, gl::GLuint bindingIndex,
+                                                           gl::GLuint buffer, gl::GLintptr offset,
+                                                           gl::GLsizei stride) = nullptr;
+        void (TILE_GL_APIENTRY* glVertexArrayElementBuffer)(gl::GLuint vertexArray, gl::GLuint buffer) = nullptr;
+        void (TILE_GL_APIENTRY* glEnableVertexArrayAttrib)(gl::GLuint vertexArray, gl::GLuint index) = nullptr;
+        void (TILE_GL_APIENTRY* glVertexArrayAttribFormat)(gl::GLuint vertexArray, gl::GLuint attribIndex,
+                                                           gl::GLint size, gl::GLenum type, gl::GLboolean normalized,
+                                                           gl::GLuint relativeOffset) = nullptr;
+        void (TILE_GL_APIENTRY* glVertexArrayAttribIFormat)(gl::GLuint vertexArray, gl::GLuint attribIndex,
+                                                            gl::GLint size, gl::GLenum type,
+                                                            gl::GLuint relativeOffset) = nullptr;
+        void (TILE_GL_APIENTRY* glVertexArrayAttribBinding)(gl::GLuint vertexArray, gl::GLuint attribIndex,
+                                                            gl::GLuint bindingIndex) = nullptr;
+        void (TILE_GL_APIENTRY* glVertexArrayBindingDivisor)(gl::GLuint vertexArray, gl::GLuint bindingIndex,
+                                                             gl::GLuint divisor) = nullptr;
+
+        void (TILE_GL_APIENTRY* glCreateTextures)(gl::GLenum target, gl::GLsizei count, gl::GLuint* textures) = nullptr;
+        void (TILE_GL_APIENTRY* glTextureStorage2D)(gl::GLuint texture, gl::GLsizei levels, gl::GLenum internalFormat,
+                                                    gl::GLsizei width, gl::GLsizei height) = nullptr;
+        void (TILE_GL_APIENTRY* glTextureSubImage2D)(gl::GLuint texture, gl::GLint level, gl::GLint x, gl::GLint y,
+                                                     gl::GLsizei width, gl::GLsizei height, gl::GLenum format,
+                                                     gl::GLenum type, const void* pixels) = nullptr;
+        void (TILE_GL_APIENTRY* glTextureParameteri)(gl::GLuint texture, gl::GLenum name, gl::GLint value) = nullptr;
+        void (TILE_GL_APIENTRY* glBindTextureUnit)(gl::GLuint unit, gl::GLuint texture) = nullptr;
+        void (TILE_GL_APIENTRY* glTextureBuffer)(gl::GLuint texture, gl::GLenum format, gl::GLuint buffer) = nullptr;
+
+        // GL_KHR_parallel_shader_compile or the ARB version of it. Compiles and links on the driver's threads,
+        // GL_COMPLETION_STATUS_KHR tells whether a shader or program is done without waiting for it
+        bool ParallelShaderCompile = false;
+        void (TILE_GL_APIENTRY* glMaxShaderCompilerThreadsKHR)(gl::GLuint count) = nullptr;
+    };
+
+    // Loads whatever the current context supports. Called by Window::InitGl() after gl::init()
+    void LoadGlExtensions();
+
+    const GlExtensions& GetGlExtensions();
+
+    // Whether `name` is in the context's extension list
+    bool IsGlExtensionSupported(const char* name);
+}
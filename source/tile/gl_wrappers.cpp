@@ -1,6 +1,9 @@
 #include "tile/gl_wrappers.h"
+#include "tile/gl_extensions.h"
+#include "tile/GlState.h"
 #include "tile/opengl_inc.h"
 
+#include <cstdint>
 #include <iostream>
 
 using namespace gl;
@@ -16,12 +19,30 @@ namespace
             return sizeof(float);
         case VertAttribComponentType::Int:
             return sizeof(int);
+        case VertAttribComponentType::UInt:
+            return sizeof(uint32_t);
+        case VertAttribComponentType::HalfFloat:
+        case VertAttribComponentType::Short:
+        case VertAttribComponentType::UShort:
+            return sizeof(uint16_t);
+        case VertAttribComponentType::Byte:
+        case VertAttribComponentType::UByte:
+            return sizeof(uint8_t);
 
         default:
             return 0;
         }
     }
 
+    int elem_byte_count(const VLayoutElement& elem)
+    {
+        // All the components share one 32 bit word
+        if (elem.ComponentType == VertAttribComponentType::Int2_10_10_10_Rev)
+            return sizeof(uint32_t);
+
+        return elem.VecComponentCount * comp_type_byte_count(elem.ComponentType);
+    }
+
     int comp_to_gl_type(VertAttribComponentType type)
     {
         switch(type)
@@ -30,11 +51,68 @@ namespace
             return GL_FLOAT;
         case VertAttribComponentType::Int:
             return GL_INT;
+        case VertAttribComponentType::HalfFloat:
+            return GL_HALF_FLOAT;
+        case VertAttribComponentType::Short:
+            return GL_SHORT;
+        case VertAttribComponentType::UShort:
+            return GL_UNSIGNED_SHORT;
+        case VertAttribComponentType::Byte:
+            return GL_BYTE;
+        case VertAttribComponentType::UByte:
+            return GL_UNSIGNED_BYTE;
+        case VertAttribComponentType::Int2_10_10_10_Rev:
+            return GL_INT_2_10_10_10_REV;
+        case VertAttribComponentType::UInt:
+            return GL_UNSIGNED_INT;
 
         default:
             return -1;
         }
     }
+
+    // The direct state access functions, or null if the context has none and objects have to be bound to be
+    // created and edited
+    const GlExtensions* direct_state_access()
+    {
+        const GlExtensions& extensions = GetGlExtensions();
+        return extensions.DirectStateAccess ? &extensions : nullptr;
+    }
+
+    uint create_buffer()
+    {
+        uint id;
+        if (const GlExtensions* dsa = direct_state_access())
+            dsa->glCreateBuffers(1, &id);
+        else
+            glGenBuffers(1, &id);
+
+        return id;
+    }
+
+    void set_buffer_data(uint id, GLenum bindTarget, const void* data, int size, int usage)
+    {
+        if (const GlExtensions* dsa = direct_state_access())
+        {
+            dsa->glNamedBufferData(id, size, data, usage);
+            return;
+        }
+
+        GetGlState().BindBuffer(bindTarget, id);
+        glBufferData(bindTarget, size, data, usage);
+    }
+
+    void set_buffer_sub_data(uint id, const void* data, int offset, int size)
+    {
+        if (const GlExtensions* dsa = direct_state_access())
+        {
+            dsa->glNamedBufferSubData(id, offset, size, data);
+            return;
+        }
+
+        GetGlState().BindBuffer(GL_COPY_WRITE_BUFFER, id);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    }
 }
 
 namespace Tile
@@ -49,22 +127,23 @@ namespace Tile
 
     VertexBuffer::VertexBuffer()
     {
-        glGenBuffers(1, &m_BufId);
+        m_BufId = create_buffer();
     }
 
     VertexBuffer::~VertexBuffer()
     {
+        GetGlState().OnBufferDeleted(m_BufId);
         glDeleteBuffers(1, &m_BufId);
         m_BufId = 0;
     }
 
     void VertexBuffer::Bind() const
     {
-        glBindBuffer(GL_ARRAY_BUFFER, m_BufId);
+        GetGlState().BindBuffer(GL_ARRAY_BUFFER, m_BufId);
     }
     void VertexBuffer::Unbind() const
     {
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GetGlState().BindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
     void VertexBuffer::SetData(const void* data, int size)
@@ -74,8 +153,12 @@ namespace Tile
 
     void VertexBuffer::SetData(const void* data, int size, int usage)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, m_BufId);
-        glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+        set_buffer_data(m_BufId, GL_ARRAY_BUFFER, data, size, usage);
+    }
+
+    void VertexBuffer::SetSubData(const void* data, int offset, int size)
+    {
+        set_buffer_sub_data(m_BufId, data, offset, size);
     }
 
 
@@ -87,22 +170,23 @@ namespace Tile
 
     IndexBuffer::IndexBuffer()
     {
-        glGenBuffers(1, &m_BufId);
+        m_BufId = create_buffer();
     }
 
     IndexBuffer::~IndexBuffer()
     {
+        GetGlState().OnBufferDeleted(m_BufId);
         glDeleteBuffers(1, &m_BufId);
         m_BufId = 0;
     }
 
     void IndexBuffer::Bind() const
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BufId);
+        GetGlState().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BufId);
     }
     void IndexBuffer::Unbind() const
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        GetGlState().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
     void IndexBuffer::SetIndices(const uint* data, int size)
@@ -112,8 +196,34 @@ namespace Tile
 
     void IndexBuffer::SetIndices(const uint* data, int size, int usage)
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BufId);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, usage);
+        set_buffer_data(m_BufId, GL_ELEMENT_ARRAY_BUFFER, data, size, usage);
+        m_IndexType = IndexType::UInt32;
+    }
+
+    void IndexBuffer::SetIndices(const uint16_t* data, int size)
+    {
+        SetIndices(data, size, GL_STATIC_DRAW);
+    }
+
+    void IndexBuffer::SetIndices(const uint16_t* data, int size, int usage)
+    {
+        set_buffer_data(m_BufId, GL_ELEMENT_ARRAY_BUFFER, data, size, usage);
+        m_IndexType = IndexType::UInt16;
+    }
+
+    void IndexBuffer::SetSubData(const void* data, int offset, int size)
+    {
+        set_buffer_sub_data(m_BufId, data, offset, size);
+    }
+
+    int IndexBuffer::GetIndexSize() const
+    {
+        return m_IndexType == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    int IndexBuffer::GetGLIndexType() const
+    {
+        return m_IndexType == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
     }
 
     /* ============================================================= */
@@ -124,60 +234,123 @@ namespace Tile
 
     VertexArray::VertexArray()
     {
-        glGenVertexArrays(1, &m_VaoId);
+        if (const GlExtensions* dsa = direct_state_access())
+            dsa->glCreateVertexArrays(1, &m_VaoId);
+        else
+            glGenVertexArrays(1, &m_VaoId);
     }
 
     VertexArray::~VertexArray()
     {
+        GetGlState().OnVertexArrayDeleted(m_VaoId);
         glDeleteVertexArrays(1, &m_VaoId);
         m_VaoId = 0;
     }
 
     void VertexArray::Bind() const
     {
-        glBindVertexArray(m_VaoId);
+        GetGlState().BindVertexArray(m_VaoId);
     }
     void VertexArray::Unbind() const
     {
-        glBindVertexArray(0);
+        GetGlState().BindVertexArray(0);
     }
 
     void VertexArray::AddVertexBuffer(const VertexBuffer& buffer, const VertexLayout& layout)
     {
-        glBindVertexArray(m_VaoId);
-        buffer.Bind();
-
         int stride = 0;
 
         for(auto& elem : layout)
         {
-            stride += elem.VecComponentCount * comp_type_byte_count(elem.ComponentType);
+            stride += elem_byte_count(elem);
+        }
+
+        if (const GlExtensions* dsa = direct_state_access())
+        {
+            AddVertexBufferDirect(*dsa, buffer, layout, stride);
+            return;
         }
 
+        GetGlState().BindVertexArray(m_VaoId);
+        buffer.Bind();
+
         int currentOffset = 0;
 
         for(const VLayoutElement& elem : layout)
         {
-            glEnableVertexAttribArray(elem.LayoutIndex);
-            glVertexAttribPointer(elem.LayoutIndex,
-                                  elem.VecComponentCount,
-                                  comp_to_gl_type(elem.ComponentType),
-                                  elem.Normalize ? GL_TRUE : GL_FALSE,
-                                  stride,
-
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wint-to-void-pointer-cast"
-                                  (void*)currentOffset
+            const void* offset = (void*)currentOffset;
 #pragma clang diagnostic pop
 
-            );
-            currentOffset += elem.VecComponentCount * comp_type_byte_count(elem.ComponentType);
+            glEnableVertexAttribArray(elem.LayoutIndex);
+
+            if (elem.ComponentType == VertAttribComponentType::UInt)
+            {
+                glVertexAttribIPointer(elem.LayoutIndex,
+                                       elem.VecComponentCount,
+                                       comp_to_gl_type(elem.ComponentType),
+                                       stride,
+                                       offset);
+            }
+            else
+            {
+                glVertexAttribPointer(elem.LayoutIndex,
+                                      elem.VecComponentCount,
+                                      comp_to_gl_type(elem.ComponentType),
+                                      elem.Normalize ? GL_TRUE : GL_FALSE,
+                                      stride,
+                                      offset);
+            }
+
+            glVertexAttribDivisor(elem.LayoutIndex, elem.InstanceDivisor);
+            currentOffset += elem_byte_count(elem);
         }
     }
 
     void VertexArray::AddIndexBuffer(const IndexBuffer& buffer)
     {
-        glBindVertexArray(m_VaoId);
+        if (const GlExtensions* dsa = direct_state_access())
+        {
+            dsa->glVertexArrayElementBuffer(m_VaoId, buffer.GetID());
+            return;
+        }
+
+        GetGlState().BindVertexArray(m_VaoId);
         buffer.Bind();
     }
+
+    void VertexArray::AddVertexBufferDirect(const GlExtensions& dsa, const VertexBuffer& buffer,
+                                            const VertexLayout& layout, int stride)
+    {
+        if (layout.empty())
+            return;
+
+        // Adding the same layout again (e.g with a grown buffer) replaces the buffer of its binding
+        uint binding = layout.front().LayoutIndex;
+        dsa.glVertexArrayVertexBuffer(m_VaoId, binding, buffer.GetID(), 0, stride);
+        dsa.glVertexArrayBindingDivisor(m_VaoId, binding, layout.front().InstanceDivisor);
+
+        int currentOffset = 0;
+
+        for(const VLayoutElement& elem : layout)
+        {
+            dsa.glEnableVertexArrayAttrib(m_VaoId, elem.LayoutIndex);
+
+            if (elem.ComponentType == VertAttribComponentType::UInt)
+            {
+                dsa.glVertexArrayAttribIFormat(m_VaoId, elem.LayoutIndex, elem.VecComponentCount,
+                                               comp_to_gl_type(elem.ComponentType), currentOffset);
+            }
+            else
+            {
+                dsa.glVertexArrayAttribFormat(m_VaoId, elem.LayoutIndex, elem.VecComponentCount,
+                                              comp_to_gl_type(elem.ComponentType),
+                                              elem.Normalize ? GL_TRUE : GL_FALSE, currentOffset);
+            }
+
+            dsa.glVertexArrayAttribBinding(m_VaoId, elem.LayoutIndex, binding);
+            currentOffset += elem_byte_count(elem);
+        }
+    }
 }
\ No newline at end of file
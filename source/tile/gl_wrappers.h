@@ -1,11 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <initializer_list>
 #include <string>
 #include <vector>
 
 namespace Tile
 {
+    struct GlExtensions;
 
     /* ==================================================================== */
     /* ==================================================================== */
@@ -16,7 +18,22 @@ namespace Tile
     enum class VertAttribComponentType // "vec"3, "ivec"2, etc
     {
         Float,
-        Int
+        Int,
+
+        // The compressed types below are read as floats by the shader. With `Normalize` set the integer ones
+        // are mapped to [0, 1] (unsigned) or [-1, 1] (signed), otherwise they are converted as they are
+        HalfFloat,
+        Short,
+        UShort,
+        Byte,
+        UByte,
+
+        // 3 signed 10 bit components and a 2 bit one packed into 4 bytes, x in the lowest bits.
+        // VecComponentCount must be 4
+        Int2_10_10_10_Rev,
+
+        // Read as an integer (uint, uvec2, ...) by the shader, through glVertexAttribIPointer. Normalize is ignored
+        UInt
     };
 
     struct VLayoutElement
@@ -26,6 +43,11 @@ namespace Tile
         int VecComponentCount; // number of components (i.e 4 for vec4) or 1 in case of float, int, etc
         VertAttribComponentType ComponentType;
         bool Normalize;
+
+        // 0 advances the attribute once per vertex, N once every N instances (glVertexAttribDivisor).
+        // Instanced attributes start at the draw's base instance. The elements of a layout share a buffer,
+        // so they are expected to share the divisor too
+        uint32_t InstanceDivisor = 0;
     };
     using VertexLayout = std::vector<VLayoutElement>;
 
@@ -48,6 +70,11 @@ namespace Tile
         void SetData(const void* data, int size);
         void SetData(const void* data, int size, int usage);
 
+        // Overwrites part of the data. Goes through GL_COPY_WRITE_BUFFER, so no binding is disturbed
+        void SetSubData(const void* data, int offset, int size);
+
+        inline uint GetID() const { return m_BufId; }
+
     private:
         uint m_BufId;
     };
@@ -58,6 +85,12 @@ namespace Tile
     /* ============================================================= */
     /* ============================================================= */
 
+    enum class IndexType
+    {
+        UInt16,
+        UInt32
+    };
+
     class IndexBuffer
     {
     public:
@@ -70,8 +103,25 @@ namespace Tile
         void SetIndices(const uint* indices, int size);
         void SetIndices(const uint* indices, int size, int usage);
 
+        void SetIndices(const uint16_t* indices, int size);
+        void SetIndices(const uint16_t* indices, int size, int usage);
+
+        // Overwrites part of the indices, `offset` and `size` in bytes. Goes through GL_COPY_WRITE_BUFFER,
+        // so that the element buffer of whatever vertex array is bound stays as it is
+        void SetSubData(const void* data, int offset, int size);
+
+        inline uint GetID() const { return m_BufId; }
+
+        // The type of the last indices set
+        inline IndexType GetIndexType() const { return m_IndexType; }
+        int GetIndexSize() const;
+
+        // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, for the draw calls
+        int GetGLIndexType() const;
+
     private:
         uint m_BufId;
+        IndexType m_IndexType = IndexType::UInt32;
     };
 
     /* ============================================================= */
@@ -89,9 +139,15 @@ namespace Tile
         void Bind() const;
         void Unbind() const;
 
+        // With direct state access these leave the bound vertex array alone, otherwise they bind this one
         void AddVertexBuffer(const VertexBuffer& buffer, const VertexLayout& layout);
         void AddIndexBuffer(const IndexBuffer& buffer);
 
+    private:
+        // Each layout gets its own buffer binding, the one of its first element's location
+        void AddVertexBufferDirect(const GlExtensions& dsa, const VertexBuffer& buffer, const VertexLayout& layout,
+                                   int stride);
+
     private:
         uint m_VaoId;
     };
@@ -14,10 +14,42 @@ int main()
 #else
 
 #include "tests/load_model.inl"
+#include "tests/bench_obj_loading.inl"
+#include "tests/bench_mesh_cache.inl"
+#include "tests/bench_vertex_dedup.inl"
+#include "tests/bench_space_conversion.inl"
+#include "tests/bench_triangulator.inl"
+#include "tests/bench_mesh_optimizer.inl"
+#include "tests/bench_overdraw.inl"
+#include "tests/bench_vertex_formats.inl"
+#include "tests/bench_batch_rendering.inl"
+#include "tests/bench_instancing.inl"
+#include "tests/bench_stream_buffer.inl"
+#include "tests/bench_state_cache.inl"
+#include "tests/bench_render_queue.inl"
+#include "tests/bench_uniforms.inl"
+#include "tests/bench_program_cache.inl"
+#include "tests/bench_shader_compile.inl"
 
 int main()
 {   
     load_model_test_main();
+    // bench_obj_loading_main();
+    // bench_mesh_cache_main();
+    // bench_vertex_dedup_main();
+    // bench_space_conversion_main();
+    // bench_triangulator_main();
+    // bench_mesh_optimizer_main();
+    // bench_overdraw_main();
+    // bench_vertex_formats_main();
+    // bench_batch_rendering_main();
+    // bench_instancing_main();
+    // bench_stream_buffer_main();
+    // bench_state_cache_main();
+    // bench_render_queue_main();
+    // bench_uniforms_main();
+    // bench_program_cache_main();
+    // bench_shader_compile_main();
 }
 
 #endif
\ No newline at end of file